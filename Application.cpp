@@ -26,11 +26,23 @@ void handler(int sig) {
  **********************************/
 int main(int argc, char *argv[]) {
 	//signal(SIGSEGV, handler);
-	if ( argc != ARGS_COUNT ) {
+	if ( argc != ARGS_COUNT && argc != ARGS_COUNT + 1 ) {
 		cout<<"Configuration (i.e., *.conf) file File Required"<<endl;
 		return FAILURE;
 	}
 
+	// Run every node in a process of its own
+	if ( argc == ARGS_COUNT + 1 ) {
+		if ( 0 == strcmp(argv[2], "udp") ) {
+			return Application::launch(argv[1], UDP_TRANSPORT);
+		}
+		if ( 0 == strcmp(argv[2], "shm") ) {
+			return Application::launch(argv[1], SHM_TRANSPORT);
+		}
+		cout<<"Unknown transport "<<argv[2]<<", expected udp or shm"<<endl;
+		return FAILURE;
+	}
+
 	// Create a new application object
 	Application *app = new Application(argv[1]);
 	// Call the run function
@@ -43,15 +55,29 @@ int main(int argc, char *argv[]) {
 
 /**
  * Constructor of the Application class
+ * With self set, only that node is reachable and run() must not be used
  */
-Application::Application(char *infile) {
+Application::Application(char *infile, int transport, int self) {
 	int i;
+	char name[SHM_NAME_LEN];
 	par = new Params();
 	srand (time(NULL));
 	par->setparams(infile);
+	this->self = self;
 	log = new Log(par);
-	en = new EmulNet(par);
-	en1 = new EmulNet(par);
+	switch ( transport ) {
+		case UDP_TRANSPORT:
+			en = new SockNet(par, self + 1, SOCK_BASE_PORT);
+			break;
+		case SHM_TRANSPORT:
+			// The region was made by the launcher, our parent
+			ShmNet::regionName(name, getppid(), 0);
+			en = new ShmNet(par, self + 1, name);
+			break;
+		default:
+			en = new EmulNet(par);
+			break;
+	}
 	mp1 = (MP1Node **) malloc(par->EN_GPSZ * sizeof(MP1Node *));
 	mp2 = (MP2Node **) malloc(par->EN_GPSZ * sizeof(MP2Node *));
 
@@ -66,7 +92,7 @@ Application::Application(char *infile) {
 		joinaddr = getjoinaddr();
 		addressOfMemberNode = (Address *) en->ENinit(addressOfMemberNode, par->PORTNUM);
 		mp1[i] = new MP1Node(memberNode, par, en, log, addressOfMemberNode);
-		mp2[i] = new MP2Node(memberNode, par, en1, log, addressOfMemberNode);
+		mp2[i] = new MP2Node(memberNode, par, en, log, addressOfMemberNode);
 		log->LOG(&(mp1[i]->getMemberNode()->addr), "APP");
 		log->LOG(&(mp2[i]->getMemberNode()->addr), "APP MP2");
 		delete addressOfMemberNode;
@@ -79,7 +105,6 @@ Application::Application(char *infile) {
 Application::~Application() {
 	delete log;
 	delete en;
-	delete en1;
 	for ( int i = 0; i < par->EN_GPSZ; i++ ) {
 		delete mp1[i];
 		delete mp2[i];
@@ -122,7 +147,6 @@ int Application::run()
 
 	// Clean up
 	en->ENcleanup();
-	en1->ENcleanup();
 
 	for(i=0;i<=par->EN_GPSZ-1;i++) {
 		 mp1[i]->finishUpThisNode();
@@ -131,6 +155,146 @@ int Application::run()
 	return SUCCESS;
 }
 
+/**
+ * FUNCTION NAME: launch
+ *
+ * DESCRIPTION: Runs every node in a process of its own, talking over transport.
+ * 				Node i runs in directory node<i>, which gets its logs. The nodes
+ * 				start their clocks together once all of them can be reached.
+ */
+int Application::launch(char *infile, int transport) {
+	Params params;
+	char conf[PATH_MAX];
+	char c = 0;
+	char name[SHM_NAME_LEN];
+	int ready[2], go[2];
+	int i, status, result = SUCCESS;
+	vector<pid_t> children;
+
+	if ( NULL == realpath(infile, conf) ) {
+		perror(infile);
+		return FAILURE;
+	}
+	params.setparams(conf);
+	if ( pipe(ready) < 0 || pipe(go) < 0 ) {
+		perror("pipe");
+		return FAILURE;
+	}
+	if ( SHM_TRANSPORT == transport ) {
+		ShmNet::regionName(name, getpid(), 0);
+		if ( ShmNet::createRegion(name, params.EN_GPSZ) != SUCCESS ) {
+			return FAILURE;
+		}
+	}
+	fflush(stdout);
+	cout.flush();
+
+	for ( i = 0; i < params.EN_GPSZ; i++ ) {
+		pid_t pid = fork();
+		if ( pid < 0 ) {
+			perror("fork");
+			result = FAILURE;
+			break;
+		}
+		if ( 0 == pid ) {
+			char dir[32];
+			close(ready[0]);
+			close(go[1]);
+			sprintf(dir, "node%d", i);
+			mkdir(dir, 0755);
+			if ( chdir(dir) < 0 ) {
+				perror(dir);
+				exit(FAILURE);
+			}
+			Application *app = new Application(conf, transport, i);
+			// Reachable now, wait for the others
+			if ( write(ready[1], &c, 1) != 1 || read(go[0], &c, 1) < 0 ) {
+				exit(FAILURE);
+			}
+			close(ready[1]);
+			close(go[0]);
+			app->runNode();
+			delete app;
+			exit(SUCCESS);
+		}
+		children.push_back(pid);
+	}
+
+	close(ready[1]);
+	close(go[0]);
+	for ( i = 0; i < (int)children.size() && read(ready[0], &c, 1) == 1; i++ ) {
+	}
+	close(ready[0]);
+	if ( SHM_TRANSPORT == transport ) {
+		// Every node has the region mapped, it goes away with the last one
+		shm_unlink(name);
+	}
+	// EOF on go starts every node
+	close(go[1]);
+
+	for ( i = 0; i < (int)children.size(); i++ ) {
+		if ( waitpid(children[i], &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != SUCCESS ) {
+			result = FAILURE;
+		}
+	}
+	return result;
+}
+
+/**
+ * FUNCTION NAME: runNode
+ *
+ * DESCRIPTION: Driver of a node running in a process of its own, a tick lasting
+ * 				TICK_USEC. Follows run() for node self: the KV store starts 50 ticks
+ * 				after the last node joined, the first node creates the test pairs
+ * 				at INSERT_TIME and reads them all back at TEST_TIME. The CRUD
+ * 				tests fail nodes of other processes and are not run.
+ */
+int Application::runNode() {
+	MP1Node *node1 = mp1[self];
+	MP2Node *node2 = mp2[self];
+	int startTime = (int)(par->STEP_RATE*self);
+	int kvStartTime = (int)(par->STEP_RATE*(par->EN_GPSZ - 1)) + 50;
+
+	for( par->globaltime = 0; par->globaltime < TOTAL_RUNNING_TIME; ++par->globaltime ) {
+		if( par->getcurrtime() == startTime ) {
+			node1->nodeStart(JOINADDR, par->PORTNUM);
+		}
+		else if( par->getcurrtime() > startTime ) {
+			node1->recvLoop();
+			node1->nodeLoop();
+		}
+
+		if ( par->getcurrtime() > kvStartTime ) {
+			if ( node2->getMemberNode()->inited && node2->getMemberNode()->inGroup ) {
+				node2->updateRing();
+			}
+			node2->recvLoop();
+			node2->checkMessages();
+
+			if ( 0 == self && par->getcurrtime() == INSERT_TIME ) {
+				initTestKVPairs();
+				for ( map<string, string>::iterator it = testKVPairs.begin(); it != testKVPairs.end(); ++it ) {
+					log->LOG(&node2->getMemberNode()->addr, "CREATE OPERATION KEY: %s VALUE: %s at time: %d", it->first.c_str(), it->second.c_str(), par->getcurrtime());
+					node2->clientCreate(it->first, it->second);
+				}
+			}
+			if ( 0 == self && par->getcurrtime() == TEST_TIME ) {
+				for ( map<string, string>::iterator it = testKVPairs.begin(); it != testKVPairs.end(); ++it ) {
+					log->LOG(&node2->getMemberNode()->addr, "READ OPERATION KEY: %s VALUE: %s at time: %d", it->first.c_str(), it->second.c_str(), par->getcurrtime());
+					node2->clientRead(it->first);
+				}
+			}
+		}
+
+		usleep(TICK_USEC);
+	}
+
+	en->ENcleanup();
+	node1->finishUpThisNode();
+
+	return SUCCESS;
+}
+
 /**
  * FUNCTION NAME: mp1Run
  *
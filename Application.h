@@ -13,10 +13,15 @@
 #include "Params.h"
 #include "Member.h"
 #include "EmulNet.h"
+#include "SockNet.h"
+#include "ShmNet.h"
 #include "Queue.h"
 #include "MP2Node.h"
 #include "Node.h"
 #include "common.h"
+#include <limits.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
 
 /**
  * global variables
@@ -40,6 +45,11 @@ static const char alphanum[] =
 #define RF 3
 #define NUMBER_OF_INSERTS 100
 #define KEY_LENGTH 5
+// Wall clock length of a tick when every node runs in its own process
+#define TICK_USEC 10000
+
+// networks the nodes can talk over
+enum transportTYPE { EMUL_TRANSPORT, UDP_TRANSPORT, SHM_TRANSPORT };
 
 /**
  * CLASS NAME: Application
@@ -51,19 +61,23 @@ private:
 	// Address for introduction to the group
 	// Coordinator Node
 	char JOINADDR[30];
+	// Carries both MP1 and MP2, each in traffic classes of its own
 	EmulNet *en;
-	EmulNet *en1;
     Log *log;
 	MP1Node **mp1;
 	MP2Node **mp2;
 	Params *par;
 	map<string, string> testKVPairs;
+	// Index of the only node this process runs, -1 if it runs all of them
+	int self;
 public:
-	Application(char *);
+	Application(char *infile, int transport = EMUL_TRANSPORT, int self = -1);
 	virtual ~Application();
+	static int launch(char *infile, int transport);
 	Address getjoinaddr();
 	void initTestKVPairs();
 	int run();
+	int runNode();
 	void mp1Run();
 	void mp2Run();
 	void fail();
@@ -0,0 +1,668 @@
+/**********************************
+ * FILE NAME: BoundedTable.cpp
+ *
+ * DESCRIPTION: BoundedTable class definition
+ **********************************/
+
+#include "BoundedTable.h"
+
+/**
+ * Constructor
+ * Creates the spill file at spillPath, replacing any
+ */
+BoundedTable::BoundedTable(const string &spillPath, size_t budget) {
+	this->spillPath = spillPath;
+	this->budget = budget;
+	target = 0;
+	keyBytes = valueBytes = 0;
+	spillEnd = spillDead = 0;
+	memset(&stats, 0, sizeof(stats));
+	for ( int i = 0; i < ARC_LISTS; i++ ) {
+		lists[i].head = lists[i].tail = BOUNDED_NIL;
+		lists[i].bytes = 0;
+	}
+	spillFd = open(spillPath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if ( spillFd < 0 ) {
+		perror(spillPath.c_str());
+		exit(1);
+	}
+}
+
+/**
+ * Destructor
+ * Removes the spill file
+ */
+BoundedTable::~BoundedTable() {
+	close(spillFd);
+	unlink(spillPath.c_str());
+}
+
+/**
+ * FUNCTION NAME: heapBytes
+ *
+ * DESCRIPTION: Bytes s asked of the allocator, 0 for a string short enough to be
+ * 				kept inside the string object
+ */
+size_t BoundedTable::heapBytes(const string &s) {
+	return s.capacity() > BOUNDED_SSO_CAPACITY ? s.capacity() + 1 : 0;
+}
+
+/**
+ * FUNCTION NAME: memory
+ *
+ * DESCRIPTION: Bytes the table takes
+ */
+size_t BoundedTable::memory() {
+	return index.bucket_count() * (sizeof(FlatHashMap<uint32_t>::value_type) + sizeof(uint32_t))
+		+ entries.capacity() * sizeof(CacheEntry) + freeIds.capacity() * sizeof(uint32_t)
+		+ keyBytes + valueBytes;
+}
+
+/**
+ * FUNCTION NAME: valueBudget
+ *
+ * DESCRIPTION: Bytes left for values once the keys and entries are counted, the
+ * 				size of the cache in ARC terms
+ */
+size_t BoundedTable::valueBudget() {
+	size_t fixed = memory() - valueBytes;
+	return budget > fixed ? budget - fixed : 0;
+}
+
+/**
+ * FUNCTION NAME: listAdd
+ *
+ * DESCRIPTION: Puts entry id at the head of list
+ */
+void BoundedTable::listAdd(uint32_t id, int list) {
+	CacheEntry &entry = entries[id];
+	ArcList &l = lists[list];
+
+	entry.list = list;
+	entry.prev = BOUNDED_NIL;
+	entry.next = l.head;
+	if ( BOUNDED_NIL != l.head ) {
+		entries[l.head].prev = id;
+	}
+	else {
+		l.tail = id;
+	}
+	l.head = id;
+	l.bytes += entry.size;
+}
+
+/**
+ * FUNCTION NAME: listRemove
+ *
+ * DESCRIPTION: Takes entry id out of its list, if in one
+ */
+void BoundedTable::listRemove(uint32_t id) {
+	CacheEntry &entry = entries[id];
+	ArcList &l = lists[entry.list];
+
+	if ( ARC_NONE == entry.list ) {
+		return;
+	}
+	if ( BOUNDED_NIL != entry.prev ) {
+		entries[entry.prev].next = entry.next;
+	}
+	else {
+		l.head = entry.next;
+	}
+	if ( BOUNDED_NIL != entry.next ) {
+		entries[entry.next].prev = entry.prev;
+	}
+	else {
+		l.tail = entry.prev;
+	}
+	l.bytes -= entry.size;
+	entry.list = ARC_NONE;
+}
+
+/**
+ * FUNCTION NAME: touch
+ *
+ * DESCRIPTION: Links entry id, whose value was just brought into memory or used
+ * 				and which was taken out of list from, into the list ARC puts it
+ * 				in, adapting the target of T1 on a hit in B1 or B2, and spills
+ * 				other values if memory is over budget
+ */
+void BoundedTable::touch(uint32_t id, int from) {
+	CacheEntry &entry = entries[id];
+	size_t c = valueBudget();
+	size_t delta;
+
+	switch ( from ) {
+		case ARC_B1:
+			// T1 was too small to keep it. The entry has left B1 already,
+			// which may be empty now.
+			delta = lists[ARC_B1].bytes == 0 || lists[ARC_B1].bytes >= lists[ARC_B2].bytes ? 1 : lists[ARC_B2].bytes / lists[ARC_B1].bytes;
+			target = min(c, target + delta * max((size_t)1, (size_t)entry.size));
+			break;
+		case ARC_B2:
+			// T2 was too small to keep it
+			delta = lists[ARC_B2].bytes == 0 || lists[ARC_B2].bytes >= lists[ARC_B1].bytes ? 1 : lists[ARC_B1].bytes / lists[ARC_B2].bytes;
+			delta *= max((size_t)1, (size_t)entry.size);
+			target = target > delta ? target - delta : 0;
+			break;
+	}
+	// Seen before, in memory or among the recently spilled, goes to T2, a
+	// value seen for the first time since it fell out of B1 and B2 to T1
+	listAdd(id, ARC_NONE == from ? ARC_T1 : ARC_T2);
+	makeRoom(ARC_B2 == from);
+	trimGhosts();
+}
+
+/**
+ * FUNCTION NAME: makeRoom
+ *
+ * DESCRIPTION: Spills values, from T1 while it is over its target and from T2
+ * 				otherwise, until the table is within its budget
+ */
+void BoundedTable::makeRoom(bool b2Hit) {
+	while ( memory() > budget ) {
+		ArcList &t1 = lists[ARC_T1];
+		ArcList &t2 = lists[ARC_T2];
+		uint32_t victim;
+		int to;
+
+		if ( BOUNDED_NIL != t1.tail && (t1.bytes > target || (b2Hit && t1.bytes == target) || BOUNDED_NIL == t2.tail) ) {
+			victim = t1.tail;
+			to = ARC_B1;
+		}
+		else if ( BOUNDED_NIL != t2.tail ) {
+			victim = t2.tail;
+			to = ARC_B2;
+		}
+		else {
+			// Nothing left in memory to spill
+			return;
+		}
+		if ( !spill(entries[victim]) ) {
+			return;
+		}
+		listRemove(victim);
+		listAdd(victim, to);
+	}
+}
+
+/**
+ * FUNCTION NAME: trimGhosts
+ *
+ * DESCRIPTION: Keeps T1 and B1 within the cache size and all four lists within
+ * 				twice it, dropping the oldest spilled values from B1 and B2
+ */
+void BoundedTable::trimGhosts() {
+	size_t c = valueBudget();
+
+	while ( BOUNDED_NIL != lists[ARC_B1].tail && lists[ARC_T1].bytes + lists[ARC_B1].bytes > c ) {
+		listRemove(lists[ARC_B1].tail);
+	}
+	while ( BOUNDED_NIL != lists[ARC_B2].tail && lists[ARC_T1].bytes + lists[ARC_T2].bytes
+			+ lists[ARC_B1].bytes + lists[ARC_B2].bytes > 2 * c ) {
+		listRemove(lists[ARC_B2].tail);
+	}
+}
+
+/**
+ * FUNCTION NAME: spill
+ *
+ * DESCRIPTION: Frees the memory of the value of entry, appending it to the spill
+ * 				file unless a copy is there already
+ *
+ * RETURNS:
+ * false if it could not be written
+ */
+bool BoundedTable::spill(CacheEntry &entry) {
+	if ( !entry.spilled ) {
+		size_t done = 0;
+		while ( done < entry.value.size() ) {
+			ssize_t n = pwrite(spillFd, entry.value.data() + done, entry.value.size() - done, spillEnd + done);
+			if ( n < 0 && errno == EINTR ) {
+				continue;
+			}
+			if ( n <= 0 ) {
+				perror(spillPath.c_str());
+				return false;
+			}
+			done += n;
+		}
+		entry.spillOffset = spillEnd;
+		entry.spilled = true;
+		spillEnd += entry.size;
+		stats.spills++;
+		stats.spillBytes += entry.size;
+	}
+	valueBytes -= heapBytes(entry.value);
+	string().swap(entry.value);
+	entry.resident = false;
+	return true;
+}
+
+/**
+ * FUNCTION NAME: pageIn
+ *
+ * DESCRIPTION: Reads the spilled value of entry into value
+ *
+ * RETURNS:
+ * false if it could not be read
+ */
+bool BoundedTable::pageIn(CacheEntry &entry, string &value) {
+	size_t done = 0;
+
+	value.resize(entry.size);
+	while ( done < entry.size ) {
+		ssize_t n = pread(spillFd, &value[done], entry.size - done, entry.spillOffset + done);
+		if ( n < 0 && errno == EINTR ) {
+			continue;
+		}
+		if ( n <= 0 ) {
+			perror(spillPath.c_str());
+			value.clear();
+			return false;
+		}
+		done += n;
+	}
+	return true;
+}
+
+/**
+ * FUNCTION NAME: dropSpill
+ *
+ * DESCRIPTION: Forgets the copy of the value of entry in the spill file, which is
+ * 				stale once the value changes
+ */
+void BoundedTable::dropSpill(CacheEntry &entry) {
+	if ( !entry.spilled ) {
+		return;
+	}
+	entry.spilled = false;
+	spillDead += entry.size;
+	if ( spillDead >= SPILL_COMPACT_BYTES && spillDead * 2 > spillEnd ) {
+		compactSpill();
+	}
+}
+
+/**
+ * FUNCTION NAME: entryExpired
+ *
+ * DESCRIPTION: Whether the value of entry is past its expiry at tick now. Only the
+ * 				header is read from the spill file when the value is not in
+ * 				memory.
+ */
+bool BoundedTable::entryExpired(const CacheEntry &entry, int now) {
+	char header[EXPIRY_BYTES];
+
+	if ( entry.resident ) {
+		return expiredAt(entry.value, now);
+	}
+	if ( entry.size < EXPIRY_BYTES || pread(spillFd, header, EXPIRY_BYTES, entry.spillOffset) != EXPIRY_BYTES ) {
+		return false;
+	}
+	return expiredAt(string_view(header, EXPIRY_BYTES), now);
+}
+
+/**
+ * FUNCTION NAME: newEntry
+ *
+ * DESCRIPTION: Returns the id of an unused entry, reusing one freed by a delete
+ */
+uint32_t BoundedTable::newEntry() {
+	uint32_t id;
+
+	if ( !freeIds.empty() ) {
+		id = freeIds.back();
+		freeIds.pop_back();
+	}
+	else {
+		id = entries.size();
+		entries.emplace_back();
+	}
+	return id;
+}
+
+/**
+ * FUNCTION NAME: assign
+ *
+ * DESCRIPTION: Replaces the value of entry id with newValue, in memory
+ */
+void BoundedTable::assign(uint32_t id, string_view newValue) {
+	CacheEntry &entry = entries[id];
+	int from = entry.list;
+
+	dropSpill(entry);
+	// The size changes, the entry leaves its list before
+	listRemove(id);
+	valueBytes -= heapBytes(entry.value);
+	entry.value.assign(newValue);
+	entry.size = entry.value.size();
+	entry.resident = true;
+	valueBytes += heapBytes(entry.value);
+	touch(id, from);
+}
+
+/**
+ * FUNCTION NAME: remove
+ *
+ * DESCRIPTION: Deletes the key at it in index and frees its entry
+ */
+void BoundedTable::remove(FlatHashMap<uint32_t>::iterator it) {
+	uint32_t id = it->second;
+	CacheEntry &entry = entries[id];
+
+	listRemove(id);
+	dropSpill(entry);
+	valueBytes -= heapBytes(entry.value);
+	string().swap(entry.value);
+	entry.resident = false;
+	keyBytes -= heapBytes(it->first);
+	index.erase(it);
+	freeIds.push_back(id);
+}
+
+/**
+ * FUNCTION NAME: compactSpill
+ *
+ * DESCRIPTION: Copies the current values of the spill file to a new one that
+ * 				replaces it
+ */
+void BoundedTable::compactSpill() {
+	string tmpPath = spillPath + ".tmp";
+	int fd = open(tmpPath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+	vector<uint64_t> offsets(entries.size());
+	uint64_t end = 0;
+	string value;
+
+	if ( fd < 0 ) {
+		perror(tmpPath.c_str());
+		return;
+	}
+	for ( uint32_t id = 0; id < entries.size(); id++ ) {
+		CacheEntry &entry = entries[id];
+		if ( !entry.spilled ) {
+			continue;
+		}
+		if ( !pageIn(entry, value) || pwrite(fd, value.data(), value.size(), end) != (ssize_t)value.size() ) {
+			perror(tmpPath.c_str());
+			close(fd);
+			unlink(tmpPath.c_str());
+			return;
+		}
+		offsets[id] = end;
+		end += value.size();
+	}
+	if ( rename(tmpPath.c_str(), spillPath.c_str()) < 0 ) {
+		perror(tmpPath.c_str());
+		close(fd);
+		unlink(tmpPath.c_str());
+		return;
+	}
+	for ( uint32_t id = 0; id < entries.size(); id++ ) {
+		if ( entries[id].spilled ) {
+			entries[id].spillOffset = offsets[id];
+		}
+	}
+	close(spillFd);
+	spillFd = fd;
+	spillEnd = end;
+	spillDead = 0;
+	stats.compactions++;
+}
+
+/**
+ * FUNCTION NAME: create
+ *
+ * DESCRIPTION: Inserts the (key,value) pair unless the key is already there
+ *
+ * RETURNS:
+ * true if the key was added
+ */
+bool BoundedTable::create(string_view key, string &&value) {
+	lock_guard<mutex> hold(lock);
+	uint32_t id;
+
+	if ( index.find(key) != index.end() ) {
+		return false;
+	}
+	id = newEntry();
+	keyBytes += heapBytes(index.try_emplace(key, std::move(id)).first->first);
+
+	CacheEntry &entry = entries[id];
+	entry.value = std::move(value);
+	entry.size = entry.value.size();
+	entry.spilled = false;
+	entry.resident = true;
+	valueBytes += heapBytes(entry.value);
+	touch(id, ARC_NONE);
+	return true;
+}
+
+/**
+ * FUNCTION NAME: read
+ *
+ * DESCRIPTION: Copies the value of key into value, from the spill file if it is
+ * 				not in memory. value is emptied if the key is not found.
+ *
+ * RETURNS:
+ * true if found
+ */
+bool BoundedTable::read(string_view key, string &value) {
+	lock_guard<mutex> hold(lock);
+	FlatHashMap<uint32_t>::iterator it = index.find(key);
+
+	if ( it == index.end() ) {
+		value.clear();
+		return false;
+	}
+	uint32_t id = it->second;
+	CacheEntry &entry = entries[id];
+	int from = entry.list;
+	if ( entry.resident ) {
+		stats.hits++;
+		value.assign(entry.value);
+	}
+	else {
+		stats.misses++;
+		if ( !pageIn(entry, value) ) {
+			return false;
+		}
+		entry.value = value;
+		entry.resident = true;
+		valueBytes += heapBytes(entry.value);
+	}
+	listRemove(id);
+	touch(id, from);
+	return !value.empty();
+}
+
+/**
+ * FUNCTION NAME: update
+ *
+ * DESCRIPTION: Updates the given key with the value passed in if the key is found
+ *
+ * RETURNS:
+ * true on SUCCESS
+ */
+bool BoundedTable::update(string_view key, string_view newValue) {
+	lock_guard<mutex> hold(lock);
+	FlatHashMap<uint32_t>::iterator it = index.find(key);
+
+	if ( it == index.end() ) {
+		return false;
+	}
+	assign(it->second, newValue);
+	return true;
+}
+
+/**
+ * FUNCTION NAME: deleteKey
+ *
+ * DESCRIPTION: Deletes the given key if it is found
+ *
+ * RETURNS:
+ * true on SUCCESS
+ */
+bool BoundedTable::deleteKey(string_view key) {
+	lock_guard<mutex> hold(lock);
+	FlatHashMap<uint32_t>::iterator it = index.find(key);
+
+	if ( it == index.end() ) {
+		return false;
+	}
+	remove(it);
+	return true;
+}
+
+/**
+ * FUNCTION NAME: createAt
+ *
+ * DESCRIPTION: Inserts the (key,value) pair unless the key is already there with a
+ * 				value not past its expiry at tick now. An expired value is
+ * 				written over, and starts over in the lists like a new one.
+ *
+ * RETURNS:
+ * true if the key was added or its expired value replaced
+ */
+bool BoundedTable::createAt(string_view key, string &&value, int now, bool &expired) {
+	lock_guard<mutex> hold(lock);
+	uint32_t id = BOUNDED_NIL;
+	pair<FlatHashMap<uint32_t>::iterator, bool> ret = index.try_emplace(key, std::move(id));
+
+	expired = false;
+	if ( !ret.second ) {
+		id = ret.first->second;
+		expired = entryExpired(entries[id], now);
+		if ( !expired ) {
+			return false;
+		}
+		listRemove(id);
+		dropSpill(entries[id]);
+		valueBytes -= heapBytes(entries[id].value);
+	}
+	else {
+		id = ret.first->second = newEntry();
+		keyBytes += heapBytes(ret.first->first);
+	}
+
+	CacheEntry &entry = entries[id];
+	entry.value = std::move(value);
+	entry.size = entry.value.size();
+	entry.spilled = false;
+	entry.resident = true;
+	valueBytes += heapBytes(entry.value);
+	touch(id, ARC_NONE);
+	return true;
+}
+
+/**
+ * FUNCTION NAME: updateAt
+ *
+ * DESCRIPTION: Updates the given key with the value passed in if the key is found
+ * 				with a value not past its expiry at tick now. An expired value is
+ * 				deleted.
+ *
+ * RETURNS:
+ * true on SUCCESS
+ */
+bool BoundedTable::updateAt(string_view key, string_view newValue, int now, bool &expired) {
+	lock_guard<mutex> hold(lock);
+	FlatHashMap<uint32_t>::iterator it = index.find(key);
+
+	expired = false;
+	if ( it == index.end() ) {
+		return false;
+	}
+	expired = entryExpired(entries[it->second], now);
+	if ( expired ) {
+		remove(it);
+		return false;
+	}
+	assign(it->second, newValue);
+	return true;
+}
+
+bool BoundedTable::isEmpty() {
+	lock_guard<mutex> hold(lock);
+	return index.empty();
+}
+
+unsigned long BoundedTable::currentSize() {
+	lock_guard<mutex> hold(lock);
+	return index.size();
+}
+
+/**
+ * FUNCTION NAME: clear
+ *
+ * DESCRIPTION: Drops every key, in memory and in the spill file
+ */
+void BoundedTable::clear() {
+	lock_guard<mutex> hold(lock);
+
+	index.clear();
+	vector<CacheEntry>().swap(entries);
+	vector<uint32_t>().swap(freeIds);
+	for ( int i = 0; i < ARC_LISTS; i++ ) {
+		lists[i].head = lists[i].tail = BOUNDED_NIL;
+		lists[i].bytes = 0;
+	}
+	target = 0;
+	keyBytes = valueBytes = 0;
+	spillEnd = spillDead = 0;
+	if ( ftruncate(spillFd, 0) < 0 ) {
+		perror(spillPath.c_str());
+	}
+}
+
+/**
+ * FUNCTION NAME: count
+ *
+ * DESCRIPTION: Returns the count of the number of values for the passed in key
+ */
+unsigned long BoundedTable::count(string_view key) {
+	lock_guard<mutex> hold(lock);
+	return index.find(key) != index.end() ? 1 : 0;
+}
+
+/**
+ * FUNCTION NAME: forEach
+ *
+ * DESCRIPTION: Calls visit on every key and value, holding the lock, so visit
+ * 				must not use the table. Spilled values are read for the call
+ * 				and not kept, so a pass over the table leaves the cache as it
+ * 				was.
+ */
+void BoundedTable::forEach(const function<void(const string &, const string &)> &visit) {
+	lock_guard<mutex> hold(lock);
+	string value;
+
+	for ( FlatHashMap<uint32_t>::iterator it = index.begin(); it != index.end(); ++it ) {
+		CacheEntry &entry = entries[it->second];
+		if ( entry.resident ) {
+			visit(it->first, entry.value);
+		}
+		else if ( pageIn(entry, value) ) {
+			visit(it->first, value);
+		}
+	}
+}
+
+/**
+ * FUNCTION NAME: memoryUsed
+ *
+ * DESCRIPTION: Returns the bytes the table takes, as counted against its budget
+ */
+size_t BoundedTable::memoryUsed() {
+	lock_guard<mutex> hold(lock);
+	return memory();
+}
+
+/**
+ * FUNCTION NAME: getStats
+ *
+ * DESCRIPTION: Returns the counters
+ */
+CacheStats BoundedTable::getStats() {
+	lock_guard<mutex> hold(lock);
+	return stats;
+}
@@ -0,0 +1,162 @@
+/**********************************
+ * FILE NAME: BoundedTable.h
+ *
+ * DESCRIPTION: Header file BoundedTable class
+ **********************************/
+
+#ifndef BOUNDEDTABLE_H_
+#define BOUNDEDTABLE_H_
+
+/**
+ * Header files
+ */
+#include "stdincludes.h"
+#include "StorageEngine.h"
+#include "FlatHashMap.h"
+#include <mutex>
+#include <errno.h>
+
+/*
+ * Macros
+ */
+// Longest string kept inside the string object itself (libstdc++)
+#define BOUNDED_SSO_CAPACITY 15
+// No entry, ends of the lists
+#define BOUNDED_NIL 0xffffffffu
+// The spill file is rewritten once it has this many bytes of stale values and
+// more of them than of current ones, tests give a smaller one at build time
+#ifndef SPILL_COMPACT_BYTES
+#define SPILL_COMPACT_BYTES (16 << 20)
+#endif
+
+/*
+ * Lists of the ARC policy: values in memory seen once (T1) or more (T2),
+ * and values recently sent to disk from either (B1, B2)
+ */
+enum arcLIST { ARC_NONE, ARC_T1, ARC_T2, ARC_B1, ARC_B2, ARC_LISTS };
+
+/**
+ * STRUCT NAME: CacheEntry
+ *
+ * DESCRIPTION: Value of a key of a BoundedTable, in memory or in the spill file,
+ * 				and its place in the lists
+ */
+typedef struct CacheEntry {
+	// Empty while the value is on disk only
+	string value;
+	// Size of the value wherever it is
+	uint32_t size;
+	// Copy of the current value in the spill file, if spilled
+	uint64_t spillOffset;
+	bool spilled;
+	bool resident;
+	uint8_t list;
+	uint32_t prev;
+	uint32_t next;
+} CacheEntry;
+
+/**
+ * STRUCT NAME: ArcList
+ *
+ * DESCRIPTION: Doubly linked list of entries, most recently used at head, and the
+ * 				bytes of their values
+ */
+typedef struct ArcList {
+	uint32_t head;
+	uint32_t tail;
+	size_t bytes;
+} ArcList;
+
+/**
+ * STRUCT NAME: CacheStats
+ *
+ * DESCRIPTION: Counters of a BoundedTable
+ */
+typedef struct CacheStats {
+	// reads of a value in memory
+	long hits;
+	// reads of a value on disk
+	long misses;
+	// values written to the spill file, and their bytes
+	long spills;
+	long spillBytes;
+	// rewrites of the spill file
+	long compactions;
+} CacheStats;
+
+/**
+ * CLASS NAME: BoundedTable
+ *
+ * DESCRIPTION: Table kept within budget bytes of memory. Every key stays in
+ * 				memory; values that do not fit are written to an append-only
+ * 				spill file and read back when asked for. Memory is counted in
+ * 				bytes: the slots of the index and the entries, and the heap
+ * 				blocks of the keys and values in memory.
+ * 				Which values stay is decided by ARC (Adaptive Replacement
+ * 				Cache) weighted by value size: values seen once and values seen
+ * 				again are kept in separate lists, and the share of the first
+ * 				adapts to hits on the recently spilled values of either. A
+ * 				scan goes through the first list only, so it cannot push out
+ * 				the values in use.
+ * 				A value read back keeps its copy in the spill file until it is
+ * 				changed, so it can be spilled again without a write. Stale
+ * 				copies are dropped by rewriting the file.
+ * 				Every operation moves entries between lists, reads too, so all
+ * 				of them take one lock. The spill file is scratch space and is
+ * 				removed with the table.
+ */
+class BoundedTable : public StorageEngine {
+private:
+	mutex lock;
+	size_t budget;
+	// Entry of every key
+	FlatHashMap<uint32_t> index;
+	vector<CacheEntry> entries;
+	vector<uint32_t> freeIds;
+	ArcList lists[ARC_LISTS];
+	// Bytes of T1 ARC aims for
+	size_t target;
+	// Heap bytes of the keys, and of the values in memory
+	size_t keyBytes;
+	size_t valueBytes;
+	string spillPath;
+	int spillFd;
+	uint64_t spillEnd;
+	uint64_t spillDead;
+	CacheStats stats;
+
+	static size_t heapBytes(const string &s);
+	size_t memory();
+	size_t valueBudget();
+	void listAdd(uint32_t id, int list);
+	void listRemove(uint32_t id);
+	void touch(uint32_t id, int from);
+	void makeRoom(bool b2Hit);
+	void trimGhosts();
+	bool spill(CacheEntry &entry);
+	bool pageIn(CacheEntry &entry, string &value);
+	void dropSpill(CacheEntry &entry);
+	void compactSpill();
+	bool entryExpired(const CacheEntry &entry, int now);
+	uint32_t newEntry();
+	void assign(uint32_t id, string_view newValue);
+	void remove(FlatHashMap<uint32_t>::iterator it);
+public:
+	BoundedTable(const string &spillPath, size_t budget);
+	virtual ~BoundedTable();
+	bool create(string_view key, string &&value);
+	bool read(string_view key, string &value);
+	bool update(string_view key, string_view newValue);
+	bool deleteKey(string_view key);
+	bool isEmpty();
+	unsigned long currentSize();
+	void clear();
+	unsigned long count(string_view key);
+	void forEach(const function<void(const string &, const string &)> &visit);
+	bool createAt(string_view key, string &&value, int now, bool &expired);
+	bool updateAt(string_view key, string_view newValue, int now, bool &expired);
+	size_t memoryUsed();
+	CacheStats getStats();
+};
+
+#endif /* BOUNDEDTABLE_H_ */
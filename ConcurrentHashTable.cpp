@@ -0,0 +1,493 @@
+/**********************************
+ * FILE NAME: ConcurrentHashTable.cpp
+ *
+ * DESCRIPTION: Concurrent Hash Table class definition
+ **********************************/
+
+#include "ConcurrentHashTable.h"
+
+ConcurrentHashTable::ConcurrentHashTable() {
+	for ( int i = 0; i < HT_SHARDS; i++ ) {
+		shards[i].layers.push_back(make_shared<HashTable>());
+		shards[i].keys = 0;
+	}
+}
+
+ConcurrentHashTable::~ConcurrentHashTable() {}
+
+/**
+ * FUNCTION NAME: shardIndex
+ *
+ * DESCRIPTION: Returns the number of the shard holding key
+ */
+int ConcurrentHashTable::shardIndex(string_view key) {
+	size_t h = std::hash<string_view>()(key);
+	return (h >> HT_SHARD_SHIFT) & (HT_SHARDS - 1);
+}
+
+/**
+ * FUNCTION NAME: shardOf
+ *
+ * DESCRIPTION: Returns the shard holding key
+ */
+HashTableShard &ConcurrentHashTable::shardOf(string_view key) {
+	return shards[shardIndex(key)];
+}
+
+/**
+ * FUNCTION NAME: lookup
+ *
+ * DESCRIPTION: Looks key up in layers, newest first
+ *
+ * RETURNS:
+ * the value, NULL if the key is not there or was deleted
+ */
+const string *ConcurrentHashTable::lookup(const ShardLayers &layers, string_view key) {
+	for ( int i = layers.size() - 1; i >= 0; i-- ) {
+		FlatHashMap<string>::iterator it = layers[i]->hashTable.find(key);
+		if ( it != layers[i]->hashTable.end() ) {
+			return it->second.empty() ? NULL : &it->second;
+		}
+	}
+	return NULL;
+}
+
+/**
+ * FUNCTION NAME: visitLayers
+ *
+ * DESCRIPTION: Calls visit on every key of layers and its newest value, skipping
+ * 				deleted keys
+ */
+void ConcurrentHashTable::visitLayers(const ShardLayers &layers, const function<void(const string &, const string &)> &visit) {
+	for ( int i = layers.size() - 1; i >= 0; i-- ) {
+		FlatHashMap<string> &map = layers[i]->hashTable;
+		for ( FlatHashMap<string>::iterator it = map.begin(); it != map.end(); it++ ) {
+			bool newer = false;
+			for ( unsigned int j = i + 1; j < layers.size() && !newer; j++ ) {
+				newer = layers[j]->hashTable.count(it->first) > 0;
+			}
+			if ( !newer && !it->second.empty() ) {
+				visit(it->first, it->second);
+			}
+		}
+	}
+}
+
+/**
+ * FUNCTION NAME: fold
+ *
+ * DESCRIPTION: Merges the layers of shard into the oldest once no snapshot holds
+ * 				any of them. Holds the write lock of the shard.
+ */
+void ConcurrentHashTable::fold(HashTableShard &shard) {
+	if ( shard.layers.size() == 1 ) {
+		return;
+	}
+	for ( unsigned int i = 0; i < shard.layers.size(); i++ ) {
+		if ( shard.layers[i].use_count() > 1 ) {
+			return;
+		}
+	}
+	FlatHashMap<string> &base = shard.layers[0]->hashTable;
+	for ( unsigned int i = 1; i < shard.layers.size(); i++ ) {
+		FlatHashMap<string> &map = shard.layers[i]->hashTable;
+		for ( FlatHashMap<string>::iterator it = map.begin(); it != map.end(); it++ ) {
+			if ( it->second.empty() ) {
+				base.erase(it->first);
+				continue;
+			}
+			FlatHashMap<string>::iterator old = base.find(it->first);
+			if ( old != base.end() ) {
+				old->second.swap(it->second);
+			}
+			else {
+				base.try_emplace(it->first, std::move(it->second));
+			}
+		}
+	}
+	shard.layers.resize(1);
+}
+
+/**
+ * FUNCTION NAME: writable
+ *
+ * DESCRIPTION: Returns the top layer of shard, after folding the layers if it can,
+ * 				starting a new one if a snapshot holds it. Holds the write lock of
+ * 				the shard.
+ */
+HashTable &ConcurrentHashTable::writable(HashTableShard &shard) {
+	fold(shard);
+	if ( shard.layers.back().use_count() > 1 ) {
+		shard.layers.push_back(make_shared<HashTable>());
+	}
+	return *shard.layers.back();
+}
+
+/**
+ * FUNCTION NAME: put
+ *
+ * DESCRIPTION: Writes value over key in the top layer of shard, which lies above
+ * 				others, an empty value marking the key deleted
+ */
+void ConcurrentHashTable::put(HashTableShard &shard, string_view key, string_view value) {
+	FlatHashMap<string> &top = shard.layers.back()->hashTable;
+	FlatHashMap<string>::iterator it = top.find(key);
+
+	if ( it != top.end() ) {
+		it->second.assign(value);
+	}
+	else {
+		top.try_emplace(key, string(value));
+	}
+}
+
+/**
+ * FUNCTION NAME: create
+ *
+ * DESCRIPTION: Inserts the (key,value) pair unless the key is already there, in
+ * 				which case value is left as it was
+ *
+ * RETURNS:
+ * true if the key was added
+ * false otherwise
+ */
+bool ConcurrentHashTable::create(string_view key, string &&value) {
+	HashTableShard &shard = shardOf(key);
+	unique_lock<shared_mutex> hold(shard.lock);
+	HashTable &top = writable(shard);
+
+	if ( shard.layers.size() == 1 ) {
+		if ( NULL == top.create(key, std::move(value)) ) {
+			return false;
+		}
+	}
+	else {
+		if ( NULL != lookup(shard.layers, key) ) {
+			return false;
+		}
+		FlatHashMap<string>::iterator it = top.hashTable.find(key);
+		if ( it != top.hashTable.end() ) {
+			it->second = std::move(value);
+		}
+		else {
+			top.hashTable.try_emplace(key, std::move(value));
+		}
+	}
+	shard.keys++;
+	return true;
+}
+
+/**
+ * FUNCTION NAME: read
+ *
+ * DESCRIPTION: Copies the value of key into value, which keeps its capacity across
+ * 				calls. value is emptied if the key is not found.
+ *
+ * RETURNS:
+ * true if found
+ * false otherwise
+ */
+bool ConcurrentHashTable::read(string_view key, string &value) {
+	HashTableShard &shard = shardOf(key);
+	shared_lock<shared_mutex> hold(shard.lock);
+	const string *found = lookup(shard.layers, key);
+
+	if ( NULL == found ) {
+		value.clear();
+		return false;
+	}
+	value.assign(*found);
+	return !value.empty();
+}
+
+/**
+ * FUNCTION NAME: update
+ *
+ * DESCRIPTION: Updates the given key with the value passed in if the key is found
+ *
+ * RETURNS:
+ * true on SUCCESS
+ * false on FAILURE
+ */
+bool ConcurrentHashTable::update(string_view key, string_view newValue) {
+	HashTableShard &shard = shardOf(key);
+	unique_lock<shared_mutex> hold(shard.lock);
+	HashTable &top = writable(shard);
+
+	if ( shard.layers.size() == 1 ) {
+		return top.update(key, newValue);
+	}
+	if ( NULL == lookup(shard.layers, key) ) {
+		return false;
+	}
+	put(shard, key, newValue);
+	return true;
+}
+
+/**
+ * FUNCTION NAME: deleteKey
+ *
+ * DESCRIPTION: Deletes the given key and its value if the key is found
+ *
+ * RETURNS:
+ * true on SUCCESS
+ * false on FAILURE
+ */
+bool ConcurrentHashTable::deleteKey(string_view key) {
+	HashTableShard &shard = shardOf(key);
+	unique_lock<shared_mutex> hold(shard.lock);
+	HashTable &top = writable(shard);
+
+	if ( shard.layers.size() == 1 ) {
+		if ( !top.deleteKey(key) ) {
+			return false;
+		}
+	}
+	else {
+		if ( NULL == lookup(shard.layers, key) ) {
+			return false;
+		}
+		// The layers below still have it
+		put(shard, key, string_view());
+	}
+	shard.keys--;
+	return true;
+}
+
+/**
+ * FUNCTION NAME: createAt
+ *
+ * DESCRIPTION: Inserts the (key,value) pair unless the key is already there with a
+ * 				value not past its expiry at tick now. An expired value is
+ * 				written over.
+ *
+ * RETURNS:
+ * true if the key was added or its expired value replaced
+ * false otherwise
+ */
+bool ConcurrentHashTable::createAt(string_view key, string &&value, int now, bool &expired) {
+	HashTableShard &shard = shardOf(key);
+	unique_lock<shared_mutex> hold(shard.lock);
+	HashTable &top = writable(shard);
+
+	expired = false;
+	if ( shard.layers.size() == 1 ) {
+		pair<FlatHashMap<string>::iterator, bool> ret = top.hashTable.try_emplace(key, std::move(value));
+		if ( !ret.second ) {
+			expired = expiredAt(ret.first->second, now);
+			if ( !expired ) {
+				return false;
+			}
+			ret.first->second = std::move(value);
+		}
+	}
+	else {
+		const string *found = lookup(shard.layers, key);
+		if ( NULL != found ) {
+			expired = expiredAt(*found, now);
+			if ( !expired ) {
+				return false;
+			}
+		}
+		FlatHashMap<string>::iterator it = top.hashTable.find(key);
+		if ( it != top.hashTable.end() ) {
+			it->second = std::move(value);
+		}
+		else {
+			top.hashTable.try_emplace(key, std::move(value));
+		}
+	}
+	if ( !expired ) {
+		shard.keys++;
+	}
+	return true;
+}
+
+/**
+ * FUNCTION NAME: updateAt
+ *
+ * DESCRIPTION: Updates the given key with the value passed in if the key is found
+ * 				with a value not past its expiry at tick now. An expired value is
+ * 				deleted.
+ *
+ * RETURNS:
+ * true on SUCCESS
+ * false on FAILURE
+ */
+bool ConcurrentHashTable::updateAt(string_view key, string_view newValue, int now, bool &expired) {
+	HashTableShard &shard = shardOf(key);
+	unique_lock<shared_mutex> hold(shard.lock);
+	HashTable &top = writable(shard);
+
+	expired = false;
+	if ( shard.layers.size() == 1 ) {
+		FlatHashMap<string>::iterator it = top.hashTable.find(key);
+		if ( it == top.hashTable.end() || it->second.empty() ) {
+			return false;
+		}
+		expired = expiredAt(it->second, now);
+		if ( expired ) {
+			top.hashTable.erase(it);
+			shard.keys--;
+			return false;
+		}
+		it->second.assign(newValue);
+		return true;
+	}
+	const string *found = lookup(shard.layers, key);
+	if ( NULL == found ) {
+		return false;
+	}
+	expired = expiredAt(*found, now);
+	if ( expired ) {
+		put(shard, key, string_view());
+		shard.keys--;
+		return false;
+	}
+	put(shard, key, newValue);
+	return true;
+}
+
+/**
+ * FUNCTION NAME: isEmpty
+ *
+ * DESCRIPTION: Returns if every shard is empty
+ */
+bool ConcurrentHashTable::isEmpty() {
+	for ( int i = 0; i < HT_SHARDS; i++ ) {
+		shared_lock<shared_mutex> hold(shards[i].lock);
+		if ( shards[i].keys > 0 ) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * FUNCTION NAME: currentSize
+ *
+ * DESCRIPTION: Returns the number of keys, summed over the shards
+ */
+unsigned long ConcurrentHashTable::currentSize() {
+	unsigned long size = 0;
+
+	for ( int i = 0; i < HT_SHARDS; i++ ) {
+		shared_lock<shared_mutex> hold(shards[i].lock);
+		size += shards[i].keys;
+	}
+	return size;
+}
+
+/**
+ * FUNCTION NAME: clear
+ *
+ * DESCRIPTION: Clear all contents from the hash table. Snapshots keep what they had.
+ */
+void ConcurrentHashTable::clear() {
+	for ( int i = 0; i < HT_SHARDS; i++ ) {
+		unique_lock<shared_mutex> hold(shards[i].lock);
+		shards[i].layers.assign(1, make_shared<HashTable>());
+		shards[i].keys = 0;
+	}
+}
+
+/**
+ * FUNCTION NAME: count
+ *
+ * DESCRIPTION: Returns the count of the number of values for the passed in key
+ */
+unsigned long ConcurrentHashTable::count(string_view key) {
+	HashTableShard &shard = shardOf(key);
+	shared_lock<shared_mutex> hold(shard.lock);
+
+	return NULL != lookup(shard.layers, key) ? 1 : 0;
+}
+
+/**
+ * FUNCTION NAME: forEach
+ *
+ * DESCRIPTION: Calls visit on every key and value, holding the read lock of the
+ * 				shard being visited. visit must not change the table, and should
+ * 				be quick, as writers to the shard wait for it. A scan that
+ * 				should not hold up writers goes through openSnapshot instead.
+ */
+void ConcurrentHashTable::forEach(const function<void(const string &, const string &)> &visit) {
+	for ( int i = 0; i < HT_SHARDS; i++ ) {
+		shared_lock<shared_mutex> hold(shards[i].lock);
+		visitLayers(shards[i].layers, visit);
+	}
+}
+
+/**
+ * FUNCTION NAME: openSnapshot
+ *
+ * DESCRIPTION: Returns a view of every shard at one point in time. The read locks
+ * 				of all the shards are held together, only while their layers are
+ * 				shared, so it costs no copy of keys or values.
+ */
+shared_ptr<TableSnapshot> ConcurrentHashTable::openSnapshot() {
+	shared_ptr<ShardSnapshot> snap = make_shared<ShardSnapshot>(this);
+	shared_lock<shared_mutex> holds[HT_SHARDS];
+
+	// In shard order, writers take one lock at a time
+	for ( int i = 0; i < HT_SHARDS; i++ ) {
+		holds[i] = shared_lock<shared_mutex>(shards[i].lock);
+	}
+	for ( int i = 0; i < HT_SHARDS; i++ ) {
+		snap->shards[i] = shards[i].layers;
+	}
+	return snap;
+}
+
+/**
+ * Constructor
+ */
+ShardSnapshot::ShardSnapshot(ConcurrentHashTable *table) {
+	this->table = table;
+}
+
+/**
+ * Destructor
+ */
+ShardSnapshot::~ShardSnapshot() {
+	for ( int i = 0; i < HT_SHARDS; i++ ) {
+		shared_lock<shared_mutex> hold(table->shards[i].lock);
+		shards[i].clear();
+	}
+}
+
+/**
+ * FUNCTION NAME: read
+ *
+ * DESCRIPTION: Copies the value key had into value
+ *
+ * RETURNS:
+ * true if found
+ * false otherwise
+ */
+bool ShardSnapshot::read(string_view key, string &value) {
+	const string *found = ConcurrentHashTable::lookup(shards[ConcurrentHashTable::shardIndex(key)], key);
+
+	if ( NULL == found ) {
+		value.clear();
+		return false;
+	}
+	value.assign(*found);
+	return true;
+}
+
+/**
+ * FUNCTION NAME: forEach
+ *
+ * DESCRIPTION: Calls visit on every key and value the table had, without holding
+ * 				any lock
+ */
+void ShardSnapshot::forEach(const function<void(const string &, const string &)> &visit) {
+	for ( int i = 0; i < HT_SHARDS; i++ ) {
+		ConcurrentHashTable::visitLayers(shards[i], visit);
+	}
+}
+
+bool ShardSnapshot::pointInTime() {
+	return true;
+}
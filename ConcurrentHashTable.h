@@ -0,0 +1,118 @@
+/**********************************
+ * FILE NAME: ConcurrentHashTable.h
+ *
+ * DESCRIPTION: Header file ConcurrentHashTable class
+ **********************************/
+
+#ifndef CONCURRENTHASHTABLE_H_
+#define CONCURRENTHASHTABLE_H_
+
+/**
+ * Header files
+ */
+#include "stdincludes.h"
+#include "HashTable.h"
+#include "StorageEngine.h"
+#include <mutex>
+#include <shared_mutex>
+
+/*
+ * Macros
+ */
+// Number of shards, a power of two
+#define HT_SHARDS 64
+// Bits of the key hash picking the shard start here, above the bits the
+// shards use for their slots and below the ones they keep in their tags
+#define HT_SHARD_SHIFT 32
+
+class ConcurrentHashTable;
+
+// Layers of a shard, oldest first
+typedef vector< shared_ptr<HashTable> > ShardLayers;
+
+/**
+ * STRUCT NAME: HashTableShard
+ *
+ * DESCRIPTION: The layers of a shard and the lock guarding them, on cache lines of
+ * 				their own so that threads working on different shards do not
+ * 				share any
+ */
+struct alignas(64) HashTableShard {
+	shared_mutex lock;
+	ShardLayers layers;
+	// Keys in the shard
+	unsigned long keys;
+};
+
+/**
+ * CLASS NAME: ShardSnapshot
+ *
+ * DESCRIPTION: TableSnapshot of a ConcurrentHashTable, the layers every shard had
+ * 				when it was taken. They are never written again, so it is read
+ * 				without any lock. It lets go of them under the lock of their
+ * 				shard, so a writer folding them finds it done with them; the
+ * 				table must outlive it.
+ */
+class ShardSnapshot : public TableSnapshot {
+private:
+	friend class ConcurrentHashTable;
+	ConcurrentHashTable *table;
+	ShardLayers shards[HT_SHARDS];
+public:
+	ShardSnapshot(ConcurrentHashTable *table);
+	virtual ~ShardSnapshot();
+	bool read(string_view key, string &value);
+	void forEach(const function<void(const string &, const string &)> &visit);
+	bool pointInTime();
+};
+
+/**
+ * CLASS NAME: ConcurrentHashTable
+ *
+ * DESCRIPTION: Same operations as HashTable, safe to call from any number of
+ * 				threads. Keys are spread over HT_SHARDS shards by hash, each
+ * 				behind a reader-writer lock: reads of a shard go on side by
+ * 				side, a write holds it alone. Values are copied out under the
+ * 				lock, since a reference could be overwritten by another thread
+ * 				once it is released.
+ * 				Whole table operations take the shards one at a time, so they
+ * 				see each shard at one point in time but not all of them at the
+ * 				same one. openSnapshot sees all of them at one, and costs no
+ * 				copy: a shard is a stack of HashTables (copy on write), the
+ * 				newest layer holding the keys changed since the one below was
+ * 				frozen, deleted ones with an empty value. A snapshot shares
+ * 				the layers of every shard, and a write to a shard whose top
+ * 				layer is shared starts a new one. Reads look from the top
+ * 				down. The first write to a shard once no snapshot holds its
+ * 				layers folds them back into one.
+ */
+class ConcurrentHashTable : public StorageEngine {
+private:
+	friend class ShardSnapshot;
+	HashTableShard shards[HT_SHARDS];
+
+	static int shardIndex(string_view key);
+	HashTableShard &shardOf(string_view key);
+	static const string *lookup(const ShardLayers &layers, string_view key);
+	static void visitLayers(const ShardLayers &layers, const function<void(const string &, const string &)> &visit);
+	static HashTable &writable(HashTableShard &shard);
+	static void fold(HashTableShard &shard);
+	static void put(HashTableShard &shard, string_view key, string_view value);
+public:
+	ConcurrentHashTable();
+	bool create(string_view key, string &&value);
+	bool read(string_view key, string &value);
+	bool update(string_view key, string_view newValue);
+	bool deleteKey(string_view key);
+	bool isEmpty();
+	unsigned long currentSize();
+	void clear();
+	unsigned long count(string_view key);
+	void forEach(const function<void(const string &, const string &)> &visit);
+	bool createAt(string_view key, string &&value, int now, bool &expired);
+	bool updateAt(string_view key, string_view newValue, int now, bool &expired);
+	shared_ptr<TableSnapshot> openSnapshot();
+	virtual ~ConcurrentHashTable();
+};
+
+#endif /* CONCURRENTHASHTABLE_H_ */
@@ -0,0 +1,146 @@
+/**********************************
+ * FILE NAME: CountingBloomFilter.cpp
+ *
+ * DESCRIPTION: CountingBloomFilter class definition
+ **********************************/
+
+#include "CountingBloomFilter.h"
+
+/**
+ * Constructor
+ */
+CountingBloomFilter::CountingBloomFilter(int countersPerKey, unsigned long capacity) {
+	this->countersPerKey = max(1, countersPerKey);
+	// Fewest absent keys get through with ln 2 probes per counter per key
+	this->probes = max(1, (int)(this->countersPerKey * 0.693 + 0.5));
+	reset(capacity);
+}
+
+/**
+ * FUNCTION NAME: hash
+ *
+ * DESCRIPTION: Hash of key the probes are derived from
+ */
+uint64_t CountingBloomFilter::hash(string_view key) {
+	return std::hash<string_view>()(key);
+}
+
+int CountingBloomFilter::counter(uint64_t slot) {
+	return (counters[slot >> 1] >> ((slot & 1) << 2)) & 0xf;
+}
+
+void CountingBloomFilter::setCounter(uint64_t slot, int value) {
+	int shift = (slot & 1) << 2;
+	counters[slot >> 1] = (counters[slot >> 1] & ~(0xf << shift)) | (value << shift);
+}
+
+/**
+ * FUNCTION NAME: insert
+ *
+ * DESCRIPTION: Adds key. A key added twice must be removed twice.
+ */
+void CountingBloomFilter::insert(string_view key) {
+	uint64_t h = hash(key);
+	uint64_t step = (h >> 33 | h << 31) | 1;
+
+	for ( int i = 0; i < probes; i++, h += step ) {
+		int value = counter(h & mask);
+		if ( value < BLOOM_COUNTER_MAX ) {
+			setCounter(h & mask, value + 1);
+		}
+	}
+	keys++;
+}
+
+/**
+ * FUNCTION NAME: erase
+ *
+ * DESCRIPTION: Removes key, which must have been added
+ */
+void CountingBloomFilter::erase(string_view key) {
+	uint64_t h = hash(key);
+	uint64_t step = (h >> 33 | h << 31) | 1;
+
+	for ( int i = 0; i < probes; i++, h += step ) {
+		int value = counter(h & mask);
+		// Saturated counters may count more keys than they can tell
+		if ( value > 0 && value < BLOOM_COUNTER_MAX ) {
+			setCounter(h & mask, value - 1);
+		}
+	}
+	if ( keys > 0 ) {
+		keys--;
+	}
+}
+
+/**
+ * FUNCTION NAME: mayContain
+ *
+ * DESCRIPTION: false means key is surely not there
+ */
+bool CountingBloomFilter::mayContain(string_view key) {
+	uint64_t h = hash(key);
+	uint64_t step = (h >> 33 | h << 31) | 1;
+
+	for ( int i = 0; i < probes; i++, h += step ) {
+		if ( 0 == counter(h & mask) ) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * FUNCTION NAME: full
+ *
+ * DESCRIPTION: Whether the filter holds more keys than it was sized for
+ */
+bool CountingBloomFilter::full() {
+	return keys > capacity;
+}
+
+/**
+ * FUNCTION NAME: reset
+ *
+ * DESCRIPTION: Removes every key and sizes the filter for capacity keys
+ */
+void CountingBloomFilter::reset(unsigned long capacity) {
+	uint64_t slots = 2;
+
+	this->capacity = max((unsigned long)BLOOM_MIN_KEYS, capacity);
+	while ( slots < (uint64_t)this->capacity * countersPerKey ) {
+		slots <<= 1;
+	}
+	mask = slots - 1;
+	counters.assign(slots / 2, 0);
+	counters.shrink_to_fit();
+	keys = 0;
+}
+
+/**
+ * FUNCTION NAME: size
+ *
+ * DESCRIPTION: Returns the number of keys
+ */
+unsigned long CountingBloomFilter::size() {
+	return keys;
+}
+
+/**
+ * FUNCTION NAME: memoryUsed
+ *
+ * DESCRIPTION: Bytes of the counters
+ */
+size_t CountingBloomFilter::memoryUsed() {
+	return counters.capacity();
+}
+
+/**
+ * FUNCTION NAME: falsePositiveRate
+ *
+ * DESCRIPTION: Expected share of absent keys mayContain lets through at the
+ * 				current number of keys
+ */
+double CountingBloomFilter::falsePositiveRate() {
+	return pow(1 - exp(-(double)probes * keys / (mask + 1)), probes);
+}
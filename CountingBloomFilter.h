@@ -0,0 +1,66 @@
+/**********************************
+ * FILE NAME: CountingBloomFilter.h
+ *
+ * DESCRIPTION: Header file CountingBloomFilter class
+ **********************************/
+
+#ifndef COUNTINGBLOOMFILTER_H_
+#define COUNTINGBLOOMFILTER_H_
+
+/**
+ * Header files
+ */
+#include "stdincludes.h"
+
+/*
+ * Macros
+ */
+// Keys an empty filter is sized for
+#define BLOOM_MIN_KEYS 1024
+// A counter that reaches this value stays there, it can no longer tell how many
+// keys it counts
+#define BLOOM_COUNTER_MAX 15
+
+/**
+ * CLASS NAME: CountingBloomFilter
+ *
+ * DESCRIPTION: Set of keys that can answer "surely not there" without looking at
+ * 				the keys. Every key adds one to probes counters of 4 bits, two
+ * 				to a byte, picked by double hashing of its hash; removing it
+ * 				takes the ones back, so keys can be deleted as they can be added.
+ * 				A key is there only if none of its counters is 0.
+ * 				The filter has countersPerKey counters (rounded up to a power of
+ * 				two) per key it is sized for, more counters cost memory and let
+ * 				fewer absent keys through. It does not grow by itself: full()
+ * 				tells when it holds more keys than it was sized for, and the
+ * 				owner resets it larger and adds its keys again.
+ * 				A counter saturates at BLOOM_COUNTER_MAX and is never taken down
+ * 				from there, so removing keys cannot make one present key look
+ * 				absent. Only keys that were added may be removed.
+ */
+class CountingBloomFilter {
+private:
+	vector<uint8_t> counters;
+	// Number of counters - 1, their number is a power of two
+	uint64_t mask;
+	int countersPerKey;
+	int probes;
+	unsigned long capacity;
+	unsigned long keys;
+
+	static uint64_t hash(string_view key);
+	int counter(uint64_t slot);
+	void setCounter(uint64_t slot, int value);
+public:
+	CountingBloomFilter(int countersPerKey, unsigned long capacity = BLOOM_MIN_KEYS);
+	void insert(string_view key);
+	void erase(string_view key);
+	bool mayContain(string_view key);
+	bool full();
+	void reset(unsigned long capacity);
+	unsigned long size();
+	size_t memoryUsed();
+	double falsePositiveRate();
+};
+
+#endif /* COUNTINGBLOOMFILTER_H_ */
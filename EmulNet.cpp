@@ -6,23 +6,30 @@
 
 #include "EmulNet.h"
 
+// MSGCOUNT_LOG is shared by all EmulNets, opened by the first one to write to it
+static FILE *countFile;
+static int countFileUsers;
+static int nextNetId;
+
 /**
  * Constructor
  */
 EmulNet::EmulNet(Params *p)
 {
 	//trace.funcEntry("EmulNet::EmulNet");
-	int i,j;
 	par = p;
 	emulnet.setNextId(1);
 	emulnet.settCurrBuffSize(0);
 	enInited=0;
-	for ( i = 0; i < MAX_NODES; i++ ) {
-		for ( j = 0; j < MAX_TIME; j++ ) {
-			sent_msgs[i][j] = 0;
-			recv_msgs[i][j] = 0;
-		}
-	}
+	netid = nextNetId++;
+	countFileUsers++;
+	openTick = 0;
+	openCount = 0;
+	payloadBytes = 0;
+	nextMsgId = 0;
+	sharedSent = 0;
+	memset(buffered, 0, sizeof(buffered));
+	memset(classCounts, 0, sizeof(classCounts));
 	//trace.funcExit("EmulNet::EmulNet", SUCCESS);
 }
 
@@ -30,31 +37,28 @@ EmulNet::EmulNet(Params *p)
  * Copy constructor
  */
 EmulNet::EmulNet(EmulNet &anotherEmulNet) {
-	int i, j;
 	this->par = anotherEmulNet.par;
 	this->enInited = anotherEmulNet.enInited;
-	for ( i = 0; i < MAX_NODES; i++ ) {
-		for ( j = 0; j < MAX_TIME; j++ ) {
-			this->sent_msgs[i][j] = anotherEmulNet.sent_msgs[i][j];
-			this->recv_msgs[i][j] = anotherEmulNet.recv_msgs[i][j];
-		}
-	}
+	this->counts = anotherEmulNet.counts;
+	this->netid = nextNetId++;
+	countFileUsers++;
 	this->emulnet = anotherEmulNet.emulnet;
+	this->openTick = 0;
+	this->openCount = 0;
+	this->payloadBytes = 0;
+	this->nextMsgId = 0;
+	this->sharedSent = 0;
+	memset(this->buffered, 0, sizeof(this->buffered));
+	memset(this->classCounts, 0, sizeof(this->classCounts));
 }
 
 /**
  * Assignment operator overloading
  */
 EmulNet& EmulNet::operator =(EmulNet &anotherEmulNet) {
-	int i, j;
 	this->par = anotherEmulNet.par;
 	this->enInited = anotherEmulNet.enInited;
-	for ( i = 0; i < MAX_NODES; i++ ) {
-		for ( j = 0; j < MAX_TIME; j++ ) {
-			this->sent_msgs[i][j] = anotherEmulNet.sent_msgs[i][j];
-			this->recv_msgs[i][j] = anotherEmulNet.recv_msgs[i][j];
-		}
-	}
+	this->counts = anotherEmulNet.counts;
 	this->emulnet = anotherEmulNet.emulnet;
 	return *this;
 }
@@ -62,7 +66,12 @@ EmulNet& EmulNet::operator =(EmulNet &anotherEmulNet) {
 /**
  * Destructor
  */
-EmulNet::~EmulNet() {}
+EmulNet::~EmulNet() {
+	if ( --countFileUsers == 0 && NULL != countFile ) {
+		fclose(countFile);
+		countFile = NULL;
+	}
+}
 
 /**
  * FUNCTION NAME: ENinit
@@ -71,44 +80,75 @@ EmulNet::~EmulNet() {}
  */
 void *EmulNet::ENinit(Address *myaddr, short port) {
 	// Initialize data structures for this member
-	*(int *)(myaddr->addr) = emulnet.nextid++;
+	int id = emulnet.nextid++;
+	*(int *)(myaddr->addr) = id;
     *(short *)(&myaddr->addr[4]) = 0;
+	emulnet.getInbox(id, NUM_CLASSES - 1);
 	return myaddr;
 }
 
 /**
  * FUNCTION NAME: ENsend
  *
- * DESCRIPTION: EmulNet send function
+ * DESCRIPTION: Sends a message of CLIENT_CLASS
  *
  * RETURNS:
- * size
+ * size, EN_DROPPED, EN_WOULDBLOCK or EN_TOOBIG
  */
 int EmulNet::ENsend(Address *myaddr, Address *toaddr, char *data, int size) {
-	en_msg *em;
+	return this->ENsend(myaddr, toaddr, data, size, CLIENT_CLASS);
+}
+
+/**
+ * FUNCTION NAME: ENsend
+ *
+ * DESCRIPTION: EmulNet send function. The message is added to the frame of its
+ * 				class open from myaddr to toaddr this tick, the frame leaves when
+ * 				toaddr receives, when the tick is over or when the next message
+ * 				would take it past MAX_MSG_SIZE. A message too large for a frame
+ * 				is cut into fragments that fill one frame each. No more than
+ * 				ENWINDOW messages or fragments of a class are in flight towards a
+ * 				node, beyond that sends of the class would block.
+ *
+ * RETURNS:
+ * size, EN_DROPPED, EN_WOULDBLOCK or EN_TOOBIG
+ */
+int EmulNet::ENsend(Address *myaddr, Address *toaddr, char *data, int size, int cls) {
 	static char temp[2048];
 	int sendmsg = rand() % 100;
+	int src = *(int *)(myaddr->addr);
+	int dst = *(int *)(toaddr->addr);
+	int pieces;
 
-	if( (emulnet.currbuffsize >= ENBUFFSIZE) || (size + (int)sizeof(en_msg) >= par->MAX_MSG_SIZE) || (par->dropmsg && sendmsg < (int) (par->MSG_DROP_PROB * 100)) ) {
-		return 0;
+	if ( size < 0 || size > ENMAXMSG ) {
+		return EN_TOOBIG;
 	}
 
-	em = (en_msg *)malloc(sizeof(en_msg) + size);
-	em->size = size;
-
-	memcpy(&(em->from.addr), &(myaddr->addr), sizeof(em->from.addr));
-	memcpy(&(em->to.addr), &(toaddr->addr), sizeof(em->from.addr));
-	memcpy(em + 1, data, size);
+	if ( src < 0 || NULL == emulnet.getInbox(dst, cls) ) {
+		// Not a valid node address or class
+		return EN_DROPPED;
+	}
 
-	emulnet.buff[emulnet.currbuffsize++] = em;
+	// A message of more than ENWINDOW fragments goes once the window is empty
+	pieces = fragments(size);
+	if ( buffered[cls] + pieces > ENBUFFSIZE || credit(dst, cls) < min(pieces, ENWINDOW) ) {
+		countBlocked(src, cls);
+		return EN_WOULDBLOCK;
+	}
 
-	int src = *(int *)(myaddr->addr);
-	int time = par->getcurrtime();
+	if ( par->dropmsg && sendmsg < (int) (par->MSG_DROP_PROB * 100) ) {
+		return EN_DROPPED;
+	}
 
-	assert(src <= MAX_NODES);
-	assert(time < MAX_TIME);
+	sealStale();
+	// The only copy of the payload on its way to the receiver
+	packMessage(myaddr, toaddr, cls, data, size);
+	emulnet.currbuffsize += pieces;
+	buffered[cls] += pieces;
+	inFlight[dst * NUM_CLASSES + cls] += pieces;
+	payloadBytes += size;
 
-	sent_msgs[src][time]++;
+	countMsg(src, true, cls);
 
 	#ifdef DEBUGLOG
 		sprintf(temp, "Sending 4+%d B msg type %d to %d.%d.%d.%d:%d ", size-4, *(int *)data, toaddr->addr[0], toaddr->addr[1], toaddr->addr[2], toaddr->addr[3], *(short *)&toaddr->addr[4]);
@@ -117,6 +157,104 @@ int EmulNet::ENsend(Address *myaddr, Address *toaddr, char *data, int size) {
 	return size;
 }
 
+/**
+ * FUNCTION NAME: ENmulticast
+ *
+ * DESCRIPTION: Sends data as a message of class cls to the count nodes of to,
+ * 				each followed by its own tagSize bytes of tags, the replica type
+ * 				for instance. The payload is copied once into a buffer the
+ * 				destinations share, their frames only carry a reference to it
+ * 				and the tag. Each
+ * 				destination is checked, dropped and counted as if it had its own
+ * 				ENsend, and the egress link is charged the whole message for
+ * 				each. Messages too large for one frame are sent one by one.
+ *
+ * RETURNS:
+ * Number of destinations sent to, the result of each as ENsend would return it
+ * is in results
+ */
+int EmulNet::ENmulticast(Address *myaddr, Address *to, int count, char *data, int size, char *tags, int tagSize, int *results, int cls) {
+	int src = *(int *)(myaddr->addr);
+	MsgBuffer *shared = NULL;
+	int sent = 0;
+
+	if ( src < 0 || size < 0 || tagSize < 0 || cls < 0 || cls >= NUM_CLASSES || fragments(size + tagSize) > 1 ) {
+		return multicastCopies(myaddr, to, count, data, size, tags, tagSize, results, cls);
+	}
+
+	sealStale();
+	for ( int i = 0; i < count; i++ ) {
+		int sendmsg = rand() % 100;
+		int dst = *(int *)(to[i].addr);
+		en_share share;
+
+		if ( NULL == emulnet.getInbox(dst) ) {
+			results[i] = EN_DROPPED;
+			continue;
+		}
+		if ( buffered[cls] >= ENBUFFSIZE || credit(dst, cls) <= 0 ) {
+			countBlocked(src, cls);
+			results[i] = EN_WOULDBLOCK;
+			continue;
+		}
+		if ( par->dropmsg && sendmsg < (int) (par->MSG_DROP_PROB * 100) ) {
+			results[i] = EN_DROPPED;
+			continue;
+		}
+
+		if ( NULL == shared ) {
+			shared = pool.alloc(src, size);
+			memcpy(shared->data(), data, size);
+		}
+		else {
+			shared->retain();
+		}
+		share.buf = shared;
+		share.size = size;
+		share.tagSize = tagSize;
+		packRecord(src, dst, myaddr, &to[i], cls, EN_REC_SHARED, &share, sizeof(share), tags + i * tagSize, tagSize);
+		emulnet.currbuffsize++;
+		buffered[cls]++;
+		inFlight[dst * NUM_CLASSES + cls]++;
+		payloadBytes += size + tagSize;
+		sharedSent++;
+		countMsg(src, true, cls);
+
+		results[i] = size + tagSize;
+		sent++;
+	}
+
+	return sent;
+}
+
+/**
+ * FUNCTION NAME: multicastCopies
+ *
+ * DESCRIPTION: ENmulticast for links that cannot share a payload, one ENsend of
+ * 				the payload and the tag per destination
+ */
+int EmulNet::multicastCopies(Address *myaddr, Address *to, int count, char *data, int size, char *tags, int tagSize, int *results, int cls) {
+	vector<char> message;
+	int sent = 0;
+
+	if ( tagSize > 0 ) {
+		message.assign(data, data + size);
+		message.resize(size + tagSize);
+		data = message.data();
+	}
+	for ( int i = 0; i < count; i++ ) {
+		if ( tagSize > 0 ) {
+			memcpy(data + size, tags + i * tagSize, tagSize);
+		}
+		results[i] = ENsend(myaddr, &to[i], data, size + tagSize, cls);
+		if ( results[i] > 0 ) {
+			sent++;
+		}
+	}
+
+	return sent;
+}
+
 /**
  * FUNCTION NAME: ENsend
  *
@@ -125,51 +263,72 @@ int EmulNet::ENsend(Address *myaddr, Address *toaddr, char *data, int size) {
  * RETURNS:
  * size
  */
-int EmulNet::ENsend(Address *myaddr, Address *toaddr, string data) {
-	char * str = (char *) malloc(data.length() * sizeof(char));
-	memcpy(str, data.c_str(), data.size());
-	int ret = this->ENsend(myaddr, toaddr, str, (data.length() * sizeof(char)));
-	free(str);
-	return ret;
+int EmulNet::ENsend(Address *myaddr, Address *toaddr, const string &data, int cls) {
+	return this->ENsend(myaddr, toaddr, (char *)data.data(), (int)data.size(), cls);
 }
 
 /**
  * FUNCTION NAME: ENrecv
  *
- * DESCRIPTION: EmulNet receive function
+ * DESCRIPTION: Receives the messages of every traffic class
  *
  * RETURN:
  * 0
  */
-int EmulNet::ENrecv(Address *myaddr, int (* enq)(void *, char *, int), struct timeval *t, int times, void *queue){
-	// times is always assumed to be 1
-	int i;
-	char* tmp;
-	int sz;
-	en_msg *emsg;
-
-	for( i = emulnet.currbuffsize - 1; i >= 0; i-- ) {
-		emsg = emulnet.buff[i];
-
-		if ( 0 == strcmp(emsg->to.addr, myaddr->addr) ) {
-			sz = emsg->size;
-			tmp = (char *) malloc(sz * sizeof(char));
-			memcpy(tmp, (char *)(emsg+1), sz);
-
-			emulnet.buff[i] = emulnet.buff[emulnet.currbuffsize-1];
-			emulnet.currbuffsize--;
+int EmulNet::ENrecv(Address *myaddr, int (* enq)(void *, char *, int, MsgBuffer *, char *, int), struct timeval *t, int times, void *queue) {
+	return this->ENrecv(myaddr, enq, t, times, queue, EN_ALL_CLASSES);
+}
 
-			(*enq)(queue, (char *)tmp, sz);
+/**
+ * FUNCTION NAME: ENrecv
+ *
+ * DESCRIPTION: EmulNet receive function. Only the inboxes of myaddr for the
+ * 				classes in the classes mask are visited, most urgent class first.
+ * 				Frames still open towards myaddr are sent first, along with
+ * 				whatever the egress links can take this tick. Messages are
+ * 				handed to enq in the order they were sent, in place, along with
+ * 				the frame holding them. enq owns a reference to the frame.
+ * 				A fragmented message is handed over once its last fragment is
+ * 				in, in a buffer of its own. One sent by ENmulticast is handed
+ * 				over in the payload its destinations share, with its tag as
+ * 				the last two arguments of enq; other messages have none.
+ *
+ * RETURN:
+ * 0
+ */
+int EmulNet::ENrecv(Address *myaddr, int (* enq)(void *, char *, int, MsgBuffer *, char *, int), struct timeval *t, int times, void *queue, int classes) {
+	// times is always assumed to be 1
+	MsgBuffer *frame;
+	int dst = *(int *)(myaddr->addr);
+	int backlog = 0;
 
-			free(emsg);
+	if ( NULL == emulnet.getInbox(dst) ) {
+		return 0;
+	}
 
-			int dst = *(int *)(myaddr->addr);
-			int time = par->getcurrtime();
+	sealStale();
+	sealTo(dst);
+	transmitQueued();
+	deliverDue();
+	expireFragments();
+	for ( int cls = 0; cls < NUM_CLASSES; cls++ ) {
+		backlog += ENWINDOW - credit(dst, cls);
+	}
+	countEntry(dst).backlog = backlog;
+	for ( int cls = 0; cls < NUM_CLASSES; cls++ ) {
+		RingQueue<MsgBuffer *> *inbox = emulnet.getInbox(dst, cls);
 
-			assert(dst <= MAX_NODES);
-			assert(time < MAX_TIME);
+		if ( !(classes & EN_CLASS_MASK(cls)) ) {
+			continue;
+		}
+		while ( !inbox->empty() ) {
+			frame = inbox->front();
+			inbox->pop_front();
 
-			recv_msgs[dst][time]++;
+			int count = unpack(frame, enq, queue);
+			emulnet.currbuffsize -= count;
+			buffered[cls] -= count;
+			inFlight[dst * NUM_CLASSES + cls] -= count;
 		}
 	}
 
@@ -183,38 +342,960 @@ int EmulNet::ENrecv(Address *myaddr, int (* enq)(void *, char *, int), struct ti
  */
 int EmulNet::ENcleanup() {
 	emulnet.nextid=0;
-	int i, j;
-	int sent_total, recv_total;
+	int i;
+	FILE *file = countLog();
+	SlabStats stats;
+	long sentTotal = 0, framesTotal = 0, bytesTotal = 0, rawTotal = 0, codecTotal = 0;
+
+	for ( i = 0; i < (int)openTo.size(); i++ ) {
+		for ( unsigned int j = 0; j < openTo[i].size(); j++ ) {
+			releaseFrame(openTo[i][j].frame);
+		}
+	}
+	openTo.clear();
+	openCount = 0;
+	for ( i = 0; i < (int)egress.size(); i++ ) {
+		while ( !egress[i].empty() ) {
+			releaseFrame(egress[i].front().frame);
+			egress[i].pop_front();
+		}
+	}
+	egressQueued.assign(egressQueued.size(), 0);
+	deficit.assign(deficit.size(), 0);
+	egressBusy.clear();
+	inFlight.clear();
+	memset(buffered, 0, sizeof(buffered));
+	for ( unordered_map<long long, en_reasm>::iterator it = partial.begin(); it != partial.end(); it++ ) {
+		it->second.buf->release();
+	}
+	partial.clear();
+	for ( i = 0; i < (int)emulnet.inbox.size(); i++ ) {
+		while ( !emulnet.inbox[i].empty() ) {
+			releaseFrame(emulnet.inbox[i].front());
+			emulnet.inbox[i].pop_front();
+		}
+	}
+	vector<MsgBuffer *> waiting;
+	wheel.drain(waiting);
+	for ( i = 0; i < (int)waiting.size(); i++ ) {
+		releaseFrame(waiting[i]);
+	}
+	emulnet.currbuffsize = 0;
+
+	for ( i = 1; i < (int)counts.size(); i++ ) {
+		flushCount(i);
+	}
+	fprintf(file, "\n");
+	for ( i = 1; i < (int)counts.size(); i++ ) {
+		fprintf(file, "net %d node %3d sent_total %6ld  recv_total %6ld  frames_total %6ld  bytes_total %8ld  raw_total %8ld  codec_ms %7.2f  blocked_total %6ld  queued_max %5d\n",
+				netid, i, counts[i].sent_total, counts[i].recv_total, counts[i].frames_total, counts[i].bytes_total, counts[i].raw_total,
+				counts[i].codec_ns_total / 1e6, counts[i].blocked_total, counts[i].queued_max);
+		sentTotal += counts[i].sent_total;
+		framesTotal += counts[i].frames_total;
+		bytesTotal += counts[i].bytes_total;
+		rawTotal += counts[i].raw_total;
+		codecTotal += counts[i].codec_ns_total;
+	}
+	fprintf(file, "net %d messages %ld in frames %ld (%.2f per frame)  bytes %ld, %ld with one frame per message\n",
+			netid, sentTotal, framesTotal, framesTotal ? (double)sentTotal / framesTotal : 0.0,
+			bytesTotal, sentTotal * (long)sizeof(en_msg) + payloadBytes);
+	for ( i = 0; i < NUM_CLASSES; i++ ) {
+		ClassCount &count = classCounts[i];
+		fprintf(file, "net %d class %-7s weight %2d  sent %7ld  recv %7ld  frames %6ld  bytes %9ld  blocked %5ld  egress wait avg %5.2f max %3d ticks  queued_max %4d\n",
+				netid, className(i), par->CLASS_WEIGHT[i], count.sent, count.recv, count.frames, count.bytes, count.blocked,
+				count.frames ? (double)count.wait_total / count.frames : 0.0, count.wait_max, count.backlog_max);
+	}
+	if ( NO_COMPRESS != par->COMPRESS ) {
+		fprintf(file, "net %d compressed %ld bytes of frames to %ld (ratio %.2f) in %.2f ms of CPU, %.1f us per tick\n",
+				netid, rawTotal, bytesTotal, bytesTotal ? (double)rawTotal / bytesTotal : 0.0, codecTotal / 1e6,
+				par->getcurrtime() ? codecTotal / 1000.0 / par->getcurrtime() : 0.0);
+	}
+
+	stats = pool.getStats();
+	fprintf(file, "net %d frame allocs %ld  free list hits %ld (%.1f%%)  slab refills %ld  frees %ld  large %ld\n\n",
+			netid, stats.allocs, stats.hits, stats.allocs ? 100.0 * stats.hits / stats.allocs : 0.0,
+			stats.refills, stats.frees, stats.large);
+
+	fflush(file);
+	return 0;
+}
+
+/**
+ * FUNCTION NAME: deliveryTime
+ *
+ * DESCRIPTION: Returns the tick at which a frame of the given size sent at tick sent
+ * 				from src reaches dst. The frame first waits for the egress link of src
+ * 				to drain the frames queued ahead of it, then spends the link delay in
+ * 				flight.
+ */
+int EmulNet::deliveryTime(int src, int dst, int bytes, int sent) {
+	double leave = sent;
+	int bw = par->getEgressBW(src);
+
+	if ( bw > 0 && src >= 0 ) {
+		if ( src >= (int)egressFree.size() ) {
+			egressFree.resize(src + 1, 0);
+		}
+		leave = max(leave, egressFree[src]) + (double)bytes / bw;
+		egressFree[src] = leave;
+	}
+
+	return (int)floor(leave) + sampleDelay(par->getLinkDelay(src, dst));
+}
+
+/**
+ * FUNCTION NAME: sampleDelay
+ *
+ * DESCRIPTION: Draws a link delay in whole ticks from its distribution
+ */
+int EmulNet::sampleDelay(LinkDelay delay) {
+	double u, v, d;
+
+	if ( delay.type == CONST_DELAY ) {
+		return max(0, (int)(delay.a + 0.5));
+	}
+
+	u = (rand() + 1.0) / (RAND_MAX + 2.0);
+	switch ( delay.type ) {
+		case UNIFORM_DELAY:
+			d = floor(delay.a + (delay.b - delay.a + 1) * u);
+			break;
+		case NORMAL_DELAY:
+			v = (rand() + 1.0) / (RAND_MAX + 2.0);
+			d = delay.a + delay.b * sqrt(-2 * log(u)) * cos(2 * M_PI * v) + 0.5;
+			break;
+		case EXP_DELAY:
+			d = -delay.a * log(u) + 0.5;
+			break;
+		default:
+			d = 0;
+			break;
+	}
+	return max(0, (int)d);
+}
+
+/**
+ * FUNCTION NAME: post
+ *
+ * DESCRIPTION: Queues a filled frame sealed at tick sent for the egress link of
+ * 				its source, which sends what it can right away
+ */
+void EmulNet::post(MsgBuffer *frame, int sent) {
+	// Shared payloads are charged as if the frame carried them
+	int shared = sharedBytes(frame);
+	int raw = frame->size + shared;
+	frame = compressFrame(frame);
+	en_msg *em = (en_msg *)frame->data();
+	int src = *(int *)(em->from.addr);
+
+	countFrame(src, em->cls, frame->size + shared, raw);
+	queueEgress(src, em->cls, frame, frame->size + shared, sent);
+	transmit(src);
+	if ( egressQueued[src] > 0 ) {
+		egressBusy.insert(src);
+	}
+}
+
+/**
+ * FUNCTION NAME: queueEgress
+ *
+ * DESCRIPTION: Queues a frame of class cls charged bytes bytes behind the others
+ * 				of its class waiting for the egress link of src
+ */
+void EmulNet::queueEgress(int src, int cls, MsgBuffer *frame, int bytes, int sealed) {
+	en_egress next = {frame, bytes, sealed};
+
+	if ( src >= (int)egressQueued.size() ) {
+		egress.resize((src + 1) * NUM_CLASSES);
+		deficit.resize((src + 1) * NUM_CLASSES, 0);
+		egressTurn.resize(src + 1, 0);
+		egressQueued.resize(src + 1, 0);
+	}
+	egress[src * NUM_CLASSES + cls].push_back(next);
+	egressQueued[src]++;
+}
+
+/**
+ * FUNCTION NAME: nextEgress
+ *
+ * DESCRIPTION: Takes the frame the egress link of src sends next, by deficit round
+ * 				robin over the traffic classes. Each time its turn comes, a class
+ * 				with frames waiting is given CLASS_WEIGHT largest frames worth
+ * 				of bytes and sends from the front of its queue while they last.
+ * 				A class that runs out of frames loses what it had left.
+ *
+ * RETURNS:
+ * false if no frame is waiting
+ */
+bool EmulNet::nextEgress(int src, en_egress *next) {
+	int base = src * NUM_CLASSES;
+
+	if ( src < 0 || src >= (int)egressQueued.size() || 0 == egressQueued[src] ) {
+		return false;
+	}
+	for ( ;; ) {
+		int cls = egressTurn[src];
+		RingQueue<en_egress> &queue = egress[base + cls];
+
+		if ( !queue.empty() && queue.front().bytes <= deficit[base + cls] ) {
+			*next = queue.front();
+			queue.pop_front();
+			deficit[base + cls] -= next->bytes;
+			if ( queue.empty() ) {
+				deficit[base + cls] = 0;
+			}
+			egressQueued[src]--;
+			return true;
+		}
+		if ( queue.empty() ) {
+			deficit[base + cls] = 0;
+		}
+		cls = egressTurn[src] = (cls + 1) % NUM_CLASSES;
+		if ( !egress[base + cls].empty() ) {
+			deficit[base + cls] += par->CLASS_WEIGHT[cls] * maxFrameBytes();
+		}
+	}
+}
+
+/**
+ * FUNCTION NAME: requeueEgress
+ *
+ * DESCRIPTION: Puts back a frame taken by nextEgress that could not be sent, at
+ * 				the front of its class, and gives its class the bytes back
+ */
+void EmulNet::requeueEgress(int src, en_egress &frame) {
+	int cls = ((en_msg *)frame.frame->data())->cls;
+
+	egress[src * NUM_CLASSES + cls].push_front(frame);
+	deficit[src * NUM_CLASSES + cls] += frame.bytes;
+	egressQueued[src]++;
+}
+
+/**
+ * FUNCTION NAME: transmit
+ *
+ * DESCRIPTION: Sends the frames waiting for the egress link of src for as long as
+ * 				the link is free in the current tick, all of them if it has no
+ * 				bandwidth cap
+ */
+void EmulNet::transmit(int src) {
+	int now = par->getcurrtime();
+	int bw = par->getEgressBW(src);
+	en_egress next;
+
+	while ( (bw <= 0 || src >= (int)egressFree.size() || egressFree[src] < now + 1) && nextEgress(src, &next) ) {
+		en_msg *em = (en_msg *)next.frame->data();
+		int dst = *(int *)(em->to.addr);
+		ClassCount &count = classCounts[em->cls];
+		int wait = 0;
+
+		if ( bw > 0 && src < (int)egressFree.size() ) {
+			wait = max(0, (int)floor(egressFree[src]) - next.sealed);
+		}
+		count.wait_total += wait;
+		count.wait_max = max(count.wait_max, wait);
+
+		int deliver = deliveryTime(src, dst, next.bytes, next.sealed);
+		if ( deliver <= now ) {
+			emulnet.getInbox(dst, em->cls)->push_back(next.frame);
+		}
+		else {
+			wheel.schedule(deliver, next.frame);
+		}
+	}
+	for ( int cls = 0; cls < NUM_CLASSES && src < (int)egressQueued.size(); cls++ ) {
+		classCounts[cls].backlog_max = max(classCounts[cls].backlog_max, (int)egress[src * NUM_CLASSES + cls].size());
+	}
+}
+
+/**
+ * FUNCTION NAME: egressWaiting
+ *
+ * DESCRIPTION: Frames of class cls waiting for the egress link of src
+ */
+int EmulNet::egressWaiting(int src, int cls) {
+	if ( src < 0 || src >= (int)egressQueued.size() ) {
+		return 0;
+	}
+	return egress[src * NUM_CLASSES + cls].size();
+}
+
+/**
+ * FUNCTION NAME: transmitQueued
+ *
+ * DESCRIPTION: Lets every egress link with frames waiting send what it can in the
+ * 				current tick
+ */
+void EmulNet::transmitQueued() {
+	set<int>::iterator it = egressBusy.begin();
+
+	while ( it != egressBusy.end() ) {
+		transmit(*it);
+		if ( 0 == egressQueued[*it] ) {
+			egressBusy.erase(it++);
+		}
+		else {
+			it++;
+		}
+	}
+}
+
+/**
+ * FUNCTION NAME: sealTo
+ *
+ * DESCRIPTION: Sends the frames of every class open towards dst
+ */
+void EmulNet::sealTo(int dst) {
+	if ( dst >= (int)openTo.size() ) {
+		return;
+	}
+	for ( unsigned int i = 0; i < openTo[dst].size(); i++ ) {
+		post(openTo[dst][i].frame, openTick);
+	}
+	openCount -= openTo[dst].size();
+	openTo[dst].clear();
+}
+
+/**
+ * FUNCTION NAME: sealStale
+ *
+ * DESCRIPTION: Sends every open frame once the tick they were filled in is over
+ */
+void EmulNet::sealStale() {
+	if ( openTick == par->getcurrtime() ) {
+		return;
+	}
+	if ( openCount > 0 ) {
+		for ( int dst = 0; dst < (int)openTo.size(); dst++ ) {
+			sealTo(dst);
+		}
+	}
+	openTick = par->getcurrtime();
+}
+
+/**
+ * FUNCTION NAME: recordBytes
+ *
+ * DESCRIPTION: Bytes a message of size bytes takes in a frame
+ */
+int EmulNet::recordBytes(int size) {
+	return (sizeof(en_rec) + size + EN_ALIGN - 1) & ~(EN_ALIGN - 1);
+}
+
+/**
+ * FUNCTION NAME: maxFrameBytes
+ *
+ * DESCRIPTION: Largest frame a batch can grow to. A frame takes messages up to
+ * 				MAX_MSG_SIZE, a lone message can go a record header past it.
+ */
+int EmulNet::maxFrameBytes() {
+	return sizeof(en_msg) + recordBytes(par->MAX_MSG_SIZE);
+}
+
+/**
+ * FUNCTION NAME: chunkBytes
+ *
+ * DESCRIPTION: Bytes of a large message carried by each fragment, so that a
+ * 				fragment fills a frame of MAX_MSG_SIZE
+ */
+int EmulNet::chunkBytes() {
+	return ((par->MAX_MSG_SIZE - (int)sizeof(en_msg)) & ~(EN_ALIGN - 1)) - (int)(sizeof(en_rec) + sizeof(en_frag));
+}
+
+/**
+ * FUNCTION NAME: fragments
+ *
+ * DESCRIPTION: Number of records a message of size bytes is sent as
+ */
+int EmulNet::fragments(int size) {
+	if ( size + (int)sizeof(en_msg) < par->MAX_MSG_SIZE ) {
+		return 1;
+	}
+	return (size + chunkBytes() - 1) / chunkBytes();
+}
 
-	FILE* file = fopen("msgcount.log", "w+");
+/**
+ * FUNCTION NAME: openFrame
+ *
+ * DESCRIPTION: Returns the slot of the frame of class cls being filled from src
+ * 				to dst, NULL if none is. packRecord starts and replaces frames
+ * 				through it. The frames open towards dst in one tick are few,
+ * 				so their list is searched in order.
+ */
+MsgBuffer *&EmulNet::openFrame(int src, int dst, int cls) {
+	int from = src * NUM_CLASSES + cls;
+	vector<en_open> *open;
+	en_open added;
 
-	while(emulnet.currbuffsize > 0) {
-		free(emulnet.buff[--emulnet.currbuffsize]);
+	if ( dst >= (int)openTo.size() ) {
+		openTo.resize(dst + 1);
+	}
+	open = &openTo[dst];
+	for ( unsigned int i = 0; i < open->size(); i++ ) {
+		if ( (*open)[i].from == from ) {
+			return (*open)[i].frame;
+		}
 	}
+	added.from = from;
+	added.frame = NULL;
+	open->push_back(added);
+	openCount++;
+	return open->back().frame;
+}
 
-	for ( i = 1; i <= par->EN_GPSZ; i++ ) {
-		fprintf(file, "node %3d ", i);
-		sent_total = 0;
-		recv_total = 0;
+/**
+ * FUNCTION NAME: sealFrame
+ *
+ * DESCRIPTION: Sends a frame that has no room for the next message
+ */
+void EmulNet::sealFrame(MsgBuffer *frame) {
+	post(frame, openTick);
+}
 
-		for (j = 0; j < par->getcurrtime(); j++) {
+/**
+ * FUNCTION NAME: packMessage
+ *
+ * DESCRIPTION: Adds a message to the open frame of class cls from from to to, as
+ * 				one record or as a run of fragments
+ */
+void EmulNet::packMessage(Address *from, Address *to, int cls, char *data, int size) {
+	int src = *(int *)(from->addr);
+	int dst = *(int *)(to->addr);
+	int chunk = chunkBytes();
+	en_frag frag;
+
+	if ( fragments(size) == 1 ) {
+		packRecord(src, dst, from, to, cls, 0, NULL, 0, data, size);
+		return;
+	}
+
+	frag.msgid = nextMsgId++;
+	frag.total = size;
+	for ( frag.offset = 0; frag.offset < size; frag.offset += chunk ) {
+		packRecord(src, dst, from, to, cls, EN_REC_FRAG, &frag, sizeof(frag), data + frag.offset, min(chunk, size - frag.offset));
+	}
+}
 
-			sent_total += sent_msgs[i][j];
-			recv_total += recv_msgs[i][j];
-			if (i != 67) {
-				fprintf(file, " (%4d, %4d)", sent_msgs[i][j], recv_msgs[i][j]);
-				if (j % 10 == 9) {
-					fprintf(file, "\n         ");
-				}
+/**
+ * FUNCTION NAME: packRecord
+ *
+ * DESCRIPTION: Adds a record to the open frame of class cls from src to dst,
+ * 				sealing the frame first if the record would take it past
+ * 				MAX_MSG_SIZE
+ */
+void EmulNet::packRecord(int src, int dst, Address *from, Address *to, int cls, int flags, void *head, int headSize, char *data, int size) {
+	int bytes = recordBytes(headSize + size);
+	MsgBuffer *&frame = openFrame(src, dst, cls);
+
+	if ( NULL != frame && frame->size + bytes > par->MAX_MSG_SIZE ) {
+		sealFrame(frame);
+		frame = NULL;
+	}
+	frame = appendRecord(frame, src, from, to, cls, flags, head, headSize, data, size);
+}
+
+/**
+ * FUNCTION NAME: appendRecord
+ *
+ * DESCRIPTION: Adds a record of headSize bytes of head followed by size bytes of
+ * 				data to frame, which is started when NULL and moved to a bigger
+ * 				buffer when full. head is the en_frag or en_share that flags
+ * 				call for. Returns the frame holding the record.
+ */
+MsgBuffer *EmulNet::appendRecord(MsgBuffer *frame, int src, Address *from, Address *to, int cls, int flags, void *head, int headSize, char *data, int size) {
+	int bytes = recordBytes(headSize + size);
+	en_msg *em;
+	en_rec *rec;
+
+	if ( NULL == frame ) {
+		frame = pool.alloc(src, sizeof(en_msg) + bytes);
+		frame->size = sizeof(en_msg);
+		em = (en_msg *)frame->data();
+		em->size = 0;
+		memcpy(&(em->from.addr), &(from->addr), sizeof(em->from.addr));
+		memcpy(&(em->to.addr), &(to->addr), sizeof(em->to.addr));
+		em->cls = cls;
+		em->pad = 0;
+	}
+	else if ( frame->size + bytes > frame->capacity ) {
+		MsgBuffer *bigger = pool.alloc(src, min(max(2 * frame->capacity, frame->size + bytes), max(maxFrameBytes(), frame->size + bytes)));
+		memcpy(bigger->data(), frame->data(), frame->size);
+		bigger->size = frame->size;
+		frame->release();
+		frame = bigger;
+	}
+
+	em = (en_msg *)frame->data();
+	rec = (en_rec *)(frame->data() + frame->size);
+	rec->size = headSize + size;
+	rec->flags = flags;
+	memcpy(rec + 1, head, headSize);
+	memcpy((char *)(rec + 1) + headSize, data, size);
+	frame->size += bytes;
+	em->size += bytes;
+
+	return frame;
+}
+
+/**
+ * FUNCTION NAME: unpack
+ *
+ * DESCRIPTION: Hands each message of frame to enq along with a reference to the
+ * 				frame, then drops the caller's reference. Fragments go to
+ * 				reassembly instead, a compressed frame is decompressed and
+ * 				unpacked in turn, a multicast message is handed over in the
+ * 				buffer of its payload. A record running past the end of the frame
+ * 				ends it.
+ *
+ * RETURNS:
+ * Number of records in the frame
+ */
+int EmulNet::unpack(MsgBuffer *frame, int (* enq)(void *, char *, int, MsgBuffer *, char *, int), void *queue) {
+	en_msg *emsg = (en_msg *)frame->data();
+	int src = *(int *)(emsg->from.addr);
+	int dst = *(int *)(emsg->to.addr);
+	int cls = emsg->cls;
+	char *next = (char *)(emsg + 1);
+	char *end = next + emsg->size;
+	int count = 0;
+
+	while ( next + sizeof(en_rec) <= end ) {
+		en_rec *rec = (en_rec *)next;
+		if ( rec->size < 0 || next + recordBytes(rec->size) > end ) {
+			break;
+		}
+		if ( rec->flags & EN_REC_ZIP ) {
+			MsgBuffer *inner = NULL;
+			if ( rec->size >= (int)sizeof(en_zip) ) {
+				inner = decompressFrame(frame, (en_zip *)(rec + 1), (char *)(rec + 1) + sizeof(en_zip), rec->size - sizeof(en_zip));
 			}
-			else {
-				fprintf(file, "special %4d %4d %4d\n", j, sent_msgs[i][j], recv_msgs[i][j]);
+			if ( NULL != inner ) {
+				// Credit goes by the records inside
+				count += unpack(inner, enq, queue) - 1;
 			}
 		}
-		fprintf(file, "\n");
-		fprintf(file, "node %3d sent_total %6u  recv_total %6u\n\n", i, sent_total, recv_total);
+		else if ( rec->flags & EN_REC_SHARED ) {
+			if ( rec->size >= (int)sizeof(en_share) ) {
+				deliverShared(dst, cls, (en_share *)(rec + 1), (char *)(rec + 1) + sizeof(en_share), enq, queue);
+			}
+		}
+		else if ( rec->flags & EN_REC_FRAG ) {
+			if ( rec->size >= (int)sizeof(en_frag) ) {
+				reassemble(src, dst, cls, (en_frag *)(rec + 1), (char *)(rec + 1) + sizeof(en_frag), rec->size - sizeof(en_frag), enq, queue);
+			}
+		}
+		else {
+			frame->retain();
+			(*enq)(queue, (char *)(rec + 1), rec->size, frame, NULL, 0);
+			countMsg(dst, false, cls);
+		}
+		next += recordBytes(rec->size);
+		count++;
 	}
+	frame->release();
 
-	fclose(file);
-	return 0;
+	return count;
+}
+
+/**
+ * FUNCTION NAME: reassemble
+ *
+ * DESCRIPTION: Copies a fragment into the buffer of its message, allocated when
+ * 				the first fragment comes in. The buffer goes to enq once every
+ * 				byte of the message is in.
+ */
+void EmulNet::reassemble(int src, int dst, int cls, en_frag *frag, char *data, int size, int (* enq)(void *, char *, int, MsgBuffer *, char *, int), void *queue) {
+	long long key = ((long long)src << 32) | (unsigned int)frag->msgid;
+	unordered_map<long long, en_reasm>::iterator it = partial.find(key);
+
+	if ( it == partial.end() ) {
+		if ( frag->total <= 0 || frag->total > ENMAXMSG ) {
+			return;
+		}
+		en_reasm fresh = {pool.alloc(dst, frag->total), 0, par->getcurrtime()};
+		it = partial.insert(make_pair(key, fresh)).first;
+	}
+
+	en_reasm &r = it->second;
+	if ( frag->total != r.buf->size || frag->offset < 0 || size > r.buf->size - frag->offset ) {
+		return;
+	}
+	memcpy(r.buf->data() + frag->offset, data, size);
+	r.received += size;
+
+	if ( r.received >= r.buf->size ) {
+		MsgBuffer *buf = r.buf;
+		partial.erase(it);
+		(*enq)(queue, buf->data(), buf->size, buf, NULL, 0);
+		countMsg(dst, false, cls);
+	}
+}
+
+/**
+ * FUNCTION NAME: deliverShared
+ *
+ * DESCRIPTION: Hands a message sent by ENmulticast to enq. The shared payload
+ * 				goes with the reference the record held, and the tag, which
+ * 				only holds until enq returns, separately. Nothing is copied
+ * 				per destination.
+ */
+void EmulNet::deliverShared(int dst, int cls, en_share *share, char *tag, int (* enq)(void *, char *, int, MsgBuffer *, char *, int), void *queue) {
+	(*enq)(queue, share->buf->data(), share->size, share->buf, tag, share->tagSize);
+	countMsg(dst, false, cls);
+}
+
+/**
+ * FUNCTION NAME: sharedBytes
+ *
+ * DESCRIPTION: Bytes of the shared payloads frame refers to
+ */
+int EmulNet::sharedBytes(MsgBuffer *frame) {
+	en_msg *em = (en_msg *)frame->data();
+	char *next = (char *)(em + 1);
+	char *end = next + em->size;
+	int bytes = 0;
+
+	if ( 0 == sharedSent ) {
+		return 0;
+	}
+	while ( next + sizeof(en_rec) <= end ) {
+		en_rec *rec = (en_rec *)next;
+		if ( rec->flags & EN_REC_SHARED ) {
+			bytes += ((en_share *)(rec + 1))->size;
+		}
+		next += recordBytes(rec->size);
+	}
+	return bytes;
+}
+
+/**
+ * FUNCTION NAME: releaseFrame
+ *
+ * DESCRIPTION: Drops a frame that will never be unpacked, along with the shared
+ * 				payloads it holds references to
+ */
+void EmulNet::releaseFrame(MsgBuffer *frame) {
+	en_msg *em = (en_msg *)frame->data();
+	char *next = (char *)(em + 1);
+	char *end = next + em->size;
+
+	while ( sharedSent > 0 && next + sizeof(en_rec) <= end ) {
+		en_rec *rec = (en_rec *)next;
+		if ( rec->flags & EN_REC_SHARED ) {
+			((en_share *)(rec + 1))->buf->release();
+		}
+		else if ( rec->flags & EN_REC_ZIP ) {
+			MsgBuffer *inner = decompressFrame(frame, (en_zip *)(rec + 1), (char *)(rec + 1) + sizeof(en_zip), rec->size - sizeof(en_zip));
+			if ( NULL != inner ) {
+				releaseFrame(inner);
+			}
+		}
+		next += recordBytes(rec->size);
+	}
+	frame->release();
+}
+
+/*
+ * CPU time of the calling thread, in ns
+ */
+static long cpuNanos() {
+	struct timespec ts;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+	return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+/**
+ * FUNCTION NAME: compressFrame
+ *
+ * DESCRIPTION: Compresses the records of frame with the codec of Params into one
+ * 				EN_REC_ZIP record. Frames that would not get smaller are sent as
+ * 				they are.
+ *
+ * RETURNS:
+ * The frame to send, frame itself or a compressed copy that replaces it
+ */
+MsgBuffer *EmulNet::compressFrame(MsgBuffer *frame) {
+	en_msg *em = (en_msg *)frame->data();
+	int src = *(int *)(em->from.addr);
+	int header = sizeof(en_msg) + sizeof(en_rec) + sizeof(en_zip);
+	long start;
+
+	if ( NO_COMPRESS == par->COMPRESS || em->size < EN_ZIP_MIN ) {
+		return frame;
+	}
+
+	start = cpuNanos();
+	MsgBuffer *zipped = pool.alloc(src, frame->size);
+	en_msg *zm = (en_msg *)zipped->data();
+	en_rec *rec = (en_rec *)(zm + 1);
+	en_zip *zip = (en_zip *)(rec + 1);
+	int bytes = codec.compress((char *)(em + 1), em->size, (char *)(zip + 1), frame->size - header - EN_ALIGN, LZ_DICT_COMPRESS == par->COMPRESS);
+
+	if ( bytes > 0 ) {
+		memcpy((void *)zm, em, sizeof(en_msg));
+		zm->size = recordBytes(sizeof(en_zip) + bytes);
+		rec->size = sizeof(en_zip) + bytes;
+		rec->flags = EN_REC_ZIP;
+		zip->raw = em->size;
+		zip->codec = par->COMPRESS;
+		zipped->size = sizeof(en_msg) + zm->size;
+		frame->release();
+		frame = zipped;
+	}
+	else {
+		zipped->release();
+	}
+	countCodec(src, cpuNanos() - start);
+
+	return frame;
+}
+
+/**
+ * FUNCTION NAME: decompressFrame
+ *
+ * DESCRIPTION: Rebuilds the frame that compressFrame turned into frame
+ *
+ * RETURNS:
+ * The frame with the original records, NULL if the data does not decode
+ */
+MsgBuffer *EmulNet::decompressFrame(MsgBuffer *frame, en_zip *zip, char *data, int size) {
+	en_msg *em = (en_msg *)frame->data();
+	int dst = *(int *)(em->to.addr);
+	long start = cpuNanos();
+	MsgBuffer *inner;
+
+	if ( zip->raw < 0 || zip->raw > maxFrameBytes() || (LZ_COMPRESS != zip->codec && LZ_DICT_COMPRESS != zip->codec) ) {
+		return NULL;
+	}
+	inner = pool.alloc(dst, sizeof(en_msg) + zip->raw);
+	memcpy(inner->data(), em, sizeof(en_msg));
+	((en_msg *)inner->data())->size = zip->raw;
+	if ( codec.decompress(data, size, inner->data() + sizeof(en_msg), zip->raw, LZ_DICT_COMPRESS == zip->codec) != zip->raw ) {
+		inner->release();
+		inner = NULL;
+	}
+	countCodec(dst, cpuNanos() - start);
+
+	return inner;
+}
+
+/**
+ * FUNCTION NAME: expireFragments
+ *
+ * DESCRIPTION: Drops the messages whose missing fragments are overdue
+ */
+void EmulNet::expireFragments() {
+	unordered_map<long long, en_reasm>::iterator it = partial.begin();
+
+	while ( it != partial.end() ) {
+		if ( par->getcurrtime() - it->second.started > ENREASMTIMEOUT ) {
+			it->second.buf->release();
+			it = partial.erase(it);
+		}
+		else {
+			it++;
+		}
+	}
+}
+
+/**
+ * FUNCTION NAME: credit
+ *
+ * DESCRIPTION: Messages of class cls that can still be sent towards dst before
+ * 				sends block
+ */
+int EmulNet::credit(int dst, int cls) {
+	if ( (dst + 1) * NUM_CLASSES > (int)inFlight.size() ) {
+		inFlight.resize((dst + 1) * NUM_CLASSES, 0);
+	}
+	return ENWINDOW - inFlight[dst * NUM_CLASSES + cls];
+}
+
+/**
+ * FUNCTION NAME: className
+ *
+ * DESCRIPTION: Name of a traffic class in MSGCOUNT_LOG
+ */
+const char *EmulNet::className(int cls) {
+	static const char *names[NUM_CLASSES] = {"control", "client", "bulk"};
+
+	return cls >= 0 && cls < NUM_CLASSES ? names[cls] : "unknown";
+}
+
+/**
+ * FUNCTION NAME: deliverDue
+ *
+ * DESCRIPTION: Moves frames whose delay has passed from the wheel to their inboxes
+ */
+void EmulNet::deliverDue() {
+	vector<MsgBuffer *> due;
+
+	wheel.advance(par->getcurrtime(), due);
+	for ( unsigned int i = 0; i < due.size(); i++ ) {
+		en_msg *emsg = (en_msg *)due[i]->data();
+		emulnet.getInbox(*(int *)(emsg->to.addr), emsg->cls)->push_back(due[i]);
+	}
+}
+
+/**
+ * FUNCTION NAME: countLog
+ *
+ * DESCRIPTION: Returns MSGCOUNT_LOG, truncating it the first time it is used
+ */
+FILE *EmulNet::countLog() {
+	if ( NULL == countFile ) {
+		countFile = fopen(MSGCOUNT_LOG, "w+");
+	}
+	return countFile;
+}
+
+/**
+ * FUNCTION NAME: countEntry
+ *
+ * DESCRIPTION: Returns the counters of node for the current tick. The counts of
+ * 				the previous tick of this node are written out first.
+ */
+MsgCount &EmulNet::countEntry(int node) {
+	int time = par->getcurrtime();
+
+	if ( node >= (int)counts.size() ) {
+		MsgCount zero;
+		memset(&zero, 0, sizeof(zero));
+		counts.resize(node + 1, zero);
+	}
+
+	MsgCount &count = counts[node];
+	if ( count.time != time ) {
+		flushCount(node);
+		count.time = time;
+	}
+	return count;
+}
+
+/**
+ * FUNCTION NAME: countMsg
+ *
+ * DESCRIPTION: Counts a message of class cls sent or received by node in the
+ * 				current tick
+ */
+void EmulNet::countMsg(int node, bool sent, int cls) {
+	if ( node < 0 ) {
+		return;
+	}
+
+	MsgCount &count = countEntry(node);
+	if ( sent ) {
+		count.sent++;
+		count.sent_total++;
+		classCounts[cls].sent++;
+	}
+	else {
+		count.recv++;
+		count.recv_total++;
+		classCounts[cls].recv++;
+	}
+}
+
+/**
+ * FUNCTION NAME: countFrame
+ *
+ * DESCRIPTION: Counts a frame of class cls and bytes bytes sent by node in the
+ * 				current tick
+ */
+void EmulNet::countFrame(int node, int cls, int bytes, int raw) {
+	if ( node < 0 ) {
+		return;
+	}
+
+	classCounts[cls].frames++;
+	classCounts[cls].bytes += bytes;
+
+	MsgCount &count = countEntry(node);
+	count.frames++;
+	count.bytes += bytes;
+	count.raw += raw;
+	count.frames_total++;
+	count.bytes_total += bytes;
+	count.raw_total += raw;
+}
+
+/**
+ * FUNCTION NAME: countBlocked
+ *
+ * DESCRIPTION: Counts a send of class cls of node that would have blocked in the
+ * 				current tick
+ */
+void EmulNet::countBlocked(int node, int cls) {
+	if ( node < 0 ) {
+		return;
+	}
+
+	classCounts[cls].blocked++;
+
+	MsgCount &count = countEntry(node);
+	count.blocked++;
+	count.blocked_total++;
+}
+
+/**
+ * FUNCTION NAME: countCodec
+ *
+ * DESCRIPTION: Adds CPU time a node spent compressing or decompressing frames
+ */
+void EmulNet::countCodec(int node, long ns) {
+	if ( node < 0 ) {
+		return;
+	}
+
+	MsgCount &count = countEntry(node);
+	count.codec_ns += ns;
+	count.codec_ns_total += ns;
+}
+
+/**
+ * FUNCTION NAME: countQueued
+ *
+ * DESCRIPTION: Records how many messages node holds back waiting for credit
+ */
+void EmulNet::countQueued(int node, int depth) {
+	if ( node < 0 ) {
+		return;
+	}
+
+	MsgCount &count = countEntry(node);
+	count.queued = depth;
+	count.queued_max = max(count.queued_max, depth);
+}
+
+/**
+ * FUNCTION NAME: flushCount
+ *
+ * DESCRIPTION: Writes the per tick counts of node to MSGCOUNT_LOG and resets them
+ */
+void EmulNet::flushCount(int node) {
+	MsgCount &count = counts[node];
+
+	if ( count.sent == 0 && count.recv == 0 && count.frames == 0 && count.blocked == 0 && count.queued == 0 ) {
+		return;
+	}
+	fprintf(countLog(), "net %d node %3d time %4d (%4d, %4d) frames %4d bytes %6d raw %6d codec_us %5.1f blocked %4d backlog %4d queued %5d\n",
+			netid, node, count.time, count.sent, count.recv, count.frames, count.bytes, count.raw, count.codec_ns / 1000.0, count.blocked, count.backlog, count.queued);
+	count.sent = 0;
+	count.recv = 0;
+	count.frames = 0;
+	count.bytes = 0;
+	count.raw = 0;
+	count.codec_ns = 0;
+	count.blocked = 0;
+	count.backlog = 0;
+	count.queued = 0;
+}
+
+/**
+ * FUNCTION NAME: getAllocStats
+ *
+ * DESCRIPTION: Returns the frame allocation counters of this EmulNet
+ */
+SlabStats EmulNet::getAllocStats() {
+	return pool.getStats();
 }
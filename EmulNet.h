@@ -7,47 +7,231 @@
 #ifndef _EMULNET_H_
 #define _EMULNET_H_
 
-#define MAX_NODES 1000
-#define MAX_TIME 3600
+// Messages of one traffic class the network holds before sends block
 #define ENBUFFSIZE 30000
+#define MSGCOUNT_LOG "msgcount.log"
+// Messages in a frame start on this boundary
+#define EN_ALIGN 8
+// Messages of one traffic class that may be in flight towards one node before
+// sends to it block
+#define ENWINDOW 512
+// Largest message ENsend takes, messages that do not fit in a frame are fragmented
+#define ENMAXMSG (64 << 20)
+// Ticks a partly received message is kept waiting for its missing fragments
+#define ENREASMTIMEOUT 20
+// en_rec flags
+#define EN_REC_FRAG 1
+#define EN_REC_ZIP 2
+#define EN_REC_SHARED 4
+// Frames with fewer bytes of messages are sent as they are
+#define EN_ZIP_MIN 64
+// ENrecv masks of traffic classes
+#define EN_CLASS_MASK(c) (1 << (c))
+#define EN_ALL_CLASSES ((1 << NUM_CLASSES) - 1)
+
+// ENsend results other than the number of bytes sent
+// lost on the way, like on a real network
+#define EN_DROPPED 0
+// no credit towards the destination or no room in the network, send again later
+#define EN_WOULDBLOCK -1
+// larger than ENMAXMSG, can never be sent
+#define EN_TOOBIG -2
 
 #include "stdincludes.h"
 #include "Params.h"
 #include "Member.h"
+#include "MsgBuffer.h"
+#include "SlabAllocator.h"
+#include "TimingWheel.h"
+#include "RingQueue.h"
+#include "LZCodec.h"
 
 using namespace std;
 
 /**
  * Struct Name: en_msg
+ *
+ * DESCRIPTION: Header at the start of every frame, followed by one en_rec per
+ * 				message the frame carries
  */
 typedef struct en_msg {
-	// Number of bytes after the class
+	// Number of bytes after the header
 	int size;
 	// Source node
 	Address from;
 	// Destination node
 	Address to;
+	// Traffic class of every message in the frame
+	int cls;
+	// Keeps the records EN_ALIGN aligned
+	int pad;
 }en_msg;
 
+/**
+ * Struct Name: en_rec
+ *
+ * DESCRIPTION: Header of one message in a frame, followed by the message and
+ * 				padding up to EN_ALIGN
+ */
+typedef struct en_rec {
+	// Number of bytes of the message
+	int size;
+	// EN_REC_FRAG if the message is an en_frag and a piece of a larger message,
+	// EN_REC_ZIP if it is an en_zip holding the records of the frame,
+	// EN_REC_SHARED if it is an en_share standing for a multicast payload
+	int flags;
+}en_rec;
+
+/**
+ * Struct Name: en_share
+ *
+ * DESCRIPTION: Header of a message sent by ENmulticast, followed by the tag of
+ * 				its destination. The payload stays in buf, shared by every
+ * 				destination, and the message is the payload followed by the tag.
+ */
+typedef struct en_share {
+	// Holds the payload, the record owns one reference to it
+	MsgBuffer *buf;
+	int size;
+	int tagSize;
+}en_share;
+
+/**
+ * Struct Name: en_zip
+ *
+ * DESCRIPTION: Header of the one record of a compressed frame, followed by the
+ * 				other records of the frame as compressed by codec
+ */
+typedef struct en_zip {
+	// Number of bytes of the records once decompressed
+	int raw;
+	// LZ_COMPRESS or LZ_DICT_COMPRESS, the receiver decodes whichever it finds
+	int codec;
+}en_zip;
+
+/**
+ * Struct Name: en_frag
+ *
+ * DESCRIPTION: Header of a piece of a message too large for one frame, followed
+ * 				by the bytes of the message starting at offset
+ */
+typedef struct en_frag {
+	// Tells the messages of a sender apart
+	int msgid;
+	int offset;
+	// Number of bytes of the whole message
+	int total;
+}en_frag;
+
+/**
+ * Struct Name: en_reasm
+ *
+ * DESCRIPTION: A message being put together from its fragments
+ */
+typedef struct en_reasm {
+	// Holds the whole message, fragments are copied in as they come
+	MsgBuffer *buf;
+	int received;
+	// Tick the first fragment came in
+	int started;
+}en_reasm;
+
+/**
+ * Struct Name: en_egress
+ *
+ * DESCRIPTION: A sealed frame waiting for the egress link of its source
+ */
+typedef struct en_egress {
+	MsgBuffer *frame;
+	// Bytes the link is charged for the frame, shared payloads included
+	int bytes;
+	// Tick the frame was sealed in
+	int sealed;
+}en_egress;
+
+/**
+ * Struct Name: en_open
+ *
+ * DESCRIPTION: A frame being filled with the messages of this tick
+ */
+typedef struct en_open {
+	// Source and class of the frame, as src * NUM_CLASSES + class
+	int from;
+	MsgBuffer *frame;
+}en_open;
+
+/**
+ * Struct Name: ClassCount
+ *
+ * DESCRIPTION: Counters of one traffic class over the whole run, all nodes
+ * 				together
+ */
+typedef struct ClassCount {
+	long sent;
+	long recv;
+	long frames;
+	long bytes;
+	long blocked;
+	// Ticks the frames waited for their egress link, summed and the longest
+	long wait_total;
+	int wait_max;
+	// Most frames of the class ever waiting for the egress link of one node
+	int backlog_max;
+} ClassCount;
+
+/**
+ * Struct Name: MsgCount
+ *
+ * DESCRIPTION: Message counters of one node. Only the tick currently being
+ * 				counted is kept, earlier ticks have been written to MSGCOUNT_LOG.
+ */
+typedef struct MsgCount {
+	// Tick that sent and recv belong to
+	int time;
+	int sent;
+	int recv;
+	// Frames sent and their bytes, headers included
+	int frames;
+	int bytes;
+	// Bytes of the frames sent before compression
+	int raw;
+	// CPU time spent compressing and decompressing, in ns
+	long codec_ns;
+	// Sends that would have blocked
+	int blocked;
+	// Messages in flight towards the node when it last received
+	int backlog;
+	// Messages the node holds back for lack of credit, as it reports them
+	int queued;
+	long sent_total;
+	long recv_total;
+	long frames_total;
+	long bytes_total;
+	long raw_total;
+	long codec_ns_total;
+	long blocked_total;
+	int queued_max;
+} MsgCount;
+
 /**
  * Class Name: EM
+ *
+ * DESCRIPTION: In-flight messages, kept in one FIFO inbox per destination node and
+ * 				traffic class. The inboxes of a node are indexed by the integer id
+ * 				ENinit assigned to it.
  */
 class EM {
 public:
 	int nextid;
 	int currbuffsize;
 	int firsteltindex;
-	en_msg* buff[ENBUFFSIZE];
+	vector< RingQueue<MsgBuffer *> > inbox;
 	EM() {}
 	EM& operator = (EM &anotherEM) {
 		this->nextid = anotherEM.getNextId();
 		this->currbuffsize = anotherEM.getCurrBuffSize();
 		this->firsteltindex = anotherEM.getFirstEltIndex();
-		int i = this->currbuffsize;
-		while (i > 0) {
-			this->buff[i] = anotherEM.buff[i];
-			i--;
-		}
+		this->inbox = anotherEM.inbox;
 		return *this;
 	}
 	int getNextId() {
@@ -68,32 +252,135 @@ public:
 	void setFirstEltIndex(int firsteltindex) {
 		this->firsteltindex = firsteltindex;
 	}
+	// Inbox of class cls of node id, created on first use since a node may be
+	// addressed on an EmulNet it never called ENinit on
+	RingQueue<MsgBuffer *> *getInbox(int id, int cls = CONTROL_CLASS) {
+		if ( id < 0 || cls < 0 || cls >= NUM_CLASSES ) {
+			return NULL;
+		}
+		if ( (id + 1) * NUM_CLASSES > (int)inbox.size() ) {
+			inbox.resize((id + 1) * NUM_CLASSES);
+		}
+		return &inbox[id * NUM_CLASSES + cls];
+	}
 	virtual ~EM() {}
 };
 
 /**
  * CLASS NAME: EmulNet
  *
- * DESCRIPTION: This class defines an emulated network
+ * DESCRIPTION: This class defines an emulated network. Every message belongs to
+ * 				a traffic class, so one network carries the membership protocol
+ * 				and the KV store side by side. Frames, credit and inboxes are kept
+ * 				per class, and a busy egress link is shared by the classes by
+ * 				deficit round robin in proportion to CLASS_WEIGHT, so bulk
+ * 				traffic can neither block nor starve control messages.
  */
 class EmulNet
 { 	
-private:
+protected:
 	Params* par;
-	int sent_msgs[MAX_NODES + 1][MAX_TIME];
-	int recv_msgs[MAX_NODES + 1][MAX_TIME];
+	// Counters indexed by node id, grown as nodes show up
+	vector<MsgCount> counts;
+	// Tags the lines this EmulNet writes to MSGCOUNT_LOG
+	int netid;
 	int enInited;
 	EM emulnet;
+	// Frames are carved from here. Not shared with copies of this EmulNet,
+	// frames already in flight keep returning to the allocator they came from.
+	SlabAllocator pool;
+	// Frames waiting for their link delay to pass
+	TimingWheel<MsgBuffer *> wheel;
+	// Time at which the egress link of each node is free again, in ticks
+	vector<double> egressFree;
+	// Frames sealed and waiting for the egress link, by (src, class)
+	vector< RingQueue<en_egress> > egress;
+	// Bytes each (src, class) may still send in the current round
+	vector<int> deficit;
+	// Class the egress link of each node is serving
+	vector<int> egressTurn;
+	// Frames waiting for the egress link of each node
+	vector<int> egressQueued;
+	// Nodes with frames waiting for their egress link
+	set<int> egressBusy;
+	// Frames being filled with the messages of this tick, by destination. A list
+	// is emptied when its frames go but keeps its room, so opening frames
+	// allocates nothing once every destination has had its busiest tick.
+	vector< vector<en_open> > openTo;
+	// Frames in openTo
+	int openCount;
+	// Tick the open frames were started in
+	int openTick;
+	// Bytes of the messages sent, for the saving coalescing brings
+	long payloadBytes;
+	// Messages sent towards each node and not received yet, by (node, class)
+	vector<int> inFlight;
+	// Messages of each class in the network, against ENBUFFSIZE
+	int buffered[NUM_CLASSES];
+	ClassCount classCounts[NUM_CLASSES];
+	// Id of the next fragmented message sent
+	int nextMsgId;
+	// Messages being reassembled, by (src, msgid)
+	unordered_map<long long, en_reasm> partial;
+	LZCodec codec;
+	// Messages ever sent by reference to a shared payload, frames are only
+	// searched for them once there are some
+	long sharedSent;
+
+	int deliveryTime(int src, int dst, int bytes, int sent);
+	int sampleDelay(LinkDelay delay);
+	void deliverDue();
+	void post(MsgBuffer *frame, int sent);
+	void queueEgress(int src, int cls, MsgBuffer *frame, int bytes, int sealed);
+	bool nextEgress(int src, en_egress *next);
+	void requeueEgress(int src, en_egress &frame);
+	void transmit(int src);
+	void transmitQueued();
+	int egressWaiting(int src, int cls);
+	void sealTo(int dst);
+	void sealStale();
+	static int recordBytes(int size);
+	int maxFrameBytes();
+	int chunkBytes();
+	int fragments(int size);
+	virtual MsgBuffer *&openFrame(int src, int dst, int cls);
+	virtual void sealFrame(MsgBuffer *frame);
+	void packMessage(Address *from, Address *to, int cls, char *data, int size);
+	void packRecord(int src, int dst, Address *from, Address *to, int cls, int flags, void *head, int headSize, char *data, int size);
+	MsgBuffer *appendRecord(MsgBuffer *frame, int src, Address *from, Address *to, int cls, int flags, void *head, int headSize, char *data, int size);
+	int unpack(MsgBuffer *frame, int (* enq)(void *, char *, int, MsgBuffer *, char *, int), void *queue);
+	void reassemble(int src, int dst, int cls, en_frag *frag, char *data, int size, int (* enq)(void *, char *, int, MsgBuffer *, char *, int), void *queue);
+	void expireFragments();
+	MsgBuffer *compressFrame(MsgBuffer *frame);
+	MsgBuffer *decompressFrame(MsgBuffer *frame, en_zip *zip, char *data, int size);
+	int sharedBytes(MsgBuffer *frame);
+	void deliverShared(int dst, int cls, en_share *share, char *tag, int (* enq)(void *, char *, int, MsgBuffer *, char *, int), void *queue);
+	void releaseFrame(MsgBuffer *frame);
+	int multicastCopies(Address *myaddr, Address *to, int count, char *data, int size, char *tags, int tagSize, int *results, int cls);
+	int credit(int dst, int cls);
+	static const char *className(int cls);
+	MsgCount &countEntry(int node);
 public:
  	EmulNet(Params *p);
  	EmulNet(EmulNet &anotherEmulNet);
  	EmulNet& operator = (EmulNet &anotherEmulNet);
  	virtual ~EmulNet();
-	void *ENinit(Address *myaddr, short port);
-	int ENsend(Address *myaddr, Address *toaddr, string data);
+	virtual void *ENinit(Address *myaddr, short port);
+	int ENsend(Address *myaddr, Address *toaddr, const string &data, int cls = CLIENT_CLASS);
 	int ENsend(Address *myaddr, Address *toaddr, char *data, int size);
-	int ENrecv(Address *myaddr, int (* enq)(void *, char *, int), struct timeval *t, int times, void *queue);
-	int ENcleanup();
+	virtual int ENsend(Address *myaddr, Address *toaddr, char *data, int size, int cls);
+	virtual int ENmulticast(Address *myaddr, Address *to, int count, char *data, int size, char *tags, int tagSize, int *results, int cls);
+	int ENrecv(Address *myaddr, int (* enq)(void *, char *, int, MsgBuffer *, char *, int), struct timeval *t, int times, void *queue);
+	virtual int ENrecv(Address *myaddr, int (* enq)(void *, char *, int, MsgBuffer *, char *, int), struct timeval *t, int times, void *queue, int classes);
+	virtual int ENcleanup();
+	FILE *countLog();
+	void countMsg(int node, bool sent, int cls);
+	void countFrame(int node, int cls, int bytes, int raw);
+	void countBlocked(int node, int cls);
+	void countCodec(int node, long ns);
+	void countQueued(int node, int depth);
+	void flushCount(int node);
+	SlabStats getAllocStats();
 };
 
 #endif /* _EMULNET_H_ */
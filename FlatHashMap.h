@@ -0,0 +1,327 @@
+/**********************************
+ * FILE NAME: FlatHashMap.h
+ *
+ * DESCRIPTION: Open addressing hash map from strings, Robin Hood probing
+ **********************************/
+
+#ifndef FLATHASHMAP_H_
+#define FLATHASHMAP_H_
+
+#include "stdincludes.h"
+
+/*
+ * Macros
+ */
+// Slots of an empty map, a power of two
+#define FLAT_MIN_SLOTS 16
+// The map grows once more than FLAT_LOAD_NUM / FLAT_LOAD_DEN of its slots are used
+#define FLAT_LOAD_NUM 7
+#define FLAT_LOAD_DEN 8
+// Longest probe distance a slot records, the map grows before any gets longer.
+// At most 255, tests give a smaller one at build time.
+#ifndef FLAT_MAX_DIST
+#define FLAT_MAX_DIST 255
+#endif
+
+/**
+ * CLASS NAME: FlatHashMap
+ *
+ * DESCRIPTION: Keys and values live in one array of slots, next to a second array
+ * 				holding a word per slot: the top 24 bits of the hash of the key,
+ * 				and in the low byte 1 + how far the key is from the slot it hashes
+ * 				to, 0 for an empty slot. Lookups scan the words and only compare
+ * 				keys whose word matches, which takes one cache line for most.
+ * 				A key being inserted takes the slot of any key nearer to its own
+ * 				home slot, and that key moves on (Robin Hood), which keeps probes
+ * 				short and lets a lookup stop at the first key nearer home than it
+ * 				would be. Erasing shifts the keys after it back a slot, so there
+ * 				are no tombstones. Lookups take a string_view, so neither a
+ * 				string nor a copy of the key is needed to search.
+ * 				Iteration visits the entries in no particular order. Inserting
+ * 				or erasing invalidates iterators and pointers to values.
+ */
+template <class V>
+class FlatHashMap {
+public:
+	typedef pair<string, V> value_type;
+
+	/**
+	 * CLASS NAME: iterator
+	 *
+	 * DESCRIPTION: Walks the used slots
+	 */
+	class iterator {
+	private:
+		friend class FlatHashMap;
+		FlatHashMap *map;
+		size_t pos;
+
+		void skip() {
+			while ( pos < map->meta.size() && 0 == map->meta[pos] ) {
+				pos++;
+			}
+		}
+	public:
+		iterator(): map(NULL), pos(0) {}
+		iterator(FlatHashMap *map, size_t pos): map(map), pos(pos) {
+			skip();
+		}
+		value_type &operator *() {
+			return map->slots[pos];
+		}
+		value_type *operator ->() {
+			return &map->slots[pos];
+		}
+		iterator &operator ++() {
+			pos++;
+			skip();
+			return *this;
+		}
+		iterator operator ++(int) {
+			iterator before = *this;
+			++*this;
+			return before;
+		}
+		bool operator ==(const iterator &other) const {
+			return pos == other.pos;
+		}
+		bool operator !=(const iterator &other) const {
+			return pos != other.pos;
+		}
+	};
+
+private:
+	vector<uint32_t> meta;
+	vector<value_type> slots;
+	size_t used;
+
+	static size_t hash(string_view key) {
+		return std::hash<string_view>()(key);
+	}
+
+	// Word of a key with hash h at distance dist - 1 from its home slot
+	static uint32_t word(size_t h, uint32_t dist) {
+		return (uint32_t)(h >> (8 * sizeof(size_t) - 24)) << 8 | dist;
+	}
+
+	// Slot holding key, or the number of slots if there is none
+	size_t locate(string_view key) const {
+		size_t mask = meta.size() - 1;
+		size_t h = hash(key);
+		size_t pos = h & mask;
+		uint32_t want = word(h, 1);
+
+		for ( uint32_t dist = 1; dist <= FLAT_MAX_DIST; dist++, want++ ) {
+			uint32_t m = meta[pos];
+			if ( 0 == m || (m & 0xff) < dist ) {
+				// A key that far from home would have taken this slot
+				break;
+			}
+			if ( m == want && slots[pos].first == key ) {
+				return pos;
+			}
+			pos = (pos + 1) & mask;
+		}
+		return meta.size();
+	}
+
+	// Puts a key known not to be in the map in its place. Returns the slot it
+	// went to, or the number of slots if the map had to grow meanwhile.
+	size_t place(value_type &&entry, size_t h) {
+		size_t mask = meta.size() - 1;
+		size_t pos = h & mask;
+		size_t landed = meta.size();
+		uint32_t carried = word(h, 1);
+
+		for ( ;; ) {
+			uint32_t m = meta[pos];
+			if ( 0 == m ) {
+				meta[pos] = carried;
+				slots[pos] = std::move(entry);
+				return landed < meta.size() ? landed : pos;
+			}
+			if ( (m & 0xff) < (carried & 0xff) ) {
+				// The resident is nearer home, it moves on instead
+				std::swap(meta[pos], carried);
+				std::swap(slots[pos], entry);
+				if ( landed == meta.size() ) {
+					landed = pos;
+				}
+			}
+			pos = (pos + 1) & mask;
+			if ( (carried & 0xff) == FLAT_MAX_DIST ) {
+				// No room within reach, whatever is carried is placed anew
+				rehash(meta.size() * 2);
+				place(std::move(entry), hash(entry.first));
+				return meta.size();
+			}
+			carried++;
+		}
+	}
+
+	// Adds a key known not to be in the map, returns its slot
+	size_t add(string_view key, V &&value) {
+		size_t pos;
+
+		grow();
+		pos = place(value_type(string(key), std::move(value)), hash(key));
+		used++;
+		return pos < meta.size() ? pos : locate(key);
+	}
+
+	// Empties slot pos and shifts the keys probed past it one slot back
+	void eraseAt(size_t pos) {
+		size_t mask = meta.size() - 1;
+		size_t next;
+
+		for ( next = (pos + 1) & mask; (meta[next] & 0xff) > 1; next = (next + 1) & mask ) {
+			meta[pos] = meta[next] - 1;
+			slots[pos] = std::move(slots[next]);
+			pos = next;
+		}
+		meta[pos] = 0;
+		slots[pos] = value_type();
+		used--;
+	}
+
+	void rehash(size_t count) {
+		vector<uint32_t> oldMeta(count, 0);
+		vector<value_type> oldSlots(count);
+
+		oldMeta.swap(meta);
+		oldSlots.swap(slots);
+		for ( size_t i = 0; i < oldMeta.size(); i++ ) {
+			if ( 0 != oldMeta[i] ) {
+				place(std::move(oldSlots[i]), hash(oldSlots[i].first));
+			}
+		}
+	}
+
+	// Makes room for one more key
+	void grow() {
+		if ( (used + 1) * FLAT_LOAD_DEN > meta.size() * FLAT_LOAD_NUM ) {
+			rehash(meta.size() * 2);
+		}
+	}
+
+public:
+	FlatHashMap(): meta(FLAT_MIN_SLOTS, 0), slots(FLAT_MIN_SLOTS), used(0) {}
+
+	/**
+	 * FUNCTION NAME: find
+	 *
+	 * DESCRIPTION: Returns the entry of key, end() if key is not in the map
+	 */
+	iterator find(string_view key) {
+		return iterator(this, locate(key));
+	}
+
+	/**
+	 * FUNCTION NAME: try_emplace
+	 *
+	 * DESCRIPTION: Adds key with value unless key is already in the map, in which
+	 * 				case value is left as it was. One lookup either way.
+	 *
+	 * RETURNS:
+	 * The entry of key, and true if it was added
+	 */
+	pair<iterator, bool> try_emplace(string_view key, V &&value) {
+		size_t pos = locate(key);
+
+		if ( pos < meta.size() ) {
+			return make_pair(iterator(this, pos), false);
+		}
+		return make_pair(iterator(this, add(key, std::move(value))), true);
+	}
+
+	/**
+	 * FUNCTION NAME: operator []
+	 *
+	 * DESCRIPTION: Returns the value of key, added with a default value if key is
+	 * 				not in the map
+	 */
+	V &operator [](string_view key) {
+		size_t pos = locate(key);
+
+		if ( pos == meta.size() ) {
+			pos = add(key, V());
+		}
+		return slots[pos].second;
+	}
+
+	/**
+	 * FUNCTION NAME: erase
+	 *
+	 * DESCRIPTION: Removes key and shifts the keys probed past it one slot back
+	 *
+	 * RETURNS:
+	 * Number of keys removed, 0 or 1
+	 */
+	size_t erase(string_view key) {
+		size_t pos = locate(key);
+
+		if ( pos == meta.size() ) {
+			return 0;
+		}
+		eraseAt(pos);
+		return 1;
+	}
+
+	/**
+	 * FUNCTION NAME: erase
+	 *
+	 * DESCRIPTION: Removes the entry at it, found earlier without a second lookup
+	 */
+	void erase(iterator it) {
+		eraseAt(it.pos);
+	}
+
+	size_t count(string_view key) const {
+		return locate(key) < meta.size() ? 1 : 0;
+	}
+
+	size_t size() const {
+		return used;
+	}
+
+	bool empty() const {
+		return 0 == used;
+	}
+
+	// Number of slots, used or not
+	size_t bucket_count() const {
+		return meta.size();
+	}
+
+	void clear() {
+		vector<uint32_t>(FLAT_MIN_SLOTS, 0).swap(meta);
+		vector<value_type>(FLAT_MIN_SLOTS).swap(slots);
+		used = 0;
+	}
+
+	/**
+	 * FUNCTION NAME: reserve
+	 *
+	 * DESCRIPTION: Makes room for count keys without growing again
+	 */
+	void reserve(size_t count) {
+		size_t slotsNeeded = FLAT_MIN_SLOTS;
+
+		while ( count * FLAT_LOAD_DEN > slotsNeeded * FLAT_LOAD_NUM ) {
+			slotsNeeded *= 2;
+		}
+		if ( slotsNeeded > meta.size() ) {
+			rehash(slotsNeeded);
+		}
+	}
+
+	iterator begin() {
+		return iterator(this, 0);
+	}
+
+	iterator end() {
+		return iterator(this, meta.size());
+	}
+};
+
+#endif /* FLATHASHMAP_H_ */
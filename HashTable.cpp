@@ -13,37 +13,40 @@ HashTable::~HashTable() {}
 /**
  * FUNCTION NAME: create
  *
- * DESCRIPTION: This function inserts they (key,value) pair into the local hash table
+ * DESCRIPTION: This function inserts they (key,value) pair into the local hash table.
+ * 				value is moved in, and left as it was if the key is already there.
  *
  * RETURNS:
- * true on SUCCESS
- * false in FAILURE
+ * the stored value if the key was added
+ * NULL if the key was already there
  */
-bool HashTable::create(string key, string value) {
-	hashTable.emplace(key, value);
-	return true;
+const string *HashTable::create(string_view key, string &&value) {
+	pair<FlatHashMap<string>::iterator, bool> ret = hashTable.try_emplace(key, std::move(value));
+
+	return ret.second ? &ret.first->second : NULL;
 }
 
 /**
  * FUNCTION NAME: read
  *
- * DESCRIPTION: This function searches for the key in the hash table
+ * DESCRIPTION: This function searches for the key in the hash table. The value is
+ * 				not copied, the reference holds until the table changes.
  *
  * RETURNS:
  * string value if found
- * else it returns a NULL
+ * else it returns an empty string
  */
-string HashTable::read(string key) {
-	map<string, string>::iterator search;
+const string &HashTable::read(string_view key) {
+	static const string notFound;
+	FlatHashMap<string>::iterator search = hashTable.find(key);
 
-	search = hashTable.find(key);
 	if ( search != hashTable.end() ) {
 		// Value found
 		return search->second;
 	}
 	else {
 		// Value not found
-		return "";
+		return notFound;
 	}
 }
 
@@ -51,22 +54,22 @@ string HashTable::read(string key) {
  * FUNCTION NAME: update
  *
  * DESCRIPTION: This function updates the given key with the updated value passed in
- * 				if the key is found
+ * 				if the key is found. The value is assigned in place, reusing the
+ * 				capacity of the old one.
  *
  * RETURNS:
  * true on SUCCESS
  * false on FAILURE
  */
-bool HashTable::update(string key, string newValue) {
-	map<string, string>::iterator update;
+bool HashTable::update(string_view key, string_view newValue) {
+	FlatHashMap<string>::iterator update = hashTable.find(key);
 
-	if (read(key).empty()) {
+	if ( update == hashTable.end() || update->second.empty() ) {
 		// Key not found
 		return false;
 	}
 	// Key found
-	//update = hashTable.at(key) = newValue;
-	hashTable.at(key) = newValue;
+	update->second.assign(newValue);
 	// Update successful
 	return true;
 }
@@ -80,18 +83,15 @@ bool HashTable::update(string key, string newValue) {
  * true on SUCCESS
  * false on FAILURE
  */
-bool HashTable::deleteKey(string key) {
-	uint eraseCount = 0;
+bool HashTable::deleteKey(string_view key) {
+	FlatHashMap<string>::iterator value = hashTable.find(key);
 
-	if (read(key).empty()) {
+	if ( value == hashTable.end() || value->second.empty() ) {
 		// Key not found
 		return false;
 	}
-	eraseCount = hashTable.erase(key);
-	if ( eraseCount < 1 ) {
-		// Could not erase
-		return false;
-	}
+	// Erased where it was found, without a second lookup
+	hashTable.erase(value);
 	// Delete was successful
 	return true;
 }
@@ -138,7 +138,7 @@ void HashTable::clear() {
  * RETURNS:
  * unsigned long count (Should be always 1)
  */
-unsigned long HashTable::count(string key) {
+unsigned long HashTable::count(string_view key) {
 	return (unsigned long) hashTable.count(key);
 }
 
@@ -13,26 +13,30 @@
 #include "stdincludes.h"
 #include "common.h"
 #include "Entry.h"
+#include "FlatHashMap.h"
 
 /**
  * CLASS NAME: HashTable
  *
- * DESCRIPTION: This class is a wrapper to the map provided by C++ STL.
+ * DESCRIPTION: This class is a wrapper to a FlatHashMap from keys to values.
+ * 				Keys are looked up by string_view, created values are moved in
+ * 				and updates are assigned in place, so an operation copies
+ * 				neither, and a read hands out the stored value by reference.
  *
  */
 class HashTable {
 public:
-	map<string, string> hashTable;
+	FlatHashMap<string> hashTable;
 //public:
 	HashTable();
-	bool create(string key, string value);
-	string read(string key);
-	bool update(string key, string newValue);
-	bool deleteKey(string key);
+	const string *create(string_view key, string &&value);
+	const string &read(string_view key);
+	bool update(string_view key, string_view newValue);
+	bool deleteKey(string_view key);
 	bool isEmpty();
 	unsigned long currentSize();
 	void clear();
-	unsigned long count(string key);
+	unsigned long count(string_view key);
 	virtual ~HashTable();
 };
 
@@ -0,0 +1,339 @@
+/**********************************
+ * FILE NAME: LZCodec.cpp
+ *
+ * DESCRIPTION: Definition of the LZ77 frame codec
+ **********************************/
+
+#include "LZCodec.h"
+
+/*
+ * Dictionary trained on the payloads of a run of the four KV store test
+ * cases, see train
+ */
+static const char lzDictionary[] =
+	"-1::6:0::0::sZ0Ld::value34::3276-1::10:0::0::D2MDe::value97::327"
+	"-1::6:0::0::BGqQP::value76::3276-1::10:0::0::51fcb::value78::327"
+	"-1::8:0::0::NNNjO::value48::3276-1::8:0::0::HNsBs::value29::3276"
+	"-1::8:0::0::M984W::value88::3276-1::7:0::0::pJuNV::value99::3276"
+	"-1::4:0::0::FWe6u::value11::3276-1::1:0::0::1urXZ::value69::3276"
+	"-1::2:0::0::WhnBh::value81::3276-1::4:0::0::qhT44::value12::3276"
+	"-1::8:0::0::SPXCS::value93::3276-1::6:0::0::HVlkz::value70::3276"
+	"-1::6:0::0::7fT5x::value58::3276-1::8:0::0::5CJfD::value6::32767"
+	"-1::10:0::0::ZFyAT::value55::327-1::3:0::0::3lFbJ::value37::3276"
+	"-1::10:0::0::FflfA::value57::327-1::6:0::0::200Hd::value21::3276"
+	"-1::5:0::0::4eXHW::value4::32767-1::6:0::0::fIjP3::value98::3276"
+	"-1::8:0::0::NteT8::value33::3276-1::10:0::0::iXPsX::value7::3276"
+	"-1::2:0::0::CN3Ci::value19::3276-1::9:0::0::kESS9::value53::3276"
+	"-1::5:0::0::nTZxH::value15::32761::2:0::0::zAAEm::value67::32765"
+	"-1::4:0::0::bcJEE::value96::3276-1::10:0::0::zQxGe::value41::327"
+	"-1::6:0::0::DTkPO::value52::3276-1::8:0::0::Yt2jx::value8::32767";
+
+/**
+ * Constructor
+ */
+LZCodec::LZCodec() {
+	table.assign(1 << LZ_HASH_BITS, -1);
+	base = 0;
+	setDictionary(builtinDictionary());
+}
+
+/**
+ * FUNCTION NAME: setDictionary
+ *
+ * DESCRIPTION: Replaces the dictionary. Both ends of a link must use the same one.
+ */
+void LZCodec::setDictionary(const string &dict) {
+	this->dict = dict;
+	dictTable.assign(1 << LZ_HASH_BITS, 0);
+	for ( int i = 0; i + LZ_MINMATCH <= (int)dict.size(); i++ ) {
+		// Later positions win, they are nearer to the input
+		dictTable[hash(dict.data() + i)] = i + 1;
+	}
+}
+
+/**
+ * FUNCTION NAME: builtinDictionary
+ *
+ * DESCRIPTION: The dictionary every LZCodec starts with
+ */
+const string &LZCodec::builtinDictionary() {
+	static const string dict(lzDictionary, sizeof(lzDictionary) - 1);
+	return dict;
+}
+
+/**
+ * FUNCTION NAME: bound
+ *
+ * DESCRIPTION: Largest output of compress for size bytes of input
+ */
+int LZCodec::bound(int size) {
+	return size + size / 255 + 16;
+}
+
+/**
+ * FUNCTION NAME: hash
+ *
+ * DESCRIPTION: Hash of the four bytes at p
+ */
+unsigned int LZCodec::hash(const char *p) {
+	unsigned int v;
+	memcpy(&v, p, sizeof(v));
+	return (v * 2654435761U) >> (32 - LZ_HASH_BITS);
+}
+
+/**
+ * FUNCTION NAME: matchAt
+ *
+ * DESCRIPTION: Length of the match between the input at pos and the bytes at from,
+ * 				where a negative from is that far from the end of the dictionary
+ */
+int LZCodec::matchAt(const char *in, int pos, int size, int from, int dictLen) {
+	int len = 0;
+
+	while ( pos + len < size ) {
+		int p = from + len;
+		char c = p < 0 ? dict[dictLen + p] : in[p];
+		if ( c != in[pos + len] ) {
+			break;
+		}
+		len++;
+	}
+	return len;
+}
+
+/*
+ * Writes the 255 byte extension of a length whose nibble is 15
+ */
+static void putLength(unsigned char *&op, int n) {
+	while ( n >= 255 ) {
+		*op++ = 255;
+		n -= 255;
+	}
+	*op++ = n;
+}
+
+/*
+ * Reads the extension written by putLength, false if the input ends first
+ */
+static bool getLength(const unsigned char *&ip, const unsigned char *iend, int *n) {
+	int b;
+
+	do {
+		if ( ip >= iend ) {
+			return false;
+		}
+		b = *ip++;
+		*n += b;
+	} while ( b == 255 );
+	return true;
+}
+
+/**
+ * FUNCTION NAME: compress
+ *
+ * DESCRIPTION: Compresses size bytes of in into out. Positions that found no match
+ * 				are skipped faster the longer the run of misses, so input that
+ * 				does not compress costs little.
+ *
+ * RETURNS:
+ * Bytes written, 0 if they would not fit in cap
+ */
+int LZCodec::compress(const char *in, int size, char *out, int cap, bool useDict) {
+	int dictLen = useDict ? dict.size() : 0;
+	unsigned char *op = (unsigned char *)out;
+	unsigned char *oend = op + cap;
+	long long start = base;
+	int anchor = 0, i = 0, misses = 0;
+
+	// Entries of earlier inputs fall below the new base
+	base += size + 1;
+
+	while ( i + LZ_MINMATCH <= size ) {
+		unsigned int h = hash(in + i);
+		long long cand = table[h];
+		int len = 0, ref = 0;
+
+		table[h] = start + i;
+		if ( cand >= start && i - (cand - start) <= LZ_MAXOFFSET ) {
+			ref = cand - start;
+			len = matchAt(in, i, size, ref, dictLen);
+		}
+		if ( len < LZ_MINMATCH && dictLen > 0 && dictTable[h] > 0 ) {
+			int d = dictTable[h] - 1 - dictLen;
+			if ( i - d <= LZ_MAXOFFSET ) {
+				int l = matchAt(in, i, size, d, dictLen);
+				if ( l > len ) {
+					len = l;
+					ref = d;
+				}
+			}
+		}
+		if ( len < LZ_MINMATCH ) {
+			i += 1 + (misses++ >> 5);
+			continue;
+		}
+		misses = 0;
+
+		int lit = i - anchor;
+		int mlen = len - LZ_MINMATCH;
+		if ( oend - op < 1 + lit + lit / 255 + 2 + mlen / 255 + 2 ) {
+			return 0;
+		}
+		*op++ = (min(lit, 15) << 4) | min(mlen, 15);
+		if ( lit >= 15 ) {
+			putLength(op, lit - 15);
+		}
+		memcpy(op, in + anchor, lit);
+		op += lit;
+		*op++ = (i - ref) & 0xff;
+		*op++ = (i - ref) >> 8;
+		if ( mlen >= 15 ) {
+			putLength(op, mlen - 15);
+		}
+
+		i += len;
+		anchor = i;
+	}
+
+	// Last sequence, literals only
+	int lit = size - anchor;
+	if ( oend - op < 1 + lit + lit / 255 + 1 ) {
+		return 0;
+	}
+	*op++ = min(lit, 15) << 4;
+	if ( lit >= 15 ) {
+		putLength(op, lit - 15);
+	}
+	memcpy(op, in + anchor, lit);
+	op += lit;
+
+	return op - (unsigned char *)out;
+}
+
+/**
+ * FUNCTION NAME: decompress
+ *
+ * DESCRIPTION: Decompresses size bytes of in into out
+ *
+ * RETURNS:
+ * Bytes written, -1 if in is malformed or needs more than cap bytes
+ */
+int LZCodec::decompress(const char *in, int size, char *out, int cap, bool useDict) {
+	int dictLen = useDict ? dict.size() : 0;
+	const unsigned char *ip = (const unsigned char *)in;
+	const unsigned char *iend = ip + size;
+	char *op = out;
+	char *oend = out + cap;
+
+	while ( ip < iend ) {
+		int token = *ip++;
+		int lit = token >> 4;
+		int mlen = token & 15;
+
+		if ( lit == 15 && !getLength(ip, iend, &lit) ) {
+			return -1;
+		}
+		if ( lit > iend - ip || lit > oend - op ) {
+			return -1;
+		}
+		memcpy(op, ip, lit);
+		op += lit;
+		ip += lit;
+		if ( ip == iend ) {
+			break;
+		}
+
+		if ( iend - ip < 2 ) {
+			return -1;
+		}
+		int offset = ip[0] | (ip[1] << 8);
+		ip += 2;
+		if ( mlen == 15 && !getLength(ip, iend, &mlen) ) {
+			return -1;
+		}
+		mlen += LZ_MINMATCH;
+
+		int from = (op - out) - offset;
+		if ( offset == 0 || from < -dictLen || mlen > oend - op ) {
+			return -1;
+		}
+		if ( from >= 0 && offset >= mlen ) {
+			memcpy(op, out + from, mlen);
+		}
+		else {
+			// Overlapping or reaching into the dictionary
+			for ( int k = 0; k < mlen; k++ ) {
+				op[k] = from + k < 0 ? dict[dictLen + from + k] : out[from + k];
+			}
+		}
+		op += mlen;
+	}
+
+	return op - out;
+}
+
+/**
+ * FUNCTION NAME: train
+ *
+ * DESCRIPTION: Builds a dictionary of at most capacity bytes from sample payloads.
+ * 				Every segment of LZ_TRAIN_SEGMENT bytes is scored by the number of
+ * 				samples each of its distinct LZ_TRAIN_KMER byte substrings appears
+ * 				in. The best segment is taken and its substrings stop scoring,
+ * 				until the dictionary is full. The best segments go last, nearest
+ * 				to the input.
+ */
+string LZCodec::train(const vector<string> &samples, int capacity) {
+	unordered_map<string, int> freq;
+	vector<string> picked;
+	int used = 0;
+
+	for ( unsigned int s = 0; s < samples.size(); s++ ) {
+		unordered_map<string, bool> seen;
+		for ( int i = 0; i + LZ_TRAIN_KMER <= (int)samples[s].size(); i++ ) {
+			string kmer = samples[s].substr(i, LZ_TRAIN_KMER);
+			if ( !seen[kmer] ) {
+				seen[kmer] = true;
+				freq[kmer]++;
+			}
+		}
+	}
+
+	while ( used + LZ_TRAIN_SEGMENT <= capacity ) {
+		long best = 0;
+		string segment;
+		for ( unsigned int s = 0; s < samples.size(); s++ ) {
+			const string &sample = samples[s];
+			for ( int i = 0; i + LZ_TRAIN_SEGMENT <= (int)sample.size(); i++ ) {
+				unordered_map<string, bool> counted;
+				long score = 0;
+				for ( int k = i; k + LZ_TRAIN_KMER <= i + LZ_TRAIN_SEGMENT; k++ ) {
+					string kmer = sample.substr(k, LZ_TRAIN_KMER);
+					if ( !counted[kmer] ) {
+						counted[kmer] = true;
+						// Substrings of one sample only would never match
+						int f = freq[kmer];
+						score += f > 1 ? f : 0;
+					}
+				}
+				if ( score > best ) {
+					best = score;
+					segment = sample.substr(i, LZ_TRAIN_SEGMENT);
+				}
+			}
+		}
+		if ( best == 0 ) {
+			break;
+		}
+		for ( int k = 0; k + LZ_TRAIN_KMER <= LZ_TRAIN_SEGMENT; k++ ) {
+			freq[segment.substr(k, LZ_TRAIN_KMER)] = 0;
+		}
+		picked.push_back(segment);
+		used += LZ_TRAIN_SEGMENT;
+	}
+
+	string dict;
+	for ( int i = picked.size() - 1; i >= 0; i-- ) {
+		dict += picked[i];
+	}
+	return dict;
+}
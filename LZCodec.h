@@ -0,0 +1,59 @@
+/**********************************
+ * FILE NAME: LZCodec.h
+ *
+ * DESCRIPTION: Header file of the LZ77 codec used to compress frames on the wire
+ **********************************/
+
+#ifndef LZCODEC_H_
+#define LZCODEC_H_
+
+#include "stdincludes.h"
+
+/*
+ * Macros
+ */
+// Shortest match worth a sequence
+#define LZ_MINMATCH 4
+// Farthest a match can reach back, offsets take two bytes
+#define LZ_MAXOFFSET 65535
+#define LZ_HASH_BITS 12
+// Longest dictionary train builds
+#define LZ_DICT_SIZE 1024
+// Substrings train scores segments by, and the length of a segment
+#define LZ_TRAIN_KMER 6
+#define LZ_TRAIN_SEGMENT 32
+
+/**
+ * CLASS NAME: LZCodec
+ *
+ * DESCRIPTION: Byte oriented LZ77 in the style of LZ4. Every sequence is a token
+ * 				holding the literal length and the match length in a nibble each,
+ * 				255 bytes extend a nibble at 15, then the literals, then a two byte
+ * 				offset. The last sequence has literals only. Matches may reach
+ * 				back into a dictionary that both ends know, which is what makes
+ * 				frames of one or two short messages compress. The built in
+ * 				dictionary was made by train from KV store traffic.
+ */
+class LZCodec {
+private:
+	string dict;
+	// Hash of four bytes to 1 + their position in dict, 0 if none
+	vector<int> dictTable;
+	// Hash of four bytes to base + their position in the input
+	vector<long long> table;
+	// Positions below base belong to earlier inputs
+	long long base;
+
+	static unsigned int hash(const char *p);
+	int matchAt(const char *in, int pos, int size, int from, int dictLen);
+public:
+	LZCodec();
+	void setDictionary(const string &dict);
+	static int bound(int size);
+	int compress(const char *in, int size, char *out, int cap, bool useDict);
+	int decompress(const char *in, int size, char *out, int cap, bool useDict);
+	static string train(const vector<string> &samples, int capacity);
+	static const string &builtinDictionary();
+};
+
+#endif /* LZCODEC_H_ */
@@ -45,8 +45,10 @@ void Log::LOG(Address *addr, const char * str, ...) {
 
 	static FILE *fp;
 	static FILE *fp2;
-	va_list vararglist;
+	va_list vararglist, again;
 	static char buffer[30000];
+	char *text = buffer;
+	int len;
 	static int numwrites;
 	static char stdstring[30];
 	static char stdstring2[40];
@@ -70,10 +72,17 @@ void Log::LOG(Address *addr, const char * str, ...) {
 	}
 	else 
 
-	sprintf(stdstring, "%d.%d.%d.%d:%d ", addr->addr[0], addr->addr[1], addr->addr[2], addr->addr[3], *(short *)&addr->addr[4]);
+	snprintf(stdstring, sizeof(stdstring), "%d.%d.%d.%d:%d ", addr->addr[0], addr->addr[1], addr->addr[2], addr->addr[3], *(short *)&addr->addr[4]);
 
+	// Entries longer than buffer, such as large values, get one of their own
 	va_start(vararglist, str);
-	vsprintf(buffer, str, vararglist);
+	va_copy(again, vararglist);
+	len = vsnprintf(buffer, sizeof(buffer), str, vararglist);
+	if ( len >= (int)sizeof(buffer) ) {
+		text = (char *) malloc(len + 1);
+		vsnprintf(text, len + 1, str, again);
+	}
+	va_end(again);
 	va_end(vararglist);
 
 	if (!firstTime) {
@@ -87,17 +96,21 @@ void Log::LOG(Address *addr, const char * str, ...) {
 		firstTime = true;
 	}
 
-	if(memcmp(buffer, "#STATSLOG#", 10)==0){
+	if(strncmp(text, "#STATSLOG#", 10)==0){
 		fprintf(fp2, "\n %s", stdstring);
 		fprintf(fp2, "[%d] ", par->getcurrtime());
 
-		fprintf(fp2, buffer);
+		fputs(text, fp2);
 	}
 	else{
 		fprintf(fp, "\n %s", stdstring);
 		fprintf(fp, "[%d] ", par->getcurrtime());
-		fprintf(fp, buffer);
+		fputs(text, fp);
+
+	}
 
+	if ( text != buffer ) {
+		free(text);
 	}
 
 	if(++numwrites >= MAXWRITES){
@@ -114,9 +127,7 @@ void Log::LOG(Address *addr, const char * str, ...) {
  * DESCRIPTION: To Log a node add
  */
 void Log::logNodeAdd(Address *thisNode, Address *addedAddr) {
-	static char stdstring[100];
-	sprintf(stdstring, "Node %d.%d.%d.%d:%d joined at time %d", addedAddr->addr[0], addedAddr->addr[1], addedAddr->addr[2], addedAddr->addr[3], *(short *)&addedAddr->addr[4], par->getcurrtime());
-    LOG(thisNode, stdstring);
+	LOG(thisNode, "Node %d.%d.%d.%d:%d joined at time %d", addedAddr->addr[0], addedAddr->addr[1], addedAddr->addr[2], addedAddr->addr[3], *(short *)&addedAddr->addr[4], par->getcurrtime());
 }
 
 /**
@@ -125,9 +136,7 @@ void Log::logNodeAdd(Address *thisNode, Address *addedAddr) {
  * DESCRIPTION: To log a node remove
  */
 void Log::logNodeRemove(Address *thisNode, Address *removedAddr) {
-	static char stdstring[30];
-	sprintf(stdstring, "Node %d.%d.%d.%d:%d removed at time %d", removedAddr->addr[0], removedAddr->addr[1], removedAddr->addr[2], removedAddr->addr[3], *(short *)&removedAddr->addr[4], par->getcurrtime());
-    LOG(thisNode, stdstring);
+	LOG(thisNode, "Node %d.%d.%d.%d:%d removed at time %d", removedAddr->addr[0], removedAddr->addr[1], removedAddr->addr[2], removedAddr->addr[3], *(short *)&removedAddr->addr[4], par->getcurrtime());
 }
 
 /**
@@ -135,15 +144,13 @@ void Log::logNodeRemove(Address *thisNode, Address *removedAddr) {
  *
  * DESCRTION: Call this function after successfully create a key value pair
  */
-void Log::logCreateSuccess(Address * address, bool isCoordinator, int transID, string key, string value){
-	static char stdstring[100];
-	string str;
+void Log::logCreateSuccess(Address * address, bool isCoordinator, int transID, string_view key, string_view value){
+	const char *str;
 	if (isCoordinator)
 		str = "coordinator";
 	else
 		str = "server";
-	sprintf(stdstring, "%s: create success at time %d, transID=%d, key=%s, value=%s", str.c_str(), par->getcurrtime(), transID, key.c_str(), value.c_str());
-    LOG(address, stdstring);
+	LOG(address, "%s: create success at time %d, transID=%d, key=%.*s, value=%.*s", str, par->getcurrtime(), transID, (int)key.size(), key.data(), (int)value.size(), value.data());
 }
 
 /**
@@ -151,15 +158,13 @@ void Log::logCreateSuccess(Address * address, bool isCoordinator, int transID, s
  *
  * DESCRIPTION: Call this function after successfully reading a key
  */
-void Log::logReadSuccess(Address * address, bool isCoordinator, int transID, string key, string value){
-    static char stdstring[100];
-	string str;
+void Log::logReadSuccess(Address * address, bool isCoordinator, int transID, string_view key, string_view value){
+	const char *str;
 	if (isCoordinator)
 		str = "coordinator";
 	else
 		str = "server";
-	sprintf(stdstring, "%s: read success at time %d, transID=%d, key=%s, value=%s", str.c_str(), par->getcurrtime(), transID, key.c_str(), value.c_str());
-    LOG(address, stdstring);
+	LOG(address, "%s: read success at time %d, transID=%d, key=%.*s, value=%.*s", str, par->getcurrtime(), transID, (int)key.size(), key.data(), (int)value.size(), value.data());
 }
 
 /**
@@ -167,15 +172,13 @@ void Log::logReadSuccess(Address * address, bool isCoordinator, int transID, str
  *
  * DESCRIPTION: Call this function after successfully updating a key
  */
-void Log::logUpdateSuccess(Address * address, bool isCoordinator, int transID, string key, string newValue){
-    static char stdstring[100];
-	string str;
+void Log::logUpdateSuccess(Address * address, bool isCoordinator, int transID, string_view key, string_view newValue){
+	const char *str;
 	if (isCoordinator)
 		str = "coordinator";
 	else
 		str = "server";
-	sprintf(stdstring, "%s: update success at time %d, transID=%d, key=%s, value=%s", str.c_str(), par->getcurrtime(), transID, key.c_str(), newValue.c_str());
-    LOG(address, stdstring);
+	LOG(address, "%s: update success at time %d, transID=%d, key=%.*s, value=%.*s", str, par->getcurrtime(), transID, (int)key.size(), key.data(), (int)newValue.size(), newValue.data());
 }
 
 /**
@@ -183,15 +186,13 @@ void Log::logUpdateSuccess(Address * address, bool isCoordinator, int transID, s
  *
  * DESCRIPTION: Call this function after successfully deleting a key
  */
-void Log::logDeleteSuccess(Address * address, bool isCoordinator, int transID, string key){
-    static char stdstring[100];
-	string str;
+void Log::logDeleteSuccess(Address * address, bool isCoordinator, int transID, string_view key){
+	const char *str;
 	if (isCoordinator)
 		str = "coordinator";
 	else
 		str = "server";
-	sprintf(stdstring, "%s: delete success at time %d, transID=%d, key=%s", str.c_str(), par->getcurrtime(), transID, key.c_str());
-    LOG(address, stdstring);
+	LOG(address, "%s: delete success at time %d, transID=%d, key=%.*s", str, par->getcurrtime(), transID, (int)key.size(), key.data());
 }
 
 /**
@@ -199,15 +200,13 @@ void Log::logDeleteSuccess(Address * address, bool isCoordinator, int transID, s
  *
  * DESCRIPTION: Call this function if CREATE failed
  */
-void Log::logCreateFail(Address * address, bool isCoordinator, int transID, string key, string value){
-	static char stdstring[100];
-	string str;
+void Log::logCreateFail(Address * address, bool isCoordinator, int transID, string_view key, string_view value){
+	const char *str;
 	if (isCoordinator)
 		str = "coordinator";
 	else
 		str = "server";
-	sprintf(stdstring, "%s: create fail at time %d, transID=%d, key=%s, value=%s", str.c_str(), par->getcurrtime(), transID, key.c_str(), value.c_str());
-    LOG(address, stdstring);
+	LOG(address, "%s: create fail at time %d, transID=%d, key=%.*s, value=%.*s", str, par->getcurrtime(), transID, (int)key.size(), key.data(), (int)value.size(), value.data());
 }
 
 
@@ -216,15 +215,13 @@ void Log::logCreateFail(Address * address, bool isCoordinator, int transID, stri
  *
  * DESCRIPTION: Call this function if READ failed
  */
-void Log::logReadFail(Address * address, bool isCoordinator, int transID, string key){
-    static char stdstring[100];
-	string str;
+void Log::logReadFail(Address * address, bool isCoordinator, int transID, string_view key){
+	const char *str;
 	if (isCoordinator)
 		str = "coordinator";
 	else
 		str = "server";
-	sprintf(stdstring, "%s: read fail at time %d, transID=%d, key=%s", str.c_str(), par->getcurrtime(), transID, key.c_str());
-    LOG(address, stdstring);
+	LOG(address, "%s: read fail at time %d, transID=%d, key=%.*s", str, par->getcurrtime(), transID, (int)key.size(), key.data());
 }
 
 /**
@@ -232,15 +229,13 @@ void Log::logReadFail(Address * address, bool isCoordinator, int transID, string
  *
  * DESCRIPTION: Call this function if UPDATE failed
  */
-void Log::logUpdateFail(Address * address, bool isCoordinator, int transID, string key, string newValue){
-    static char stdstring[100];
-	string str;
+void Log::logUpdateFail(Address * address, bool isCoordinator, int transID, string_view key, string_view newValue){
+	const char *str;
 	if (isCoordinator)
 		str = "coordinator";
 	else
 		str = "server";
-	sprintf(stdstring, "%s: update fail at time %d, transID=%d, key=%s, value=%s", str.c_str(), par->getcurrtime(), transID, key.c_str(), newValue.c_str());
-    LOG(address, stdstring);
+	LOG(address, "%s: update fail at time %d, transID=%d, key=%.*s, value=%.*s", str, par->getcurrtime(), transID, (int)key.size(), key.data(), (int)newValue.size(), newValue.data());
 }
 
 /**
@@ -248,13 +243,11 @@ void Log::logUpdateFail(Address * address, bool isCoordinator, int transID, stri
  *
  * DESCRIPTION: Call this function if DELETE failed
  */
-void Log::logDeleteFail(Address * address, bool isCoordinator, int transID, string key){
-    static char stdstring[100];
-	string str;
+void Log::logDeleteFail(Address * address, bool isCoordinator, int transID, string_view key){
+	const char *str;
 	if (isCoordinator)
 		str = "coordinator";
 	else
 		str = "server";
-	sprintf(stdstring, "%s: delete fail at time %d, transID=%d, key=%s", str.c_str(), par->getcurrtime(), transID, key.c_str());
-    LOG(address, stdstring);
+	LOG(address, "%s: delete fail at time %d, transID=%d, key=%.*s", str, par->getcurrtime(), transID, (int)key.size(), key.data());
 }
@@ -0,0 +1,847 @@
+/**********************************
+ * FILE NAME: LsmTable.cpp
+ *
+ * DESCRIPTION: Definition of the log-structured merge tree table
+ **********************************/
+
+#include "LsmTable.h"
+
+/*
+ * Entries of a memtable or an SSTable in key order, for merging
+ */
+class MergeSource {
+public:
+	string_view key;
+	string_view value;
+
+	virtual ~MergeSource() {}
+	virtual bool valid() = 0;
+	virtual void next() = 0;
+};
+
+class MemtableSource : public MergeSource {
+private:
+	Memtable::const_iterator it;
+	Memtable::const_iterator end;
+
+	void load() {
+		if ( it != end ) {
+			key = it->first;
+			value = it->second;
+		}
+	}
+public:
+	MemtableSource(const Memtable &table): it(table.begin()), end(table.end()) {
+		load();
+	}
+	bool valid() {
+		return it != end;
+	}
+	void next() {
+		++it;
+		load();
+	}
+};
+
+class TableSource : public MergeSource {
+private:
+	SSTable::Cursor cursor;
+
+	void load() {
+		key = cursor.key;
+		value = cursor.value;
+	}
+public:
+	TableSource(SSTable *table): cursor(table) {
+		load();
+	}
+	bool valid() {
+		return cursor.valid();
+	}
+	void next() {
+		cursor.next();
+		load();
+	}
+};
+
+/*
+ * Passes the newest entry of every key in sources, newest source first, to emit
+ * in key order. Deleted keys are left out if dropDeleted.
+ */
+static void mergeSources(vector<MergeSource *> &sources, bool dropDeleted, const function<void(string_view, string_view)> &emit) {
+	// Smallest key on top, the newest source first among equal keys
+	auto later = [&sources](int a, int b) {
+		int cmp = sources[a]->key.compare(sources[b]->key);
+		return cmp != 0 ? cmp > 0 : a > b;
+	};
+	priority_queue<int, vector<int>, decltype(later)> heap(later);
+
+	for ( unsigned int i = 0; i < sources.size(); i++ ) {
+		if ( sources[i]->valid() ) {
+			heap.push(i);
+		}
+	}
+	while ( !heap.empty() ) {
+		int top = heap.top();
+		string_view key = sources[top]->key;
+
+		if ( !dropDeleted || !sources[top]->value.empty() ) {
+			emit(key, sources[top]->value);
+		}
+		// Older entries of the same key are skipped, key stays valid as
+		// sources are only moved past it afterwards
+		vector<int> done;
+		while ( !heap.empty() && sources[heap.top()]->key == key ) {
+			done.push_back(heap.top());
+			heap.pop();
+		}
+		for ( unsigned int i = 0; i < done.size(); i++ ) {
+			sources[done[i]]->next();
+			if ( sources[done[i]]->valid() ) {
+				heap.push(done[i]);
+			}
+		}
+	}
+}
+
+/*
+ * Whether table holds keys between lo and hi
+ */
+static bool overlaps(SSTable *table, string_view lo, string_view hi) {
+	return !(string_view(table->largest()) < lo || string_view(table->smallest()) > hi);
+}
+
+/*
+ * Bytes of the tables of a level
+ */
+static size_t levelBytes(const vector< shared_ptr<SSTable> > &level) {
+	size_t bytes = 0;
+
+	for ( unsigned int i = 0; i < level.size(); i++ ) {
+		bytes += level[i]->bytes();
+	}
+	return bytes;
+}
+
+/**
+ * Constructor
+ * Opens the tables listed in the MANIFEST of dir, creating dir if needed, and
+ * starts the background thread
+ */
+LsmTable::LsmTable(const string &dir) {
+	this->dir = dir;
+	mem = make_shared<Memtable>();
+	memBytes = 0;
+	version = make_shared<LsmVersion>();
+	live = immLive = diskLive = 0;
+	nextSeq = 1;
+	stopping = false;
+	failed = false;
+	memset(&stats, 0, sizeof(stats));
+
+	mkdir(dir.c_str(), 0755);
+	loadManifest();
+	worker = thread(&LsmTable::background, this);
+}
+
+/**
+ * Destructor
+ * Writes the memtable out, so the next start does not have to replay it, and
+ * stops the background thread
+ */
+LsmTable::~LsmTable() {
+	flush();
+	{
+		unique_lock<shared_mutex> hold(lock);
+		stopping = true;
+		changed.notify_all();
+	}
+	worker.join();
+}
+
+/**
+ * FUNCTION NAME: tablePath
+ *
+ * DESCRIPTION: File of the table numbered seq
+ */
+string LsmTable::tablePath(uint64_t seq) {
+	char name[32];
+	snprintf(name, sizeof(name), "/%06lu.sst", (unsigned long)seq);
+	return dir + name;
+}
+
+/**
+ * FUNCTION NAME: loadManifest
+ *
+ * DESCRIPTION: Opens the tables the MANIFEST lists and removes table files it does
+ * 				not, left by a crash in the middle of a flush or compaction
+ */
+void LsmTable::loadManifest() {
+	shared_ptr<LsmVersion> loaded = make_shared<LsmVersion>();
+	set<string> listed;
+	char line[128];
+	FILE *fp = fopen((dir + "/" + LSM_MANIFEST).c_str(), "r");
+	DIR *d;
+	struct dirent *entry;
+
+	if ( NULL != fp ) {
+		while ( NULL != fgets(line, sizeof(line), fp) ) {
+			unsigned long a, b;
+			if ( sscanf(line, "next %lu", &a) == 1 ) {
+				nextSeq = a;
+			}
+			else if ( sscanf(line, "live %lu", &a) == 1 ) {
+				live = immLive = diskLive = a;
+			}
+			else if ( sscanf(line, "table %lu %lu", &a, &b) == 2 && a < LSM_LEVELS ) {
+				shared_ptr<SSTable> table = SSTable::open(tablePath(b), b);
+				listed.insert(tablePath(b));
+				if ( NULL == table ) {
+					fprintf(stderr, "%s: missing or damaged, its keys are lost\n", tablePath(b).c_str());
+					continue;
+				}
+				loaded->levels[a].push_back(table);
+			}
+		}
+		fclose(fp);
+	}
+	version = loaded;
+
+	d = opendir(dir.c_str());
+	while ( NULL != d && NULL != (entry = readdir(d)) ) {
+		string path = dir + "/" + entry->d_name;
+		size_t len = strlen(entry->d_name);
+		if ( len > 4 && 0 == strcmp(entry->d_name + len - 4, ".sst") && 0 == listed.count(path) ) {
+			unlink(path.c_str());
+		}
+	}
+	if ( NULL != d ) {
+		closedir(d);
+	}
+}
+
+/**
+ * FUNCTION NAME: saveManifest
+ *
+ * DESCRIPTION: Replaces MANIFEST with one listing the current version
+ *
+ * RETURNS:
+ * true once it is on disk
+ */
+bool LsmTable::saveManifest() {
+	lock_guard<mutex> order(manifestLock);
+	shared_ptr<const LsmVersion> v;
+	string tmpPath = dir + "/" + LSM_MANIFEST + ".tmp";
+	string path = dir + "/" + LSM_MANIFEST;
+	string text;
+	long keys;
+	uint64_t seq;
+	int fd;
+	bool ok;
+
+	{
+		shared_lock<shared_mutex> hold(lock);
+		v = version;
+		keys = diskLive;
+		seq = nextSeq;
+	}
+	text = "next " + to_string(seq) + "\nlive " + to_string(keys) + "\n";
+	for ( int level = 0; level < LSM_LEVELS; level++ ) {
+		for ( unsigned int i = 0; i < v->levels[level].size(); i++ ) {
+			text += "table " + to_string(level) + " " + to_string(v->levels[level][i]->seq) + "\n";
+		}
+	}
+
+	fd = open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	ok = fd >= 0 && write(fd, text.data(), text.size()) == (ssize_t)text.size() && fdatasync(fd) == 0;
+	if ( fd >= 0 ) {
+		close(fd);
+	}
+	if ( !ok || rename(tmpPath.c_str(), path.c_str()) < 0 ) {
+		perror(tmpPath.c_str());
+		return false;
+	}
+	fd = open(dir.c_str(), O_RDONLY);
+	if ( fd >= 0 ) {
+		fsync(fd);
+		close(fd);
+	}
+	return true;
+}
+
+/**
+ * FUNCTION NAME: lookup
+ *
+ * DESCRIPTION: Finds the newest entry of key, copying its value into value
+ *
+ * RETURNS:
+ * 1 if there is one, even a deletion, 0 otherwise
+ */
+int LsmTable::lookup(string_view key, string &value) {
+	shared_ptr<const LsmVersion> v;
+
+	{
+		shared_lock<shared_mutex> hold(lock);
+		Memtable::const_iterator it = mem->find(key);
+		if ( it != mem->end() ) {
+			value.assign(it->second);
+			return 1;
+		}
+		if ( NULL != imm && (it = imm->find(key)) != imm->end() ) {
+			value.assign(it->second);
+			return 1;
+		}
+		v = version;
+	}
+
+	// The tables cannot change, no lock is needed to read them
+	for ( unsigned int i = 0; i < v->levels[0].size(); i++ ) {
+		if ( v->levels[0][i]->get(key, value) ) {
+			return 1;
+		}
+	}
+	for ( int level = 1; level < LSM_LEVELS; level++ ) {
+		const vector< shared_ptr<SSTable> > &tables = v->levels[level];
+		// Last table starting at or before key
+		vector< shared_ptr<SSTable> >::const_iterator it = upper_bound(tables.begin(), tables.end(), key,
+			[](string_view k, const shared_ptr<SSTable> &t) {
+				return k < string_view(t->smallest());
+			});
+		if ( it != tables.begin() && (*--it)->get(key, value) ) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/**
+ * FUNCTION NAME: put
+ *
+ * DESCRIPTION: Sets key to value in the memtable, freezing it first if it is full.
+ * 				Waits while the memtable frozen before is still being written.
+ * 				delta is the change in the number of keys.
+ */
+void LsmTable::put(string_view key, string_view value, long delta) {
+	unique_lock<shared_mutex> hold(lock);
+	Memtable::iterator it;
+
+	if ( memBytes >= LSM_MEMTABLE_BYTES ) {
+		if ( NULL != imm ) {
+			stats.stalls++;
+		}
+		while ( NULL != imm && !failed ) {
+			changed.wait(hold);
+		}
+		if ( NULL == imm ) {
+			imm = mem;
+			immLive = live;
+			mem = make_shared<Memtable>();
+			memBytes = 0;
+			changed.notify_all();
+		}
+	}
+
+	it = mem->find(key);
+	if ( it != mem->end() ) {
+		memBytes += value.size();
+		memBytes -= it->second.size();
+		it->second.assign(value);
+	}
+	else {
+		mem->emplace(string(key), string(value));
+		memBytes += key.size() + value.size() + LSM_ENTRY_OVERHEAD;
+	}
+	live += delta;
+}
+
+/**
+ * FUNCTION NAME: background
+ *
+ * DESCRIPTION: Writes out frozen memtables and compacts until stopped
+ */
+void LsmTable::background() {
+	unique_lock<shared_mutex> hold(lock);
+
+	for ( ;; ) {
+		if ( NULL != imm && !failed ) {
+			hold.unlock();
+			bool ok = flushFrozen();
+			hold.lock();
+			if ( !ok ) {
+				// Writers waiting on imm give up, flush reports the failure
+				failed = true;
+				changed.notify_all();
+			}
+			continue;
+		}
+		if ( stopping ) {
+			break;
+		}
+		hold.unlock();
+		bool merged = compact();
+		hold.lock();
+		if ( !merged && (NULL == imm || failed) && !stopping ) {
+			changed.wait(hold);
+		}
+	}
+}
+
+/**
+ * FUNCTION NAME: flushFrozen
+ *
+ * DESCRIPTION: Writes the frozen memtable to a new table of level 0
+ *
+ * RETURNS:
+ * false if the table could not be written
+ */
+bool LsmTable::flushFrozen() {
+	shared_ptr<Memtable> frozen;
+	shared_ptr<LsmVersion> next;
+	shared_ptr<SSTable> table;
+	uint64_t seq;
+	bool bottom = true;
+
+	{
+		shared_lock<shared_mutex> hold(lock);
+		frozen = imm;
+		seq = nextSeq;
+		for ( int level = 0; level < LSM_LEVELS; level++ ) {
+			bottom = bottom && version->levels[level].empty();
+		}
+	}
+
+	SSTableBuilder builder(tablePath(seq));
+	for ( Memtable::const_iterator it = frozen->begin(); it != frozen->end(); it++ ) {
+		// Nothing older could hold a deleted key
+		if ( !bottom || !it->second.empty() ) {
+			builder.add(it->first, it->second);
+		}
+	}
+	if ( !builder.finish() || NULL == (table = SSTable::open(tablePath(seq), seq)) ) {
+		return false;
+	}
+
+	{
+		unique_lock<shared_mutex> hold(lock);
+		nextSeq = seq + 1;
+		if ( imm != frozen ) {
+			// Cleared meanwhile
+			table->markObsolete();
+			return true;
+		}
+		next = make_shared<LsmVersion>(*version);
+		next->levels[0].insert(next->levels[0].begin(), table);
+		version = next;
+		diskLive = immLive;
+		imm.reset();
+		stats.flushes++;
+		stats.bytesWritten += table->bytes();
+		changed.notify_all();
+	}
+	saveManifest();
+	return true;
+}
+
+/**
+ * FUNCTION NAME: compact
+ *
+ * DESCRIPTION: Merges level 0 into level 1 if it has too many tables, otherwise
+ * 				the next table of the first level that outgrew its size into
+ * 				the level below, replacing the tables it overlaps there
+ *
+ * RETURNS:
+ * true if there was something to merge
+ */
+bool LsmTable::compact() {
+	shared_ptr<const LsmVersion> v;
+	vector< shared_ptr<SSTable> > inputs;
+	vector< shared_ptr<SSTable> > outputs;
+	// Number of inputs from level from, the others are from the level below
+	unsigned int upper;
+	int from = -1;
+	bool bottom = true;
+	string lo, hi;
+
+	{
+		shared_lock<shared_mutex> hold(lock);
+		v = version;
+	}
+
+	if ( v->levels[0].size() >= LSM_L0_TABLES ) {
+		from = 0;
+		inputs = v->levels[0];
+	}
+	else {
+		size_t limit = LSM_LEVEL_BYTES;
+		for ( int level = 1; level < LSM_LEVELS - 1 && from < 0; level++, limit *= LSM_LEVEL_RATIO ) {
+			const vector< shared_ptr<SSTable> > &tables = v->levels[level];
+			if ( levelBytes(tables) <= limit ) {
+				continue;
+			}
+			// Round robin over the key space of the level
+			from = level;
+			inputs.push_back(tables[0]);
+			for ( unsigned int i = 0; i < tables.size(); i++ ) {
+				if ( tables[i]->smallest() > compactPointer[level] ) {
+					inputs[0] = tables[i];
+					break;
+				}
+			}
+			compactPointer[level] = inputs[0]->largest();
+		}
+	}
+	if ( from < 0 ) {
+		return false;
+	}
+
+	upper = inputs.size();
+	lo = inputs[0]->smallest();
+	hi = inputs[0]->largest();
+	for ( unsigned int i = 1; i < inputs.size(); i++ ) {
+		lo = min(lo, inputs[i]->smallest());
+		hi = max(hi, inputs[i]->largest());
+	}
+	for ( unsigned int i = 0; i < v->levels[from + 1].size(); i++ ) {
+		if ( overlaps(v->levels[from + 1][i].get(), lo, hi) ) {
+			inputs.push_back(v->levels[from + 1][i]);
+		}
+	}
+	for ( int level = from + 2; level < LSM_LEVELS; level++ ) {
+		bottom = bottom && v->levels[level].empty();
+	}
+
+	// Sources newest first: level 0 newest first, then the input level, then
+	// the level below
+	vector<MergeSource *> sources;
+	for ( unsigned int i = 0; i < inputs.size(); i++ ) {
+		sources.push_back(new TableSource(inputs[i].get()));
+	}
+	SSTableBuilder *builder = NULL;
+	uint64_t seq = 0;
+	bool ok = true;
+	auto finishTable = [&]() {
+		shared_ptr<SSTable> table;
+		ok = ok && builder->finish() && NULL != (table = SSTable::open(tablePath(seq), seq));
+		if ( ok ) {
+			outputs.push_back(table);
+		}
+		delete builder;
+		builder = NULL;
+	};
+	mergeSources(sources, bottom, [&](string_view key, string_view value) {
+		if ( NULL == builder ) {
+			unique_lock<shared_mutex> hold(lock);
+			seq = nextSeq++;
+			hold.unlock();
+			builder = new SSTableBuilder(tablePath(seq));
+		}
+		builder->add(key, value);
+		if ( builder->bytes() >= LSM_TABLE_BYTES ) {
+			finishTable();
+		}
+	});
+	if ( NULL != builder ) {
+		finishTable();
+	}
+	for ( unsigned int i = 0; i < sources.size(); i++ ) {
+		delete sources[i];
+	}
+	if ( !ok ) {
+		for ( unsigned int i = 0; i < outputs.size(); i++ ) {
+			outputs[i]->markObsolete();
+		}
+		return false;
+	}
+
+	{
+		unique_lock<shared_mutex> hold(lock);
+		shared_ptr<LsmVersion> next = make_shared<LsmVersion>(*version);
+		for ( unsigned int i = 0; i < inputs.size(); i++ ) {
+			vector< shared_ptr<SSTable> > &tables = next->levels[i < upper ? from : from + 1];
+			vector< shared_ptr<SSTable> >::iterator it = find(tables.begin(), tables.end(), inputs[i]);
+			if ( it == tables.end() ) {
+				// Cleared meanwhile, the merge is thrown away
+				for ( unsigned int j = 0; j < outputs.size(); j++ ) {
+					outputs[j]->markObsolete();
+				}
+				return true;
+			}
+			tables.erase(it);
+		}
+		vector< shared_ptr<SSTable> > &below = next->levels[from + 1];
+		below.insert(below.end(), outputs.begin(), outputs.end());
+		sort(below.begin(), below.end(), [](const shared_ptr<SSTable> &a, const shared_ptr<SSTable> &b) {
+			return a->smallest() < b->smallest();
+		});
+		version = next;
+		stats.compactions++;
+		for ( unsigned int i = 0; i < outputs.size(); i++ ) {
+			stats.bytesWritten += outputs[i]->bytes();
+		}
+	}
+	// The inputs go once no MANIFEST lists them
+	if ( saveManifest() ) {
+		for ( unsigned int i = 0; i < inputs.size(); i++ ) {
+			inputs[i]->markObsolete();
+		}
+	}
+	return true;
+}
+
+/**
+ * FUNCTION NAME: create
+ *
+ * DESCRIPTION: Inserts the (key,value) pair unless the key is already there
+ *
+ * RETURNS:
+ * true if the key was added
+ */
+bool LsmTable::create(string_view key, string &&value) {
+	lock_guard<mutex> writer(writeLock);
+
+	if ( lookup(key, probe) && !probe.empty() ) {
+		return false;
+	}
+	put(key, value, 1);
+	return true;
+}
+
+/**
+ * FUNCTION NAME: read
+ *
+ * DESCRIPTION: Copies the value of key into value, which keeps its capacity across
+ * 				calls. value is emptied if the key is not found.
+ *
+ * RETURNS:
+ * true if found
+ */
+bool LsmTable::read(string_view key, string &value) {
+	if ( !lookup(key, value) ) {
+		value.clear();
+	}
+	return !value.empty();
+}
+
+/**
+ * FUNCTION NAME: update
+ *
+ * DESCRIPTION: Updates the given key with the value passed in if the key is found
+ *
+ * RETURNS:
+ * true on SUCCESS
+ */
+bool LsmTable::update(string_view key, string_view newValue) {
+	lock_guard<mutex> writer(writeLock);
+
+	if ( !lookup(key, probe) || probe.empty() ) {
+		return false;
+	}
+	put(key, newValue, 0);
+	return true;
+}
+
+/**
+ * FUNCTION NAME: deleteKey
+ *
+ * DESCRIPTION: Deletes the given key if it is found, by writing an empty value
+ * 				that hides the older ones until compaction drops them all
+ *
+ * RETURNS:
+ * true on SUCCESS
+ */
+bool LsmTable::deleteKey(string_view key) {
+	lock_guard<mutex> writer(writeLock);
+
+	if ( !lookup(key, probe) || probe.empty() ) {
+		return false;
+	}
+	put(key, string_view(), -1);
+	return true;
+}
+
+/**
+ * FUNCTION NAME: createAt
+ *
+ * DESCRIPTION: Inserts the (key,value) pair unless the key is already there with a
+ * 				value not past its expiry at tick now. An expired value is
+ * 				written over.
+ *
+ * RETURNS:
+ * true if the key was added or its expired value replaced
+ */
+bool LsmTable::createAt(string_view key, string &&value, int now, bool &expired) {
+	lock_guard<mutex> writer(writeLock);
+
+	expired = false;
+	if ( lookup(key, probe) && !probe.empty() ) {
+		expired = expiredAt(probe, now);
+		if ( !expired ) {
+			return false;
+		}
+	}
+	put(key, value, expired ? 0 : 1);
+	return true;
+}
+
+/**
+ * FUNCTION NAME: updateAt
+ *
+ * DESCRIPTION: Updates the given key with the value passed in if the key is found
+ * 				with a value not past its expiry at tick now. An expired value is
+ * 				deleted.
+ *
+ * RETURNS:
+ * true on SUCCESS
+ */
+bool LsmTable::updateAt(string_view key, string_view newValue, int now, bool &expired) {
+	lock_guard<mutex> writer(writeLock);
+
+	expired = false;
+	if ( !lookup(key, probe) || probe.empty() ) {
+		return false;
+	}
+	expired = expiredAt(probe, now);
+	if ( expired ) {
+		put(key, string_view(), -1);
+		return false;
+	}
+	put(key, newValue, 0);
+	return true;
+}
+
+bool LsmTable::isEmpty() {
+	return 0 == currentSize();
+}
+
+/**
+ * FUNCTION NAME: currentSize
+ *
+ * DESCRIPTION: Returns the number of keys, counted as they are written
+ */
+unsigned long LsmTable::currentSize() {
+	shared_lock<shared_mutex> hold(lock);
+	return live;
+}
+
+/**
+ * FUNCTION NAME: clear
+ *
+ * DESCRIPTION: Drops every key and table
+ */
+void LsmTable::clear() {
+	lock_guard<mutex> writer(writeLock);
+	shared_ptr<const LsmVersion> old;
+
+	{
+		unique_lock<shared_mutex> hold(lock);
+		old = version;
+		version = make_shared<LsmVersion>();
+		mem = make_shared<Memtable>();
+		imm.reset();
+		memBytes = 0;
+		live = immLive = diskLive = 0;
+		changed.notify_all();
+	}
+	if ( saveManifest() ) {
+		for ( int level = 0; level < LSM_LEVELS; level++ ) {
+			for ( unsigned int i = 0; i < old->levels[level].size(); i++ ) {
+				old->levels[level][i]->markObsolete();
+			}
+		}
+	}
+}
+
+/**
+ * FUNCTION NAME: count
+ *
+ * DESCRIPTION: Returns the count of the number of values for the passed in key
+ */
+unsigned long LsmTable::count(string_view key) {
+	string value;
+	return read(key, value) ? 1 : 0;
+}
+
+/**
+ * FUNCTION NAME: forEach
+ *
+ * DESCRIPTION: Calls visit on every key and value in key order. The memtable is
+ * 				copied and the tables are pinned first, so visit runs without any
+ * 				lock and may change the table; it sees the keys as they were.
+ */
+void LsmTable::forEach(const function<void(const string &, const string &)> &visit) {
+	Memtable memCopy;
+	shared_ptr<Memtable> frozen;
+	shared_ptr<const LsmVersion> v;
+	vector<MergeSource *> sources;
+	string key, value;
+
+	{
+		shared_lock<shared_mutex> hold(lock);
+		memCopy = *mem;
+		frozen = imm;
+		v = version;
+	}
+	sources.push_back(new MemtableSource(memCopy));
+	if ( NULL != frozen ) {
+		sources.push_back(new MemtableSource(*frozen));
+	}
+	for ( int level = 0; level < LSM_LEVELS; level++ ) {
+		for ( unsigned int i = 0; i < v->levels[level].size(); i++ ) {
+			sources.push_back(new TableSource(v->levels[level][i].get()));
+		}
+	}
+	mergeSources(sources, true, [&](string_view k, string_view val) {
+		key.assign(k);
+		value.assign(val);
+		visit(key, value);
+	});
+	for ( unsigned int i = 0; i < sources.size(); i++ ) {
+		delete sources[i];
+	}
+}
+
+/**
+ * FUNCTION NAME: durable
+ *
+ * DESCRIPTION: The tables are files of their own
+ */
+bool LsmTable::durable() {
+	return true;
+}
+
+/**
+ * FUNCTION NAME: flush
+ *
+ * DESCRIPTION: Freezes the memtable and waits until it is in a table on disk
+ *
+ * RETURNS:
+ * SUCCESS or FAILURE
+ */
+int LsmTable::flush() {
+	unique_lock<shared_mutex> hold(lock);
+
+	while ( NULL != imm && !failed ) {
+		changed.wait(hold);
+	}
+	if ( !mem->empty() && !failed ) {
+		imm = mem;
+		immLive = live;
+		mem = make_shared<Memtable>();
+		memBytes = 0;
+		changed.notify_all();
+		while ( NULL != imm && !failed ) {
+			changed.wait(hold);
+		}
+	}
+	return failed ? FAILURE : SUCCESS;
+}
+
+/**
+ * FUNCTION NAME: getStats
+ *
+ * DESCRIPTION: Returns the counters
+ */
+LsmStats LsmTable::getStats() {
+	shared_lock<shared_mutex> hold(lock);
+	return stats;
+}
@@ -0,0 +1,154 @@
+/**********************************
+ * FILE NAME: LsmTable.h
+ *
+ * DESCRIPTION: Header file of the log-structured merge tree table
+ **********************************/
+
+#ifndef LSMTABLE_H_
+#define LSMTABLE_H_
+
+/**
+ * Header files
+ */
+#include "stdincludes.h"
+#include "StorageEngine.h"
+#include "SSTable.h"
+#include <mutex>
+#include <shared_mutex>
+#include <condition_variable>
+#include <thread>
+#include <dirent.h>
+
+/*
+ * Macros
+ */
+// The sizes can be given at build time, tests shrink them to reach deep levels
+// with little data
+// The memtable is frozen and written out once it holds this many bytes
+#ifndef LSM_MEMTABLE_BYTES
+#define LSM_MEMTABLE_BYTES (4 << 20)
+#endif
+// Bytes a memtable entry costs beyond its key and value
+#define LSM_ENTRY_OVERHEAD 64
+// Compaction cuts its output into tables of about this many bytes
+#ifndef LSM_TABLE_BYTES
+#define LSM_TABLE_BYTES (2 << 20)
+#endif
+// Level 0 is merged into level 1 once it has this many tables
+#define LSM_L0_TABLES 4
+// Size of level 1, every deeper level may be LSM_LEVEL_RATIO times larger
+#ifndef LSM_LEVEL_BYTES
+#define LSM_LEVEL_BYTES (10 << 20)
+#endif
+#define LSM_LEVEL_RATIO 10
+#define LSM_LEVELS 7
+#define LSM_MANIFEST "MANIFEST"
+
+// Keys in order, an empty value marks a deleted key
+typedef map<string, string, less<> > Memtable;
+
+/**
+ * STRUCT NAME: LsmVersion
+ *
+ * DESCRIPTION: The tables of every level at one point in time. Tables of level 0
+ * 				may overlap and go newest first, those of deeper levels do not
+ * 				and go in key order. Never changed once published, readers keep
+ * 				a version and its tables alive for as long as they need them.
+ */
+typedef struct LsmVersion {
+	vector< shared_ptr<SSTable> > levels[LSM_LEVELS];
+} LsmVersion;
+
+/**
+ * STRUCT NAME: LsmStats
+ *
+ * DESCRIPTION: Counters of an LsmTable
+ */
+typedef struct LsmStats {
+	// memtables written to level 0
+	long flushes;
+	// merges into a deeper level
+	long compactions;
+	// bytes of tables written by both
+	long bytesWritten;
+	// writes that waited for a frozen memtable to be written
+	long stalls;
+} LsmStats;
+
+/**
+ * CLASS NAME: LsmTable
+ *
+ * DESCRIPTION: Table for more keys than fit in memory, kept in dir. Changes go to
+ * 				an in-memory memtable. A full memtable is frozen, a new one takes
+ * 				its place, and a background thread writes the frozen one to an
+ * 				SSTable of level 0. The same thread merges level 0 into level 1
+ * 				once it has LSM_L0_TABLES tables, and a table of any deeper level
+ * 				into the next once the level outgrows its size (leveled
+ * 				compaction). Deleted keys are dropped when merged into the
+ * 				deepest level holding tables.
+ * 				A read looks in the memtable, the frozen one, then the tables
+ * 				newest first, stopping at the first entry of the key; bloom
+ * 				filters keep it from touching tables without it. Writes go
+ * 				one at a time, after a read telling whether the key is there,
+ * 				which keeps the create/update/delete rules of HashTable and an
+ * 				exact count of the keys.
+ * 				The MANIFEST file lists the tables of every level and is
+ * 				replaced whenever they change. Memtables are only on disk
+ * 				once flushed, the write-ahead log covers them until then.
+ */
+class LsmTable : public StorageEngine {
+private:
+	string dir;
+	// Guards the memtables, version and counters
+	shared_mutex lock;
+	condition_variable_any changed;
+	// One writer at a time
+	mutex writeLock;
+	// Keeps MANIFEST writes in the order of the versions they save
+	mutex manifestLock;
+	shared_ptr<Memtable> mem;
+	shared_ptr<Memtable> imm;
+	size_t memBytes;
+	shared_ptr<const LsmVersion> version;
+	// Keys in the table, when imm was frozen, and in the tables on disk
+	long live;
+	long immLive;
+	long diskLive;
+	uint64_t nextSeq;
+	// Where the next compaction of every level starts
+	string compactPointer[LSM_LEVELS];
+	// Value looked up by writers, guarded by writeLock
+	string probe;
+	bool stopping;
+	bool failed;
+	LsmStats stats;
+	thread worker;
+
+	string tablePath(uint64_t seq);
+	int lookup(string_view key, string &value);
+	void put(string_view key, string_view value, long delta);
+	void background();
+	bool flushFrozen();
+	bool compact();
+	bool saveManifest();
+	void loadManifest();
+public:
+	LsmTable(const string &dir);
+	virtual ~LsmTable();
+	bool create(string_view key, string &&value);
+	bool read(string_view key, string &value);
+	bool update(string_view key, string_view newValue);
+	bool deleteKey(string_view key);
+	bool isEmpty();
+	unsigned long currentSize();
+	void clear();
+	unsigned long count(string_view key);
+	void forEach(const function<void(const string &, const string &)> &visit);
+	bool createAt(string_view key, string &&value, int now, bool &expired);
+	bool updateAt(string_view key, string_view newValue, int now, bool &expired);
+	bool durable();
+	int flush();
+	LsmStats getStats();
+};
+
+#endif /* LSMTABLE_H_ */
@@ -25,6 +25,7 @@ MP1Node::MP1Node(Member *member, Params *params, EmulNet *emul, Log *log, Addres
 	this->log = log;
 	this->par = params;
 	this->memberNode->addr = *address;
+	this->gossipOffset = 0;
 }
 
 /**
@@ -43,7 +44,7 @@ int MP1Node::recvLoop() {
     	return false;
     }
     else {
-    	return emulNet->ENrecv(&(memberNode->addr), enqueueWrapper, NULL, 1, &(memberNode->mp1q));
+    	return emulNet->ENrecv(&(memberNode->addr), enqueueWrapper, NULL, 1, &(memberNode->mp1q), EN_CLASS_MASK(CONTROL_CLASS));
     }
 }
 
@@ -52,9 +53,9 @@ int MP1Node::recvLoop() {
  *
  * DESCRIPTION: Enqueue the message from Emulnet into the queue
  */
-int MP1Node::enqueueWrapper(void *env, char *buff, int size) {
+int MP1Node::enqueueWrapper(void *env, char *buff, int size, MsgBuffer *buf, char *tag, int tagSize) {
 	Queue q;
-	return q.enqueue((queue<q_elt> *)env, (void *)buff, size);
+	return q.enqueue((RingQueue<q_elt> *)env, (void *)buff, size, buf, tag, tagSize);
 }
 
 /**
@@ -116,7 +117,6 @@ int MP1Node::initThisNode(Address *joinaddr) {
  * DESCRIPTION: Join the distributed system
  */
 int MP1Node::introduceSelfToGroup(Address *joinaddr) {
-	MessageHdr *msg;
 #ifdef DEBUGLOG
     static char s[1024];
 #endif
@@ -129,11 +129,6 @@ int MP1Node::introduceSelfToGroup(Address *joinaddr) {
         memberNode->inGroup = true;
     }
     else {
-        
-        // Create JOINREQ message
-        msg = new MessageHdr();
-        msg->msgType = JOINREQ;
-        msg->sourceAddr = memberNode->addr;
 
 #ifdef DEBUGLOG
         // sprintf(s, "Trying to join...");
@@ -141,9 +136,7 @@ int MP1Node::introduceSelfToGroup(Address *joinaddr) {
 #endif
 
         // send JOINREQ message to introducer member
-        emulNet->ENsend(&memberNode->addr, joinaddr, (char *)msg, sizeof(MessageHdr));
-
-        free(msg);
+        send_message(JOINREQ, joinaddr, 0, false);
     }
 
     return 1;
@@ -193,15 +186,12 @@ void MP1Node::nodeLoop() {
  * DESCRIPTION: Check messages in the queue and call the respective message handler
  */
 void MP1Node::checkMessages() {
-    void *ptr;
-    int size;
-
     // Pop waiting messages from memberNode's mp1q
     while ( !memberNode->mp1q.empty() ) {
-    	ptr = memberNode->mp1q.front().elt;
-    	size = memberNode->mp1q.front().size;
-    	memberNode->mp1q.pop();
-    	recvCallBack((void *)memberNode, (char *)ptr, size);
+    	q_elt elt = memberNode->mp1q.front();
+    	memberNode->mp1q.pop_front();
+    	recvCallBack((void *)memberNode, (char *)elt.elt, elt.size);
+    	elt.release();
     }
     return;
 }
@@ -212,30 +202,86 @@ void MP1Node::checkMessages() {
  * DESCRIPTION: Message handler for different message types
  */
 bool MP1Node::recvCallBack(void *env, char *data, int size ) {
-	MessageHdr* msg = (MessageHdr*) data;
-
-    if(msg->msgType == JOINREQ){
-        join_req_processor(msg);   
-    }else if(msg->msgType == JOINREP){
-        join_rep_processor(msg);
-    }else if(msg->msgType == PING){
-        ping_processor(msg);
+	MessageWire *wire = (MessageWire *) data;
+	MemberWire *entries = (MemberWire *) (wire + 1);
+	MessageHdr msg;
+
+    if (size < (int)sizeof(MessageWire) || size != (int)(sizeof(MessageWire) + wire->count * sizeof(MemberWire))) {
+        return false;
+    }
+
+    msg.msgType = wire->msgType;
+    memcpy(msg.sourceAddr.addr, wire->sourceAddr, sizeof(msg.sourceAddr.addr));
+    msg.heartbeat = wire->heartbeat;
+    msg.membershipList.reserve(wire->count);
+    for (int i = 0; i < wire->count; i++) {
+        msg.membershipList.push_back(MemberListEntry(entries[i].id, entries[i].port, entries[i].heartbeat, entries[i].timestamp));
+    }
+
+    if(msg.msgType == JOINREQ){
+        join_req_processor(&msg);
+    }else if(msg.msgType == JOINREP){
+        join_rep_processor(&msg);
+    }else if(msg.msgType == PING){
+        ping_processor(&msg);
     }
     return true;
 }
 
+/**
+ * FUNCTION NAME: send_message
+ *
+ * DESCRIPTION: Flattens a message into a MessageWire and sends it as control traffic
+ */
+void MP1Node::send_message(enum MsgTypes type, Address *destinationAddr, long heartbeat, bool piggyback) {
+    vector<char> buffer;
+    build_message(type, heartbeat, piggyback, buffer);
+    emulNet->ENsend(&memberNode->addr, destinationAddr, buffer.data(), buffer.size(), CONTROL_CLASS);
+}
+
+/**
+ * FUNCTION NAME: build_message
+ *
+ * DESCRIPTION: Flattens a message into a MessageWire in buffer. With piggyback
+ * 				the membership list goes along, starting with this node's own
+ * 				entry. If the list does not fit in MAX_MSG_SIZE, a window of it
+ * 				that moves with every message is sent instead.
+ */
+void MP1Node::build_message(enum MsgTypes type, long heartbeat, bool piggyback, vector<char> &buffer) {
+    vector<MemberListEntry> &list = memberNode->memberList;
+    int room = (par->MAX_MSG_SIZE - sizeof(en_msg) - 1 - sizeof(MessageWire)) / sizeof(MemberWire);
+    int count = piggyback ? min((int)list.size(), room) : 0;
+    int rest = list.size() - 1;
+    int start = 0;
+
+    if (piggyback && count < (int)list.size()) {
+        start = gossipOffset % rest;
+        gossipOffset += count - 1;
+    }
+
+    buffer.resize(sizeof(MessageWire) + count * sizeof(MemberWire));
+    MessageWire *msg = (MessageWire *) buffer.data();
+    MemberWire *entries = (MemberWire *) (msg + 1);
+    msg->msgType = type;
+    memcpy(msg->sourceAddr, memberNode->addr.addr, sizeof(msg->sourceAddr));
+    msg->heartbeat = heartbeat;
+    msg->count = count;
+    for (int i = 0; i < count; i++) {
+        MemberListEntry &e = (i == 0) ? list[0] : list[1 + (start + i - 1) % rest];
+        entries[i].id = e.id;
+        entries[i].port = e.port;
+        entries[i].heartbeat = e.heartbeat;
+        entries[i].timestamp = e.timestamp;
+    }
+}
+
 void MP1Node::join_req_processor(MessageHdr* msg) {
     add_to_membership_list(transform_message_to_member(msg));
     send_join_rep(msg->sourceAddr);
 }
 
 void MP1Node::send_join_rep(Address destinationAddr) {
-    MessageHdr* msg = new MessageHdr();
-    msg->msgType = JOINREP;
-    msg->sourceAddr = memberNode->addr;
-    emulNet->ENsend(&memberNode->addr, &destinationAddr, (char*)msg, sizeof(MessageHdr));    
-    
-    free(msg);
+    send_message(JOINREP, &destinationAddr, 0, false);
 }
 
 void MP1Node::join_rep_processor(MessageHdr* msg) {
@@ -282,10 +328,11 @@ void MP1Node::nodeLoopOps() {
         memberNode->memberList[0].heartbeat++;
         memberNode->memberList[0].timestamp = par->getcurrtime();
 
+        vector<Address> destinations;
         for (int i = 1; i < memberNode->memberList.size(); i++) {
-            Address address = to_address(memberNode->memberList[i].id, memberNode->memberList[i].port);
-            ping(address);
+            destinations.push_back(to_address(memberNode->memberList[i].id, memberNode->memberList[i].port));
         }
+        ping(destinations);
         memberNode->pingCounter = TFAIL;
     } else {
         memberNode->pingCounter--;
@@ -310,15 +357,21 @@ bool MP1Node::detect_failure(vector<MemberListEntry>::iterator it) {
     return false;
 }
 
-void MP1Node::ping(Address destinationAddr) {
-    MessageHdr* msg = new MessageHdr();
-    msg->msgType = PING;
-    msg->membershipList = memberNode->memberList; // piggyback membership list
-    msg->sourceAddr = memberNode->addr;
-    msg->heartbeat = memberNode->heartbeat;
-    emulNet->ENsend( &memberNode->addr, &destinationAddr, (char*) msg, sizeof(MessageHdr));    
-    
-    free(msg);
+/**
+ * FUNCTION NAME: ping
+ *
+ * DESCRIPTION: Sends one PING, with the membership list piggybacked, to all of
+ * 				destinations
+ */
+void MP1Node::ping(vector<Address> &destinations) {
+    vector<char> buffer;
+    vector<int> results(destinations.size());
+
+    if (destinations.empty()) {
+        return;
+    }
+    build_message(PING, memberNode->heartbeat, true, buffer);
+    emulNet->ENmulticast(&memberNode->addr, destinations.data(), destinations.size(), buffer.data(), buffer.size(), NULL, 0, results.data(), CONTROL_CLASS);
 }
 
 vector<MemberListEntry>::iterator MP1Node::get_from_membership_list(MessageHdr* msg) {
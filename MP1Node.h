@@ -47,6 +47,30 @@ typedef struct MessageHdr {
 	vector<MemberListEntry> membershipList;
 } MessageHdr;
 
+/**
+ * STRUCT NAME: MessageWire
+ *
+ * DESCRIPTION: A MessageHdr as it is sent, followed by count MemberWire entries
+ */
+typedef struct MessageWire {
+	enum MsgTypes msgType;
+	char sourceAddr[6];
+	long heartbeat;
+	int count;
+} MessageWire;
+
+/**
+ * STRUCT NAME: MemberWire
+ *
+ * DESCRIPTION: A MemberListEntry as it is sent
+ */
+typedef struct MemberWire {
+	int id;
+	short port;
+	long heartbeat;
+	long timestamp;
+} MemberWire;
+
 /**
  * CLASS NAME: MP1Node
  *
@@ -59,11 +83,15 @@ private:
 	Params *par;
 	Member *memberNode;
 	char NULLADDR[6];
+	// Where the next piggybacked window of the membership list starts
+	unsigned int gossipOffset;
 
 	/* Methods for coordination */
 
+	void send_message(enum MsgTypes type, Address *destinationAddr, long heartbeat, bool piggyback);
+	void build_message(enum MsgTypes type, long heartbeat, bool piggyback, vector<char> &buffer);
 	void send_join_rep(Address destinationAddr);
-	void ping(Address destinationAddr);
+	void ping(vector<Address> &destinations);
 
 	void join_req_processor(MessageHdr* msg);
 	void join_rep_processor(MessageHdr* msg);
@@ -89,7 +117,7 @@ public:
 		return memberNode;
 	}
 	int recvLoop();
-	static int enqueueWrapper(void *env, char *buff, int size);
+	static int enqueueWrapper(void *env, char *buff, int size, MsgBuffer *buf, char *tag, int tagSize);
 	void nodeStart(char *servaddrstr, short serverport);
 	int initThisNode(Address *joinaddr);
 	int introduceSelfToGroup(Address *joinAddress);
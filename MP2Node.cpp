@@ -13,14 +13,55 @@ MP2Node::MP2Node(Member *memberNode, Params *par, EmulNet * emulNet, Log * log,
 	this->par = par;
 	this->emulNet = emulNet;
 	this->log = log;
-	ht = new HashTable();
 	this->memberNode->addr = *address;
+	this->outboxSize = 0;
+	this->wal = NULL;
+	this->keyFilter = NULL;
+	this->lastCheckpoint = par->getcurrtime();
+	if ( !par->STORAGE_DIR.empty() ) {
+		wal = new WriteAheadLog(par->STORAGE_DIR, *(int *)(address->addr), par->WAL_SYNC);
+	}
+	else if ( LSM_ENGINE == par->STORAGE_ENGINE || par->MEMORY_BUDGET > 0 ) {
+		// The log creates it otherwise
+		mkdir(par->ENGINE_DIR.c_str(), 0755);
+	}
+	if ( LSM_ENGINE == par->STORAGE_ENGINE ) {
+		ht = new LsmTable(par->ENGINE_DIR + "/node" + to_string(*(int *)(address->addr)) + ".lsm");
+		if ( NULL == wal ) {
+			// Nothing to recover from, a tree left by an earlier run is stale
+			ht->clear();
+		}
+	}
+	else if ( par->MEMORY_BUDGET > 0 ) {
+		ht = new BoundedTable(par->ENGINE_DIR + "/node" + to_string(*(int *)(address->addr)) + ".spill", par->MEMORY_BUDGET);
+	}
+	else {
+		ht = new ConcurrentHashTable();
+	}
+	if ( par->BLOOM_FILTER > 0 ) {
+		keyFilter = new CountingBloomFilter(par->BLOOM_FILTER);
+	}
+	if ( NULL != wal ) {
+		// A node coming back starts from what it had, not from the replicas
+		long records = wal->recover(ht);
+		ht->forEach([this](const string &key, const string &value) {
+			addKey(key);
+			if ( StorageEngine::expiryOf(value) != 0 ) {
+				expiries.schedule(StorageEngine::expiryOf(value), key);
+			}
+		});
+		if ( records > 0 || !ht->isEmpty() ) {
+			log->LOG(&memberNode->addr, "Recovered %lu keys from %ld records in %s", ht->currentSize(), records, par->STORAGE_DIR.c_str());
+		}
+	}
 }
 
 /**
  * Destructor
  */
 MP2Node::~MP2Node() {
+	delete wal;
+	delete keyFilter;
 	delete ht;
 	delete memberNode;
 }
@@ -69,10 +110,10 @@ void MP2Node::updateRing() {
 	 */
 	// Run stabilization protocol if the hash table size is greater than zero and if there has been a changed in the ring
 
-	ring = curMemList;
+	ring.swap(curMemList);
 
 	if (change){
-		stabilizationProtocol(); // run stability protocol for curMemList
+		stabilizationProtocol(curMemList); // run stability protocol for the old ring
 	}
 }
 
@@ -110,8 +151,9 @@ vector<Node> MP2Node::getMembershipList() {
  * RETURNS:
  * size_t position on the ring
  */
-size_t MP2Node::hashFunction(string key) {
-	std::hash<string> hashFunc;
+size_t MP2Node::hashFunction(string_view key) {
+	// Hashes like std::hash<string>, so keys keep their place on the ring
+	std::hash<string_view> hashFunc;
 	size_t ret = hashFunc(key);
 	return ret%RING_SIZE;
 }
@@ -125,15 +167,17 @@ size_t MP2Node::hashFunction(string key) {
  * 				2) Finds the replicas of this key
  * 				3) Sends a message to the replica
  */
-void MP2Node::clientCreate(string key, string value) {
+void MP2Node::clientCreate(string key, string value, int ttl) {
 
 	g_transID++;
 
 	if (quorumMap.find(g_transID) == quorumMap.end()) {
-		quorumMap.emplace(g_transID, Quorum(g_transID, CREATE, &memberNode->addr, key, value));
+		quorumMap.emplace(g_transID, Quorum(g_transID, CREATE, &memberNode->addr, key, value, par->getcurrtime()));
 	}
 	
-	sendClientMessage(CREATE, g_transID, key, value);
+	// The replicas get the tick it expires at, so they all drop the key at
+	// the same tick however late the message reaches them
+	sendClientMessage(CREATE, g_transID, key, value, ttl > 0 ? par->getcurrtime() + ttl : 0);
 }
 
 /**
@@ -150,7 +194,7 @@ void MP2Node::clientRead(string key){
 	g_transID++;
 
 	if (quorumMap.find(g_transID) == quorumMap.end()) {
-		quorumMap.emplace(g_transID, Quorum(g_transID, READ, &memberNode->addr, key,  ""));
+		quorumMap.emplace(g_transID, Quorum(g_transID, READ, &memberNode->addr, key,  "", par->getcurrtime()));
 	}
 
 	sendClientMessage(READ, g_transID, key, "");
@@ -165,13 +209,14 @@ void MP2Node::clientRead(string key){
  * 				2) Finds the replicas of this key
  * 				3) Sends a message to the replica
  */
-void MP2Node::clientUpdate(string key, string value){
+void MP2Node::clientUpdate(string key, string value, int ttl){
 	g_transID++;
 	if (quorumMap.find(g_transID) == quorumMap.end()) {
-		quorumMap.emplace(g_transID, Quorum(g_transID, UPDATE, &memberNode->addr, key, value));
+		quorumMap.emplace(g_transID, Quorum(g_transID, UPDATE, &memberNode->addr, key, value, par->getcurrtime()));
 	}
 
-	sendClientMessage(UPDATE, g_transID, key, value);
+	// An update without ttl leaves the key without expiry
+	sendClientMessage(UPDATE, g_transID, key, value, ttl > 0 ? par->getcurrtime() + ttl : 0);
 }
 
 
@@ -188,67 +233,53 @@ void MP2Node::clientDelete(string key){
 	g_transID++;
 
 	if (quorumMap.find(g_transID) == quorumMap.end()) {
-		quorumMap.emplace(g_transID, Quorum(g_transID, DELETE, &memberNode->addr, key, ""));
+		quorumMap.emplace(g_transID, Quorum(g_transID, DELETE, &memberNode->addr, key, "", par->getcurrtime()));
 	}
 	sendClientMessage(DELETE, g_transID, key, "");
 }
 
 
-void MP2Node::sendClientMessage(MessageType type, int txnId, string key, string value){
-
-	// construct the message based on type
-	Message* msg;
-
-	vector<Node> replicas = findNodes(key);
+void MP2Node::sendClientMessage(MessageType type, int txnId, string key, string value, int expiry){
 
 	// we require replica type set in message for create and update
 	bool requiresReplicaType = type == CREATE || type == UPDATE;
 
-	switch (type) {
-		case CREATE:
-			msg = new Message(txnId, memberNode->addr, CREATE, key, value);
-			break;
-		case READ:
-			msg = new Message(txnId, memberNode->addr, READ, key);
-			break;
-		case UPDATE:
-			msg = new Message(txnId, memberNode->addr, UPDATE, key, value);
-			break;
-		case DELETE:
-			msg = new Message(txnId, memberNode->addr, DELETE, key);
-			break;
-		default:
-			break;
+	if (type != CREATE && type != READ && type != UPDATE && type != DELETE) {
+		return;
 	}
+
+	// construct the message based on type
+	Message msg = requiresReplicaType ? Message(txnId, memberNode->addr, type, key, value) : Message(txnId, memberNode->addr, type, key);
+	msg.expiry = expiry;
+
 	// find the replicas of this key
-	// send a message to the replicas
-	for (int i=0; i<replicas.size(); i++){
-		
-		if (requiresReplicaType) msg->replica = ReplicaType(i);
-		emulNet->ENsend(&memberNode->addr, replicas.at(i).getAddress(), msg->toString());
-	
-	}
+	vector<Node> replicas = findNodes(key);
 
-	free(msg);
+	// send a message to the replicas, serialized once with the replica type
+	// sent as the tag of each replica
+	string tags;
+	if (requiresReplicaType) {
+		for (unsigned int i=0; i<replicas.size(); i++){
+			tags += (char)ReplicaType(i);
+		}
+	}
+	multicast(replicas, msg.encode(!requiresReplicaType), tags, requiresReplicaType ? 1 : 0, CLIENT_CLASS);
 }
 
-void MP2Node::replyToClient(Message msg, Address requesterAddress, bool success){
+void MP2Node::replyToClient(MessageView &msg, Address &requesterAddress, bool success){
 	if ((msg.type == CREATE || msg.type == DELETE) && msg.transID == -1) return;
-	Message* reply;
 	if (msg.type == CREATE || msg.type == UPDATE || msg.type == DELETE) {
-		reply = new Message(msg.transID, memberNode->addr, REPLY, success);
-		emulNet->ENsend(&memberNode->addr, &requesterAddress, reply->toString());
+		// encoded into a buffer kept from reply to reply
+		Message::encodeReply(replyData, msg.transID, memberNode->addr, success);
+		this->reply(&requesterAddress, replyData);
 	}
-	free(reply);
 }
 
-void MP2Node::readReplyToClient(Message msg, Address requesterAddress, string value){
-	Message* reply;
+void MP2Node::readReplyToClient(MessageView &msg, Address &requesterAddress, const string &value){
 	if (msg.type == READ) {
-		reply = new Message(msg.transID, memberNode->addr, value);
-		emulNet->ENsend(&memberNode->addr, &requesterAddress, reply->toString());
+		Message::encodeReadReply(replyData, msg.transID, memberNode->addr, value);
+		this->reply(&requesterAddress, replyData);
 	}
-	free(reply);
 }
 
 /**
@@ -259,28 +290,44 @@ void MP2Node::readReplyToClient(Message msg, Address requesterAddress, string va
  * 			   	1) Inserts key value into the local hash table
  * 			   	2) Return true or false based on success or failure
  */
-bool MP2Node::createKeyValue(string key, string value, ReplicaType replica, int transID, Address requesterAddr) {
+bool MP2Node::createKeyValue(string_view key, string_view value, ReplicaType replica, int transID, Address &requesterAddr, int expiry) {
 	
 	// Insert key, value, replicaType into the hash table
-	
-	if (transID != -1) {
-		bool success = ht->create(key, value);
-		if (success) {
-			log->logCreateSuccess(&requesterAddr, false, transID, key, value);
-		} else {
-			log->logCreateFail(&requesterAddr, false, transID, key, value);
-		}
+	string stored;
+	bool created, replaced;
 
-		return success;
-	} else {
-		string content = this->ht->read(key);
-		bool exist = (content != "");
-		if(!exist){
-			return this->ht->create(key, value);	
+	StorageEngine::packValue(stored, value, expiry);
+	if ( wal ) {
+		wal->create(key, stored);
+	}
+	// An expired key is gone even if the timing wheel has not dropped it yet,
+	// the table writes over it
+	created = ht->createAt(key, std::move(stored), par->getcurrtime(), replaced);
+	if ( replaced && wal ) {
+		// The create above does not take the place of the expired value
+		// when the log is replayed
+		StorageEngine::packValue(packed, value, expiry);
+		wal->update(key, packed);
+	}
+	if ( created ) {
+		if ( !replaced ) {
+			addKey(key);
+		}
+		if ( expiry != 0 ) {
+			expiries.schedule(expiry, string(key));
 		}
 	}
 
-	return false;
+	if (transID != -1) {
+		// A key that is already there keeps its value, the create still
+		// succeeds
+		log->logCreateSuccess(&requesterAddr, false, transID, key, value);
+
+		return true;
+	} else {
+		// Stabilization copies only fill in keys that are missing
+		return created;
+	}
 }
 
 /**
@@ -291,15 +338,108 @@ bool MP2Node::createKeyValue(string key, string value, ReplicaType replica, int
  * 			    1) Read key from local hash table
  * 			    2) Return value
  */
-string MP2Node::readKey(string key, int transID, Address requesterAddr) {
-	// Read key from local hash table and return value
-	string value = ht->read(key);
-	if (value != "") {
-		log->logReadSuccess(&requesterAddr, false, g_transID, key, value);
+const string &MP2Node::readKey(string_view key, int transID, Address &requesterAddr) {
+	// Read key from local hash table and return value, copied into a
+	// buffer that is reused from read to read. An expired key fails even
+	// before it is dropped.
+	if (mayHave(key) && ht->read(key, readValue) && !expired(readValue)) {
+		readValue.erase(0, EXPIRY_BYTES);
+		log->logReadSuccess(&requesterAddr, false, g_transID, key, readValue);
 	} else {
+		readValue.clear();
 		log->logReadFail(&requesterAddr, false, g_transID, key);
 	}
-	return value;
+	return readValue;
+}
+
+/**
+ * FUNCTION NAME: expired
+ *
+ * DESCRIPTION: Whether the key of a stored value is past its expiry
+ */
+bool MP2Node::expired(const string &stored) {
+	return StorageEngine::expiredAt(stored, par->getcurrtime());
+}
+
+/**
+ * FUNCTION NAME: expireKeys
+ *
+ * DESCRIPTION: Deletes the keys due to expire by now. Every replica does so on its
+ * 				own at the same tick, so expiry costs no messages.
+ */
+void MP2Node::expireKeys() {
+	vector<string> due;
+	string stored;
+
+	expiries.advance(par->getcurrtime(), due);
+	for (unsigned int i = 0; i < due.size(); i++) {
+		// Deleted or written again with another expiry since it was scheduled
+		if (ht->read(due[i], stored)) {
+			dropExpired(due[i], stored);
+		}
+	}
+}
+
+/**
+ * FUNCTION NAME: dropExpired
+ *
+ * DESCRIPTION: Deletes key if stored, its value in ht, is past its expiry
+ *
+ * RETURNS:
+ * true if the key has expired
+ */
+bool MP2Node::dropExpired(string_view key, const string &stored) {
+	if (!expired(stored)) {
+		return false;
+	}
+	if (ht->deleteKey(key)) {
+		removeKey(key);
+		if ( wal ) {
+			wal->erase(key);
+		}
+	}
+	return true;
+}
+
+/**
+ * FUNCTION NAME: addKey
+ *
+ * DESCRIPTION: Adds a key just created in ht to keyIndex and keyFilter. The filter
+ * 				is rebuilt twice as large from keyIndex once it holds more keys
+ * 				than it was sized for.
+ */
+void MP2Node::addKey(string_view key) {
+	keyIndex.insert(hashFunction(key), key);
+	if ( NULL == keyFilter ) {
+		return;
+	}
+	keyFilter->insert(key);
+	if ( keyFilter->full() ) {
+		keyFilter->reset(2 * keyIndex.size());
+		keyIndex.forArc(0, 0, [this](const string &indexed) {
+			keyFilter->insert(indexed);
+		});
+	}
+}
+
+/**
+ * FUNCTION NAME: removeKey
+ *
+ * DESCRIPTION: Removes a key just deleted from ht from keyIndex and keyFilter
+ */
+void MP2Node::removeKey(string_view key) {
+	if ( keyIndex.erase(hashFunction(key), key) && NULL != keyFilter ) {
+		keyFilter->erase(key);
+	}
+}
+
+/**
+ * FUNCTION NAME: mayHave
+ *
+ * DESCRIPTION: false means key is surely not in ht, so it need not be asked
+ */
+bool MP2Node::mayHave(string_view key) {
+	return NULL == keyFilter || keyFilter->mayContain(key);
 }
 
 /**
@@ -310,10 +450,25 @@ string MP2Node::readKey(string key, int transID, Address requesterAddr) {
  * 				1) Update the key to the new value in the local hash table
  * 				2) Return true or false based on success or failure
  */
-bool MP2Node::updateKeyValue(string key, string value, ReplicaType replica, int transID, Address requesterAddr) {
-	// Update key in local hash table and return true or false
-	bool success = ht->update(key, value);
+bool MP2Node::updateKeyValue(string_view key, string_view value, ReplicaType replica, int transID, Address &requesterAddr, int expiry) {
+	// Update key in local hash table and return true or false. An expired
+	// key fails, like a read of it, and is dropped by the table.
+	bool dropped = false;
+	StorageEngine::packValue(packed, value, expiry);
+	bool success = mayHave(key) && ht->updateAt(key, packed, par->getcurrtime(), dropped);
+	if (dropped) {
+		removeKey(key);
+		if ( wal ) {
+			wal->erase(key);
+		}
+	}
 	if (success) {
+		if ( wal ) {
+			wal->update(key, packed);
+		}
+		if ( expiry != 0 ) {
+			expiries.schedule(expiry, string(key));
+		}
 		log->logUpdateSuccess(&requesterAddr, false, transID, key, value);
 	} else {
 		log->logUpdateFail(&requesterAddr, false, transID, key, value);
@@ -329,10 +484,14 @@ bool MP2Node::updateKeyValue(string key, string value, ReplicaType replica, int
  * 				1) Delete the key from the local hash table
  * 				2) Return true or false based on success or failure
  */
-bool MP2Node::deletekey(string key, int transID, Address requesterAddr) {
+bool MP2Node::deletekey(string_view key, int transID, Address &requesterAddr) {
 	// Delete the key from the local hash table
-	bool success = ht->deleteKey(key);
+	bool success = mayHave(key) && ht->deleteKey(key);
 	if (success) {
+		removeKey(key);
+		if ( wal ) {
+			wal->erase(key);
+		}
 		log->logDeleteSuccess(&requesterAddr, false, g_transID, key);
 	} else {
 		log->logDeleteFail(&requesterAddr, false, g_transID, key);
@@ -352,61 +511,68 @@ void MP2Node::checkMessages() {
 	/*
 	 * Implement this. Parts of it are already implemented
 	 */
-	char * data;
-	int size;
-
 	/*
 	 * Declare your local variables here
 	 */
 
-	// dequeue all messages and handle them
-
-	Message* msg;
+	// dequeue all messages and handle them, parsed in place
+	MessageView msg;
 
 	map<int, Quorum>::iterator iter;
+
+	// traffic held back in earlier ticks goes out first
+	flushOutbox();
+	expireKeys();
+
 	while ( !memberNode->mp2q.empty() ) {
 		/*
 		 * Pop a message from the queue
 		 */
-		data = (char *)memberNode->mp2q.front().elt;
-		size = memberNode->mp2q.front().size;
-		memberNode->mp2q.pop();
-
-		string message(data, data + size);
+		q_elt elt = memberNode->mp2q.front();
+		memberNode->mp2q.pop_front();
 
 		/*
 		 * Handle the message types here
 		 */
 
-		msg = new Message(message);
+		// The key and value point into the buffer until it is released
+		if (!msg.parse((char *)elt.elt, elt.size, elt.tag)) {
+			elt.release();
+			continue;
+		}
 
-		switch (msg->type) {
+		switch (msg.type) {
 			case CREATE:
-				replyToClient(*msg, msg->fromAddr, createKeyValue(msg->key, msg->value, msg->replica, msg->transID, msg->fromAddr));
+				replyToClient(msg, msg.fromAddr, createKeyValue(msg.key, msg.value, msg.replica, msg.transID, msg.fromAddr, msg.expiry));
 				break;
 			case READ:
-				readReplyToClient(*msg, msg->fromAddr, readKey(msg->key, msg->transID, msg->fromAddr));
+				readReplyToClient(msg, msg.fromAddr, readKey(msg.key, msg.transID, msg.fromAddr));
 				break;
 			case UPDATE:
-				replyToClient(*msg, msg->fromAddr, updateKeyValue(msg->key, msg->value, msg->replica, msg->transID, msg->fromAddr));
+				replyToClient(msg, msg.fromAddr, updateKeyValue(msg.key, msg.value, msg.replica, msg.transID, msg.fromAddr, msg.expiry));
 				break;
 			case DELETE:
-				replyToClient(*msg, msg->fromAddr, deletekey(msg->key, msg->transID, msg->fromAddr));
+				replyToClient(msg, msg.fromAddr, deletekey(msg.key, msg.transID, msg.fromAddr));
 				break;
 			case REPLY:
-				iter = quorumMap.find(msg->transID);
-				iter->second.vote(msg->success);
+				// late replies for an operation that is already decided are dropped
+				iter = quorumMap.find(msg.transID);
+				if (iter != quorumMap.end()) {
+					iter->second.vote(msg.success);
+				}
 				break;
 			case READREPLY:
-				iter = quorumMap.find(msg->transID);
-				iter->second.setValue(msg->value);
-				iter->second.vote(msg->value != "");
+				iter = quorumMap.find(msg.transID);
+				if (iter != quorumMap.end()) {
+					iter->second.vote(!msg.value.empty());
+					iter->second.setValue(msg.value);
+				}
 				break;
 			default:
 				break;
 		}
 
-		free(msg);
+		elt.release();
 	}
 
 	/*
@@ -414,9 +580,51 @@ void MP2Node::checkMessages() {
 	* get QUORUM replies
 	*/
 
+	commitStorage();
 	checkQuorum();
 }
 
+/**
+ * FUNCTION NAME: reply
+ *
+ * DESCRIPTION: Sends a reply of the server side to toAddr, held back while changes
+ * 				it may acknowledge are not committed to disk
+ */
+void MP2Node::reply(Address *toAddr, const string &data) {
+	if ( wal && wal->pending() ) {
+		unsynced.push_back(make_pair(*toAddr, data));
+	}
+	else {
+		send(toAddr, data, CLIENT_CLASS);
+	}
+}
+
+/**
+ * FUNCTION NAME: commitStorage
+ *
+ * DESCRIPTION: Commits the changes of this tick to the write-ahead log in one
+ * 				batch, then lets the replies held for them go. Takes a snapshot
+ * 				every SNAPSHOT_EVERY ticks, which also keeps the log short.
+ */
+void MP2Node::commitStorage() {
+	if ( NULL == wal ) {
+		return;
+	}
+	if ( wal->commit() != SUCCESS ) {
+		// Not durable, so not acknowledged yet. The log keeps the changes
+		// for the next tick, the replies wait for them.
+		return;
+	}
+	while ( !unsynced.empty() ) {
+		send(&unsynced.front().first, unsynced.front().second, CLIENT_CLASS);
+		unsynced.pop_front();
+	}
+	if ( par->getcurrtime() - lastCheckpoint >= par->SNAPSHOT_EVERY ) {
+		wal->checkpoint(ht);
+		lastCheckpoint = par->getcurrtime();
+	}
+}
+
 void MP2Node::checkQuorum() {
 
 	// loop through the quorum map and check if any of the quorum has reached quorum
@@ -440,7 +648,7 @@ void MP2Node::checkQuorum() {
 				}
 				it = quorumMap.erase(it++);
 			}
-			else if (it->second.isQuorumFailed()) {
+			else if (it->second.isQuorumFailed(par->getcurrtime())) {
 				switch(it->second.getType()) {
 					case READ:
 						log->logReadFail(it->second.getRequester(), true, it->first, it->second.getKey());
@@ -473,8 +681,16 @@ void MP2Node::checkQuorum() {
  * DESCRIPTION: Find the replicas of the given keyfunction
  * 				This function is responsible for finding the replicas of a key
  */
-vector<Node> MP2Node::findNodes(string key) {
-	size_t pos = hashFunction(key);
+vector<Node> MP2Node::findNodes(string_view key) {
+	return ringReplicas(ring, hashFunction(key));
+}
+
+/**
+ * FUNCTION NAME: ringReplicas
+ *
+ * DESCRIPTION: Finds the replicas of the keys at position pos of the given ring
+ */
+vector<Node> MP2Node::ringReplicas(vector<Node> &ring, size_t pos) {
 	vector<Node> addr_vec;
 	if (ring.size() >= 3) {
 		// if pos <= min || pos > max, the leader is the min
@@ -499,6 +715,104 @@ vector<Node> MP2Node::findNodes(string key) {
 	return addr_vec;
 }
 
+/**
+ * FUNCTION NAME: send
+ *
+ * DESCRIPTION: Sends data to toAddr as traffic of class cls. While sends of the
+ * 				class to toAddr would block, data is queued behind the messages
+ * 				of the class already waiting for it, so each destination still
+ * 				gets the messages of a class in order.
+ */
+void MP2Node::send(Address *toAddr, const string &data, int cls) {
+	int dst = *(int *)(toAddr->addr) * NUM_CLASSES + cls;
+	map<int, deque< pair<Address, string> > >::iterator it = outbox.find(dst);
+
+	if ( it == outbox.end() ) {
+		int sent = emulNet->ENsend(&memberNode->addr, toAddr, data, cls);
+		if ( sent == EN_TOOBIG ) {
+			log->LOG(&memberNode->addr, "Message of %d bytes to %s is too big, not sent", (int)data.size(), toAddr->getAddress().c_str());
+		}
+		if ( sent != EN_WOULDBLOCK ) {
+			return;
+		}
+	}
+	outbox[dst].push_back(make_pair(*toAddr, data));
+	outboxSize++;
+}
+
+/**
+ * FUNCTION NAME: multicast
+ *
+ * DESCRIPTION: Sends data as traffic of class cls to every node of nodes, the
+ * 				i-th followed by the i-th tagSize bytes of tags. The payload goes
+ * 				out once through ENmulticast. Destinations with messages of the
+ * 				class waiting in the outbox, or towards which the send would
+ * 				block, get data and their tag queued like send does.
+ */
+void MP2Node::multicast(vector<Node> &nodes, const string &data, const string &tags, int tagSize, int cls) {
+	vector<Address> to;
+	vector<int> index;
+
+	for (unsigned int i = 0; i < nodes.size(); i++) {
+		Address *addr = nodes[i].getAddress();
+		int dst = *(int *)(addr->addr) * NUM_CLASSES + cls;
+		if ( outbox.find(dst) == outbox.end() ) {
+			to.push_back(*addr);
+			index.push_back(i);
+		}
+		else {
+			outbox[dst].push_back(make_pair(*addr, data + tags.substr(i * tagSize, tagSize)));
+			outboxSize++;
+		}
+	}
+	if ( to.empty() ) {
+		return;
+	}
+
+	string sendTags;
+	for (unsigned int i = 0; i < index.size(); i++) {
+		sendTags += tags.substr(index[i] * tagSize, tagSize);
+	}
+	vector<int> results(to.size());
+	emulNet->ENmulticast(&memberNode->addr, to.data(), to.size(), (char *)data.data(), data.size(), (char *)sendTags.data(), tagSize, results.data(), cls);
+
+	for (unsigned int i = 0; i < to.size(); i++) {
+		if ( results[i] == EN_TOOBIG ) {
+			log->LOG(&memberNode->addr, "Message of %d bytes to %s is too big, not sent", (int)data.size() + tagSize, to[i].getAddress().c_str());
+		}
+		else if ( results[i] == EN_WOULDBLOCK ) {
+			outbox[*(int *)(to[i].addr) * NUM_CLASSES + cls].push_back(make_pair(to[i], data + sendTags.substr(i * tagSize, tagSize)));
+			outboxSize++;
+		}
+	}
+}
+
+/**
+ * FUNCTION NAME: flushOutbox
+ *
+ * DESCRIPTION: Sends the queued messages of every destination and class until
+ * 				sends of the class to it would block again. Called once per tick, so queued traffic is
+ * 				paced by the credit the destinations give back as they receive.
+ */
+void MP2Node::flushOutbox() {
+	map<int, deque< pair<Address, string> > >::iterator it = outbox.begin();
+
+	while ( it != outbox.end() ) {
+		deque< pair<Address, string> > &pending = it->second;
+		while ( !pending.empty() && emulNet->ENsend(&memberNode->addr, &pending.front().first, pending.front().second, it->first % NUM_CLASSES) != EN_WOULDBLOCK ) {
+			pending.pop_front();
+			outboxSize--;
+		}
+		if ( pending.empty() ) {
+			outbox.erase(it++);
+		}
+		else {
+			it++;
+		}
+	}
+	emulNet->countQueued(*(int *)(memberNode->addr.addr), outboxSize);
+}
+
 /**
  * FUNCTION NAME: recvLoop
  *
@@ -509,7 +823,7 @@ bool MP2Node::recvLoop() {
     	return false;
     }
     else {
-    	return emulNet->ENrecv(&(memberNode->addr), this->enqueueWrapper, NULL, 1, &(memberNode->mp2q));
+    	return emulNet->ENrecv(&(memberNode->addr), this->enqueueWrapper, NULL, 1, &(memberNode->mp2q), EN_CLASS_MASK(CLIENT_CLASS) | EN_CLASS_MASK(BULK_CLASS));
     }
 }
 
@@ -518,9 +832,9 @@ bool MP2Node::recvLoop() {
  *
  * DESCRIPTION: Enqueue the message from Emulnet into the queue of MP2Node
  */
-int MP2Node::enqueueWrapper(void *env, char *buff, int size) {
+int MP2Node::enqueueWrapper(void *env, char *buff, int size, MsgBuffer *buf, char *tag, int tagSize) {
 	Queue q;
-	return q.enqueue((queue<q_elt> *)env, (void *)buff, size);
+	return q.enqueue((RingQueue<q_elt> *)env, (void *)buff, size, buf, tag, tagSize);
 }
 /**
  * FUNCTION NAME: stabilizationProtocol
@@ -530,32 +844,84 @@ int MP2Node::enqueueWrapper(void *env, char *buff, int size) {
  * 				The function does the following:
  *				1) Ensures that there are three "CORRECT" replicas of all the keys in spite of failures and joins
  *				Note:- "CORRECT" replicas implies that every key is replicated in its two neighboring nodes in the ring
+ *				The copies go out as bulk traffic, behind membership and client messages
+ *				Only the arcs of the ring whose replicas changed are looked at, and
+ *				their keys only go to the replicas they did not have before, so
+ *				the work follows the data that moves rather than all the data held
  */
-void MP2Node::stabilizationProtocol() {
-	map<string, string>::iterator it;
-
-	for(it = this->ht->hashTable.begin(); it != this->ht->hashTable.end(); it++) {
-		string key = it->first;
-		string value = it->second;
-		vector<Node> replicas = findNodes(key);
+void MP2Node::stabilizationProtocol(vector<Node> &oldRing) {
+	// The copies are read from one point in time, writes go on meanwhile
+	shared_ptr<TableSnapshot> view = ht->openSnapshot();
+	vector<size_t> bounds;
+	string value;
+
+	// Between two neighbouring positions of nodes of either ring, the keys
+	// have the same replicas in each
+	for (unsigned int i = 0; i < oldRing.size(); i++) {
+		bounds.push_back(oldRing[i].getHashCode());
+	}
+	for (unsigned int i = 0; i < ring.size(); i++) {
+		bounds.push_back(ring[i].getHashCode());
+	}
+	sort(bounds.begin(), bounds.end());
+	bounds.erase(unique(bounds.begin(), bounds.end()), bounds.end());
 
-		Message createMsg(-1, this->memberNode->addr, CREATE, key, value);
+	for (unsigned int i = 0; i < bounds.size(); i++) {
+		size_t from = bounds[(i + bounds.size() - 1) % bounds.size()];
+		size_t to = bounds[i];
+		vector<Node> gained = newReplicas(oldRing, to);
 
-		for (int i = 0; i < replicas.size(); i++) {
-			emulNet->ENsend(&memberNode->addr, replicas[i].getAddress(), createMsg.toString());
+		if (gained.empty()) {
+			continue;
 		}
+		keyIndex.forArc(from, to, [&](const string &key) {
+			if (view->read(key, value) && !expired(value)) {
+				// The copies keep the expiry, so they go at the same tick
+				Message createMsg(-1, this->memberNode->addr, CREATE, key, string(StorageEngine::payloadOf(value)));
+				createMsg.expiry = StorageEngine::expiryOf(value);
+				multicast(gained, createMsg.encode(false), "", 0, BULK_CLASS);
+			}
+		});
+	}
 
-		for (map<int, Quorum>::iterator it = quorumMap.begin(); it != quorumMap.end(); it++) {
+	// Operations in flight on keys that moved go to the new replicas too
+	for (map<int, Quorum>::iterator it = quorumMap.begin(); it != quorumMap.end(); it++) {
+		const string &key = it->second.getKey();
+		size_t pos = hashFunction(key);
+		if (!keyIndex.contains(pos, key) || !view->read(key, value) || expired(value)) {
+			continue;
+		}
+		vector<Node> gained = newReplicas(oldRing, pos);
+		if (!gained.empty()) {
+			Message transactionMessage(it->second.getTxnId(), memberNode->addr, it->second.getType(), key, string(StorageEngine::payloadOf(value)));
+			transactionMessage.expiry = StorageEngine::expiryOf(value);
 
-			if (it->second.getKey() == key) {
-				Message transactionMessage(it->second.getTxnId(), memberNode->addr, it->second.getType(), key, value);
+			multicast(gained, transactionMessage.encode(false), "", 0, BULK_CLASS);
+		}
+	}
+}
 
-				for (int i = 0; i < replicas.size(); i++) {
-					emulNet->ENsend(&memberNode->addr, replicas[i].getAddress(), transactionMessage.toString());
-				}
-			}
+/**
+ * FUNCTION NAME: newReplicas
+ *
+ * DESCRIPTION: Returns the replicas of the keys at position pos in the ring that
+ * 				were not replicas of them in oldRing
+ */
+vector<Node> MP2Node::newReplicas(vector<Node> &oldRing, size_t pos) {
+	vector<Node> before = ringReplicas(oldRing, pos);
+	vector<Node> after = ringReplicas(ring, pos);
+	vector<Node> gained;
+
+	for (unsigned int i = 0; i < after.size(); i++) {
+		bool had = false;
+		for (unsigned int j = 0; j < before.size() && !had; j++) {
+			had = before[j].nodeAddress == after[i].nodeAddress;
+		}
+		if (!had) {
+			gained.push_back(after[i]);
 		}
 	}
+	return gained;
 }
 
 Quorum::Quorum() {
@@ -565,16 +931,18 @@ Quorum::Quorum() {
     this->value = "";
     this->success = 0;
     this->failure = 0;
+    this->timestamp = 0;
 }
 
-Quorum::Quorum(int txnId, MessageType type, Address * requester, string key, string value) {
+Quorum::Quorum(int txnId, MessageType type, Address * requester, string key, string value, int timestamp) {
     this->txnId = txnId;
     this->type = type;
 	this->requester = requester;
-    this->key = key;
-    this->value = value;
+    this->key = std::move(key);
+    this->value = std::move(value);
     this->success = 0;
     this->failure = 0;
+    this->timestamp = timestamp;
 }
 
 /**
@@ -587,6 +955,7 @@ Quorum& Quorum::operator =(const Quorum &anotherQ) {
     this->value = anotherQ.value;
     this->success = anotherQ.success;
     this->failure = anotherQ.failure;
+    this->timestamp = anotherQ.timestamp;
     return *this;
 }
 
@@ -606,8 +975,15 @@ int Quorum::getTotalVotes() {
     return this->success + this->failure;
 }
 
-bool Quorum::isQuorumFailed() {
-    return (this->getTotalVotes() >= 2 && this->failure > this->success) || this->getTotalVotes() == 1;
+/**
+ * Replies may arrive over several ticks, so an operation that has not
+ * gathered a quorum of successes fails once every replica answered or
+ * QUORUM_TIMEOUT ticks went by.
+ */
+bool Quorum::isQuorumFailed(int currtime) {
+    return (this->getTotalVotes() >= 2 && this->failure > this->success)
+        || (this->getTotalVotes() >= REPLICAS && !this->isQuorumSucceeded())
+        || (currtime - this->timestamp >= QUORUM_TIMEOUT);
 }
 
 bool Quorum::isQuorumSucceeded() {
@@ -622,11 +998,11 @@ int Quorum::getFailure() {
     return this->failure;
 }
 
-string Quorum::getKey() {
+const string &Quorum::getKey() {
     return this->key;
 }
 
-string Quorum::getValue() {
+const string &Quorum::getValue() {
     return this->value;
 }
 
@@ -638,8 +1014,8 @@ Address * Quorum::getRequester() {
 	return this->requester;
 }
 
-void Quorum::setValue(string value) {
-	this->value = value;
+void Quorum::setValue(string_view value) {
+	this->value.assign(value);
 }
 
 string Quorum::toString() {
@@ -13,34 +13,51 @@
 #include "stdincludes.h"
 #include "EmulNet.h"
 #include "Node.h"
-#include "HashTable.h"
+#include "ConcurrentHashTable.h"
+#include "LsmTable.h"
+#include "BoundedTable.h"
+#include "RingIndex.h"
+#include "CountingBloomFilter.h"
+#include "TimingWheel.h"
+#include "WriteAheadLog.h"
 #include "Log.h"
 #include "Params.h"
 #include "Message.h"
+#include "MessageView.h"
 #include "Queue.h"
 
+/**
+ * Macros
+ */
+// replicas of every key
+#define REPLICAS 3
+// ticks a coordinator waits for a quorum of replies before failing the operation
+#define QUORUM_TIMEOUT 10
+
 class Quorum {
 private:
     int success;
     int failure;
     int txnId;
+    // tick the operation was issued at
+    int timestamp;
 	Address * requester;
     MessageType type;
     string key;
     string value;
 public:
     Quorum();
-    Quorum(int txnId, MessageType type, Address * requester, string key, string value);
+    Quorum(int txnId, MessageType type, Address * requester, string key, string value, int timestamp);
     Quorum& operator =(const Quorum &anotherQ);
     
     int getTotalVotes();
-    bool isQuorumFailed();
+    bool isQuorumFailed(int currtime);
     bool isQuorumSucceeded();
     void vote(bool _success);
     int getTxnId();
-    string getKey();
-    string getValue();
-	void setValue(string value);
+    const string &getKey();
+    const string &getValue();
+	void setValue(string_view value);
     MessageType getType();
 	Address * getRequester();
     int getSuccess();
@@ -68,7 +85,25 @@ private:
 	// Ring
 	vector<Node> ring;
 	// Hash Table
-	HashTable * ht;
+	StorageEngine * ht;
+	// Keys of ht by ring position
+	RingIndex keyIndex;
+	// Keys of ht, NULL unless Params give BLOOM_FILTER
+	CountingBloomFilter * keyFilter;
+	// Value of the last read, its capacity is kept for the next ones
+	string readValue;
+	// Value of the last update with its expiry header, likewise
+	string packed;
+	// Last reply sent, likewise
+	string replyData;
+	// Keys written with an expiry, by the tick it is due
+	TimingWheel<string> expiries;
+	// Log and snapshots of ht on disk, NULL unless Params give STORAGE
+	WriteAheadLog * wal;
+	// Replies acknowledging changes not committed to wal yet
+	deque< pair<Address, string> > unsynced;
+	// Tick of the last snapshot
+	int lastCheckpoint;
 	// Member representing this member
 	Member *memberNode;
 	// Params object
@@ -77,9 +112,27 @@ private:
 	EmulNet * emulNet;
 	// Object of Log
 	Log * log;
-
-	void sendClientMessage(MessageType type, int txnId, string key, string value);
+	// Messages waiting for credit towards their destination, by
+	// node id * NUM_CLASSES + traffic class
+	map<int, deque< pair<Address, string> > > outbox;
+	// Number of messages in outbox
+	int outboxSize;
+
+	void send(Address *toAddr, const string &data, int cls);
+	void multicast(vector<Node> &nodes, const string &data, const string &tags, int tagSize, int cls);
+	void flushOutbox();
+	void reply(Address *toAddr, const string &data);
+	void commitStorage();
+	void sendClientMessage(MessageType type, int txnId, string key, string value, int expiry = 0);
+	bool expired(const string &stored);
+	bool dropExpired(string_view key, const string &stored);
+	void addKey(string_view key);
+	void removeKey(string_view key);
+	bool mayHave(string_view key);
+	void expireKeys();
 	void runStabilizationProtocol(vector<Node> ring);
+	static vector<Node> ringReplicas(vector<Node> &ring, size_t pos);
+	vector<Node> newReplicas(vector<Node> &oldRing, size_t pos);
 
 public:
 	// map of transaction id to quorum
@@ -93,22 +146,23 @@ public:
 	// ring functionalities
 	void updateRing();
 	vector<Node> getMembershipList();
-	size_t hashFunction(string key);
+	size_t hashFunction(string_view key);
 	void findNeighbors();
 
 	// client side CRUD APIs
-	void clientCreate(string key, string value);
+	// a ttl > 0 makes the key expire that many ticks from now
+	void clientCreate(string key, string value, int ttl = 0);
 	void clientRead(string key);
-	void clientUpdate(string key, string value);
+	void clientUpdate(string key, string value, int ttl = 0);
 	void clientDelete(string key);
 
 	// reply to client
-	void replyToClient(Message message, Address requesterAddress, bool success);
-	void readReplyToClient(Message msg, Address requesterAddress, string value);
+	void replyToClient(MessageView &message, Address &requesterAddress, bool success);
+	void readReplyToClient(MessageView &msg, Address &requesterAddress, const string &value);
 
 	// receive messages from Emulnet
 	bool recvLoop();
-	static int enqueueWrapper(void *env, char *buff, int size);
+	static int enqueueWrapper(void *env, char *buff, int size, MsgBuffer *buf, char *tag, int tagSize);
 
 	// handle messages from receiving queue
 	void checkMessages();
@@ -117,16 +171,16 @@ public:
 	void dispatchMessages(Message message);
 
 	// find the addresses of nodes that are responsible for a key
-	vector<Node> findNodes(string key);
+	vector<Node> findNodes(string_view key);
 
-	// server
-	bool createKeyValue(string key, string value, ReplicaType replica, int transID, Address requesterAddr);
-	string readKey(string key, int transID, Address requesterAddr);
-	bool updateKeyValue(string key, string value, ReplicaType replica, int transID, Address requesterAddr);
-	bool deletekey(string key, int transID, Address requesterAddr);
+	// server, keys and values are only looked at, they may point into a received message
+	bool createKeyValue(string_view key, string_view value, ReplicaType replica, int transID, Address &requesterAddr, int expiry = 0);
+	const string &readKey(string_view key, int transID, Address &requesterAddr);
+	bool updateKeyValue(string_view key, string_view value, ReplicaType replica, int transID, Address &requesterAddr, int expiry = 0);
+	bool deletekey(string_view key, int transID, Address &requesterAddr);
 
 	// stabilization protocol - handle multiple failures
-	void stabilizationProtocol();
+	void stabilizationProtocol(vector<Node> &oldRing);
 
 	void checkQuorum();
 
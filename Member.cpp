@@ -9,7 +9,27 @@
 /**
  * Constructor
  */
-q_elt::q_elt(void *elt, int size): elt(elt), size(size) {}
+q_elt::q_elt(void *elt, int size, MsgBuffer *buf, const char *tag, int tagSize): elt(elt), size(size), buf(buf) {
+	if ( tagSize > 0 ) {
+		this->tag.assign(tag, tagSize);
+	}
+}
+
+/**
+ * FUNCTION NAME: release
+ *
+ * DESCRIPTION: Frees the payload once the entry has been handled
+ */
+void q_elt::release() {
+	if ( NULL != buf ) {
+		buf->release();
+	}
+	else {
+		free(elt);
+	}
+	elt = NULL;
+	buf = NULL;
+}
 
 /**
  * Copy constructor
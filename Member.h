@@ -8,6 +8,8 @@
 #define MEMBER_H_
 
 #include "stdincludes.h"
+#include "MsgBuffer.h"
+#include "RingQueue.h"
 
 /**
  * CLASS NAME: q_elt
@@ -18,7 +20,12 @@ class q_elt {
 public:
 	void *elt;
 	int size;
-	q_elt(void *elt, int size);
+	// Buffer holding elt, if any. Owned by this entry until release().
+	MsgBuffer *buf;
+	// Bytes ENmulticast sent along with a shared elt, as if they followed it
+	string tag;
+	q_elt(void *elt = NULL, int size = 0, MsgBuffer *buf = NULL, const char *tag = NULL, int tagSize = 0);
+	void release();
 };
 
 /**
@@ -109,9 +116,9 @@ public:
 	// My position in the membership table
 	vector<MemberListEntry>::iterator myPos;
 	// Queue for failure detection messages
-	queue<q_elt> mp1q;
+	RingQueue<q_elt> mp1q;
 	// Queue for KVstore messages
-	queue<q_elt> mp2q;
+	RingQueue<q_elt> mp2q;
 	/**
 	 * Constructor
 	 */
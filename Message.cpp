@@ -4,6 +4,7 @@
  * DESCRIPTION: Message class definition
  **********************************/
 #include "Message.h"
+#include "MessageView.h"
 
 /**
  * Constructor
@@ -11,48 +12,33 @@
 // transID::fromAddr::CREATE::key::value::ReplicaType
 // transID::fromAddr::READ::key
 // transID::fromAddr::UPDATE::key::value::ReplicaType
+// a create or update of a key that expires has the expiry before the replica type:
+// transID::fromAddr::CREATE::key::value::expiry::ReplicaType
 // transID::fromAddr::DELETE::key
 // transID::fromAddr::REPLY::sucess
 // transID::fromAddr::READREPLY::value
-Message::Message(string message){
-	this->delimiter = "::";
-	vector<string> tuple;
-	size_t pos = message.find(delimiter);
-	size_t start = 0;
-	while (pos != string::npos) {
-		string field = message.substr(start, pos-start);
-		tuple.push_back(field);
-		start = pos + 2;
-		pos = message.find(delimiter, start);
-	}
-	tuple.push_back(message.substr(start));
+Message::Message(string message): Message(message.data(), (int)message.size()) {}
 
-	transID = stoi(tuple.at(0));
-	Address addr(tuple.at(1));
-	fromAddr = addr;
-	type = static_cast<MessageType>(stoi(tuple.at(2)));
-	switch(type){
-		case CREATE:
-		case UPDATE:
-			key = tuple.at(3);
-			value = tuple.at(4);
-			if (tuple.size() > 5)
-				replica = static_cast<ReplicaType>(stoi(tuple.at(5)));
-			break;
-		case READ:
-		case DELETE:
-			key = tuple.at(3);
-			break;
-		case REPLY:
-			if (tuple.at(3) == "1")
-				success = true;
-			else
-				success = false;
-			break;
-		case READREPLY:
-			value = tuple.at(3);
-			break;
-	}
+/**
+ * Constructor
+ *
+ * DESCRIPTION: Parse the fields out of a received buffer, in either format, and copy
+ * 				them. Throws invalid_argument if it is not a whole message.
+ */
+Message::Message(const char *data, int size){
+	MessageView view;
+
+	if (!view.parse(data, size))
+		throw invalid_argument("Message");
+	this->delimiter = "::";
+	type = view.type;
+	replica = view.replica;
+	key.assign(view.key);
+	value.assign(view.value);
+	fromAddr = view.fromAddr;
+	transID = view.transID;
+	success = view.success;
+	expiry = view.expiry;
 }
 
 /**
@@ -61,6 +47,7 @@ Message::Message(string message){
 // construct a create or update message
 Message::Message(int _transID, Address _fromAddr, MessageType _type, string _key, string _value, ReplicaType _replica){
 	this->delimiter = "::";
+	this->expiry = 0;
 	transID = _transID;
 	fromAddr = _fromAddr;
 	type = _type;
@@ -81,6 +68,7 @@ Message::Message(const Message& anotherMessage) {
 	this->transID = anotherMessage.transID;
 	this->type = anotherMessage.type;
 	this->value = anotherMessage.value;
+	this->expiry = anotherMessage.expiry;
 }
 
 /**
@@ -88,6 +76,7 @@ Message::Message(const Message& anotherMessage) {
  */
 Message::Message(int _transID, Address _fromAddr, MessageType _type, string _key, string _value){
 	this->delimiter = "::";
+	this->expiry = 0;
 	transID = _transID;
 	fromAddr = _fromAddr;
 	type = _type;
@@ -101,6 +90,7 @@ Message::Message(int _transID, Address _fromAddr, MessageType _type, string _key
 // construct a read or delete message
 Message::Message(int _transID, Address _fromAddr, MessageType _type, string _key){
 	this->delimiter = "::";
+	this->expiry = 0;
 	transID = _transID;
 	fromAddr = _fromAddr;
 	type = _type;
@@ -113,6 +103,7 @@ Message::Message(int _transID, Address _fromAddr, MessageType _type, string _key
 // construct reply message
 Message::Message(int _transID, Address _fromAddr, MessageType _type, bool _success){
 	this->delimiter = "::";
+	this->expiry = 0;
 	transID = _transID;
 	fromAddr = _fromAddr;
 	type = _type;
@@ -125,6 +116,7 @@ Message::Message(int _transID, Address _fromAddr, MessageType _type, bool _succe
 // construct read reply message
 Message::Message(int _transID, Address _fromAddr, string _value){
 	this->delimiter = "::";
+	this->expiry = 0;
 	transID = _transID;
 	fromAddr = _fromAddr;
 	type = READREPLY;
@@ -134,14 +126,19 @@ Message::Message(int _transID, Address _fromAddr, string _value){
 /**
  * FUNCTION NAME: toString
  *
- * DESCRIPTION: Serialized Message in string format
+ * DESCRIPTION: Serialized Message in string format. Without withReplica a create or
+ * 				update ends with the delimiter before the replica type.
  */
-string Message::toString(){
+string Message::toString(bool withReplica){
 	string message = to_string(transID) + delimiter + fromAddr.getAddress() + delimiter + to_string(type) + delimiter;
 	switch(type){
 		case CREATE:
 		case UPDATE:
-			message += key + delimiter + value + delimiter + to_string(replica);
+			message += key + delimiter + value + delimiter;
+			if (expiry != 0)
+				message += to_string(expiry) + delimiter;
+			if (withReplica)
+				message += to_string(replica);
 			break;
 		case READ:
 		case DELETE:
@@ -160,6 +157,136 @@ string Message::toString(){
 	return message;
 }
 
+/**
+ * FUNCTION NAME: encode
+ *
+ * DESCRIPTION: Serialized Message in the binary format. Without withReplica a create
+ * 				or update ends before the replica type.
+ */
+string Message::encode(bool withReplica){
+	string message;
+
+	message.reserve(MSG_HEADER_BYTES + 3 * MSG_VARINT_BYTES + 1 + key.size() + value.size());
+	putHeader(message, type, transID, fromAddr);
+	switch(type){
+		case CREATE:
+		case UPDATE:
+			putVarint(message, key.size());
+			message += key;
+			putVarint(message, value.size());
+			message += value;
+			putVarint(message, (uint32_t)expiry);
+			if (withReplica)
+				message += (char)replica;
+			break;
+		case READ:
+		case DELETE:
+			putVarint(message, key.size());
+			message += key;
+			break;
+		case REPLY:
+			message += (char)(success ? 1 : 0);
+			break;
+		case READREPLY:
+			putVarint(message, value.size());
+			message += value;
+			break;
+	}
+	return message;
+}
+
+/**
+ * FUNCTION NAME: putHeader
+ *
+ * DESCRIPTION: Appends the header of the binary format to out
+ */
+void Message::putHeader(string &out, MessageType type, int transID, Address &fromAddr){
+	uint32_t id = transID;
+
+	out += (char)MSG_WIRE_VERSION;
+	out += (char)type;
+	out.append((const char *)&id, 4);
+	out.append(fromAddr.addr, sizeof(fromAddr.addr));
+}
+
+/**
+ * FUNCTION NAME: encodeReply
+ *
+ * DESCRIPTION: Replaces out with a REPLY as encode would write it, without building
+ * 				a Message. out keeps its capacity, so a buffer reused for every
+ * 				reply is not allocated again.
+ */
+void Message::encodeReply(string &out, int transID, Address &fromAddr, bool success){
+	out.clear();
+	putHeader(out, REPLY, transID, fromAddr);
+	out += (char)(success ? 1 : 0);
+}
+
+/**
+ * FUNCTION NAME: encodeReadReply
+ *
+ * DESCRIPTION: Replaces out with a READREPLY carrying value, likewise
+ */
+void Message::encodeReadReply(string &out, int transID, Address &fromAddr, string_view value){
+	out.clear();
+	putHeader(out, READREPLY, transID, fromAddr);
+	putVarint(out, value.size());
+	out.append(value.data(), value.size());
+}
+
+/**
+ * FUNCTION NAME: putVarint
+ *
+ * DESCRIPTION: Appends value to out, 7 bits a byte
+ */
+void Message::putVarint(string &out, uint64_t value){
+	while (value >= 0x80) {
+		out += (char)(value | 0x80);
+		value >>= 7;
+	}
+	out += (char)value;
+}
+
+/**
+ * FUNCTION NAME: getVarint
+ *
+ * DESCRIPTION: Reads a varint at p into value
+ *
+ * RETURNS:
+ * where it ends, NULL if it runs past end
+ */
+const char *Message::getVarint(const char *p, const char *end, uint64_t *value){
+	uint64_t result = 0;
+
+	for (int shift = 0; p < end && shift < 64; shift += 7) {
+		unsigned char byte = *p++;
+		result |= (uint64_t)(byte & 0x7f) << shift;
+		if (0 == (byte & 0x80)) {
+			*value = result;
+			return p;
+		}
+	}
+	return NULL;
+}
+
+/**
+ * FUNCTION NAME: getBytes
+ *
+ * DESCRIPTION: Reads a size and that many bytes at p, bytes points into the buffer
+ *
+ * RETURNS:
+ * where they end, NULL if they run past end
+ */
+const char *Message::getBytes(const char *p, const char *end, string_view *bytes){
+	uint64_t size;
+
+	p = getVarint(p, end, &size);
+	if (NULL == p || size > (uint64_t)(end - p))
+		return NULL;
+	*bytes = string_view(p, size);
+	return p + size;
+}
+
 /**
  * Assignment operator overloading
  */
@@ -172,5 +299,6 @@ Message& Message::operator =(const Message& anotherMessage) {
 	this->transID = anotherMessage.transID;
 	this->type = anotherMessage.type;
 	this->value = anotherMessage.value;
+	this->expiry = anotherMessage.expiry;
 	return *this;
 }
@@ -9,13 +9,42 @@
 #include "stdincludes.h"
 #include "Member.h"
 #include "common.h"
+#include <stdexcept>
+
+/*
+ * Macros
+ */
+// First byte of a message in the binary format, text ones start with a digit or '-'
+#define MSG_WIRE_VERSION 0x81
+// Version, type, transID and fromAddr
+#define MSG_HEADER_BYTES 12
+// Longest varint of 64 bits
+#define MSG_VARINT_BYTES 10
 
 /**
  * CLASS NAME: Message
  *
  * DESCRIPTION: This class is used for message passing among nodes
+ *
+ * 				Messages are sent in a binary format:
+ * 					version (1) | type (1) | transID (4) | fromAddr (6)
+ * 				followed by, for
+ * 					CREATE, UPDATE	key | value | expiry (varint) | replica (1)
+ * 					READ, DELETE	key
+ * 					REPLY			success (1)
+ * 					READREPLY		value
+ * 				where a key or value is its size as a varint (7 bits a byte,
+ * 				low first, high bit set on all bytes but the last) and its
+ * 				bytes, so they may hold anything, "::" included. The replica
+ * 				type comes last so that a multicast can append it per
+ * 				destination. Integers are little endian.
+ * 				The older text format of toString is still understood on
+ * 				receipt, the version byte telling them apart. Both are parsed
+ * 				by MessageView.
  */
 class Message{
+private:
+	static void putHeader(string &out, MessageType type, int transID, Address &fromAddr);
 public:
 	MessageType type;
 	ReplicaType replica;
@@ -24,10 +53,14 @@ public:
 	Address fromAddr;
 	int transID;
 	bool success; // success or not 
+	// tick a created or updated key expires at, 0 for never
+	int expiry;
 	// delimiter
 	string delimiter;
 	// construct a message from a string
 	Message(string message);
+	// construct a message from received bytes, in either format
+	Message(const char *data, int size);
 	Message(const Message& anotherMessage);
 	// construct a create or update message
 	Message(int _transID, Address _fromAddr, MessageType _type, string _key, string _value);
@@ -39,8 +72,18 @@ public:
 	// construct read reply message
 	Message(int _transID, Address _fromAddr, string _value);
 	Message& operator = (const Message& anotherMessage);
-	// serialize to a string
-	string toString();
+	// serialize to a string, withReplica false leaves the replica type of a create
+	// or update out so that it can be appended per destination
+	string toString(bool withReplica = true);
+	// serialize to the binary format, withReplica as for toString
+	string encode(bool withReplica = true);
+	// serialize replies into a buffer kept from message to message
+	static void encodeReply(string &out, int transID, Address &fromAddr, bool success);
+	static void encodeReadReply(string &out, int transID, Address &fromAddr, string_view value);
+
+	static void putVarint(string &out, uint64_t value);
+	static const char *getVarint(const char *p, const char *end, uint64_t *value);
+	static const char *getBytes(const char *p, const char *end, string_view *bytes);
 };
 
 #endif
@@ -0,0 +1,175 @@
+/**********************************
+ * FILE NAME: MessageView.cpp
+ *
+ * DESCRIPTION: MessageView class definition
+ **********************************/
+#include "MessageView.h"
+
+/**
+ * Constructor
+ */
+MessageView::MessageView() {
+	type = REPLY;
+	replica = PRIMARY;
+	fromAddr.init();
+	transID = 0;
+	success = false;
+	expiry = 0;
+}
+
+/**
+ * FUNCTION NAME: parse
+ *
+ * DESCRIPTION: Points the fields at the message in data, telling the formats apart
+ * 				by the first byte
+ *
+ * RETURNS:
+ * false if data is not a whole message
+ */
+bool MessageView::parse(const char *data, int size, string_view tag) {
+	key = string_view();
+	value = string_view();
+	replica = PRIMARY;
+	success = false;
+	expiry = 0;
+	if ( size > 0 && MSG_WIRE_VERSION == (unsigned char)data[0] ) {
+		return decode(data, size, tag);
+	}
+	return parseText(data, size);
+}
+
+/**
+ * FUNCTION NAME: decode
+ *
+ * DESCRIPTION: Parses a message in the format of Message::encode, tag standing
+ * 				for the bytes after data
+ */
+bool MessageView::decode(const char *data, int size, string_view tag) {
+	const char *p = data + MSG_HEADER_BYTES;
+	const char *end = data + size;
+	uint64_t number;
+	uint32_t id;
+	unsigned int kind = PRIMARY;
+
+	if ( size < MSG_HEADER_BYTES ) {
+		return false;
+	}
+	if ( (unsigned char)data[1] > READREPLY ) {
+		return false;
+	}
+	type = static_cast<MessageType>((unsigned char)data[1]);
+	memcpy(&id, data + 2, 4);
+	transID = (int)id;
+	memcpy(fromAddr.addr, data + 6, sizeof(fromAddr.addr));
+	switch ( type ) {
+		case CREATE:
+		case UPDATE:
+			if ( NULL == (p = Message::getBytes(p, end, &key)) || NULL == (p = Message::getBytes(p, end, &value))
+					|| NULL == (p = Message::getVarint(p, end, &number)) ) {
+				return false;
+			}
+			expiry = (int)number;
+			// Left out of stabilization copies, sent as the tag of a multicast
+			if ( p < end ) {
+				kind = (unsigned char)*p;
+			}
+			else if ( !tag.empty() ) {
+				kind = (unsigned char)tag[0];
+			}
+			if ( kind > TERTIARY ) {
+				return false;
+			}
+			replica = static_cast<ReplicaType>(kind);
+			return true;
+		case READ:
+		case DELETE:
+			return NULL != Message::getBytes(p, end, &key);
+		case REPLY:
+			if ( p >= end ) {
+				return false;
+			}
+			success = 0 != *p;
+			return true;
+		case READREPLY:
+			return NULL != Message::getBytes(p, end, &value);
+	}
+	return false;
+}
+
+/**
+ * FUNCTION NAME: parseText
+ *
+ * DESCRIPTION: Parses a message in the format of Message::toString, splitting it on
+ * 				every "::" as Message always has
+ */
+bool MessageView::parseText(const char *data, int size) {
+	string_view text(data, size);
+	string_view fields[MSG_TEXT_FIELDS];
+	string_view address, replicaField;
+	size_t start = 0, pos, colon;
+	int count = 0, kind, id, replicaKind = PRIMARY;
+	short port;
+
+	for ( ;; ) {
+		pos = text.find("::", start);
+		if ( count < MSG_TEXT_FIELDS ) {
+			fields[count] = text.substr(start, pos == string_view::npos ? string_view::npos : pos - start);
+		}
+		count++;
+		if ( pos == string_view::npos ) {
+			break;
+		}
+		start = pos + 2;
+	}
+	if ( count < 4 || !parseNumber(fields[0], &transID) || !parseNumber(fields[2], &kind) ) {
+		return false;
+	}
+	address = fields[1];
+	colon = address.find(':');
+	if ( colon == string_view::npos || !parseNumber(address.substr(0, colon), &id)
+			|| !parseNumber(address.substr(colon + 1), &port) ) {
+		return false;
+	}
+	memcpy(&fromAddr.addr[0], &id, sizeof(int));
+	memcpy(&fromAddr.addr[4], &port, sizeof(short));
+
+	if ( kind < CREATE || kind > READREPLY ) {
+		return false;
+	}
+	type = static_cast<MessageType>(kind);
+	switch ( type ) {
+		case CREATE:
+		case UPDATE:
+			if ( count < 5 ) {
+				return false;
+			}
+			key = fields[3];
+			value = fields[4];
+			// Either field may be left empty
+			if ( count > 6 ) {
+				parseNumber(fields[5], &expiry);
+				replicaField = fields[6];
+			}
+			else if ( count > 5 ) {
+				replicaField = fields[5];
+			}
+			if ( parseNumber(replicaField, &replicaKind) ) {
+				if ( replicaKind < PRIMARY || replicaKind > TERTIARY ) {
+					return false;
+				}
+				replica = static_cast<ReplicaType>(replicaKind);
+			}
+			return true;
+		case READ:
+		case DELETE:
+			key = fields[3];
+			return true;
+		case REPLY:
+			success = fields[3] == "1";
+			return true;
+		case READREPLY:
+			value = fields[3];
+			return true;
+	}
+	return false;
+}
@@ -0,0 +1,56 @@
+/**********************************
+ * FILE NAME: MessageView.h
+ *
+ * DESCRIPTION: MessageView class header file
+ **********************************/
+#ifndef MESSAGEVIEW_H_
+#define MESSAGEVIEW_H_
+
+#include "stdincludes.h"
+#include "Member.h"
+#include "Message.h"
+#include "common.h"
+#include <charconv>
+
+/*
+ * Macros
+ */
+// Fields of a text message looked at, later ones are counted only
+#define MSG_TEXT_FIELDS 7
+
+/**
+ * CLASS NAME: MessageView
+ *
+ * DESCRIPTION: The fields of a received message, parsed where it lies. key and
+ * 				value point into the buffer parsed, so they hold until it is
+ * 				released or the view parses another one. Parsing allocates
+ * 				nothing, so the receive path can handle a message without
+ * 				building a Message. Both the binary format of Message::encode
+ * 				and the text one of Message::toString are understood.
+ */
+class MessageView {
+private:
+	bool decode(const char *data, int size, string_view tag);
+	bool parseText(const char *data, int size);
+	template <class T>
+	static bool parseNumber(string_view text, T *number) {
+		return !text.empty() && from_chars(text.data(), text.data() + text.size(), *number).ec == errc();
+	}
+public:
+	MessageType type;
+	ReplicaType replica;
+	string_view key;
+	string_view value;
+	Address fromAddr;
+	int transID;
+	bool success;
+	// tick a created or updated key expires at, 0 for never
+	int expiry;
+
+	MessageView();
+	// false if data is not a whole message. tag holds bytes sent along with
+	// data, read as if they followed it.
+	bool parse(const char *data, int size, string_view tag = string_view());
+};
+
+#endif /* MESSAGEVIEW_H_ */
@@ -0,0 +1,50 @@
+/**********************************
+ * FILE NAME: MsgBuffer.cpp
+ *
+ * DESCRIPTION: Definition of the reference counted message buffer
+ **********************************/
+
+#include "MsgBuffer.h"
+#include "SlabAllocator.h"
+
+/**
+ * FUNCTION NAME: alloc
+ *
+ * DESCRIPTION: Returns a stand-alone buffer of size bytes with a single reference
+ */
+MsgBuffer *MsgBuffer::alloc(int size) {
+	MsgBuffer *buf = (MsgBuffer *) malloc(sizeof(MsgBuffer) + size);
+	buf->refcnt = 1;
+	buf->size = size;
+	buf->capacity = size;
+	buf->owner = -1;
+	buf->pool = NULL;
+	return buf;
+}
+
+/**
+ * FUNCTION NAME: retain
+ *
+ * DESCRIPTION: Adds an owner to the buffer
+ */
+void MsgBuffer::retain() {
+	refcnt++;
+}
+
+/**
+ * FUNCTION NAME: release
+ *
+ * DESCRIPTION: Drops an owner. The last owner gives the buffer back.
+ */
+void MsgBuffer::release() {
+	if ( --refcnt > 0 ) {
+		return;
+	}
+
+	if ( NULL != pool ) {
+		pool->release(this);
+	}
+	else {
+		free(this);
+	}
+}
@@ -0,0 +1,50 @@
+/**********************************
+ * FILE NAME: MsgBuffer.h
+ *
+ * DESCRIPTION: Header file of the reference counted message buffer
+ **********************************/
+
+#ifndef MSGBUFFER_H_
+#define MSGBUFFER_H_
+
+#include "stdincludes.h"
+
+/*
+ * Macros
+ */
+// smallest pooled buffer (bytes after the header) and number of power of two classes
+#define MSGBUF_MIN_CLASS 64
+#define MSGBUF_NUM_CLASSES 8
+
+class SlabAllocator;
+
+/**
+ * CLASS NAME: MsgBuffer
+ *
+ * DESCRIPTION: A byte buffer shared by reference between the sender, EmulNet and
+ * 				the receiving node's queue. The bytes live right after the object.
+ * 				The last release() hands the buffer back to the SlabAllocator it
+ * 				came from, or to free() if it was allocated on its own.
+ */
+class MsgBuffer {
+public:
+	// Number of owners of this buffer
+	int refcnt;
+	// Bytes in use
+	int size;
+	// Bytes available in data()
+	int capacity;
+	// Node whose free list the buffer returns to
+	int owner;
+	// Allocator the buffer came from, NULL if malloc'ed
+	SlabAllocator *pool;
+
+	static MsgBuffer *alloc(int size);
+	void retain();
+	void release();
+	char *data() {
+		return (char *)(this + 1);
+	}
+};
+
+#endif /* MSGBUFFER_H_ */
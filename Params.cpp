@@ -9,7 +9,11 @@
 /**
  * Constructor
  */
-Params::Params(): PORTNUM(8001) {}
+Params::Params(): PORTNUM(8001), COMPRESS(NO_COMPRESS), WAL_SYNC(GROUP_SYNC), SNAPSHOT_EVERY(100), STORAGE_ENGINE(HASH_ENGINE), MEMORY_BUDGET(0), BLOOM_FILTER(8) {
+	CLASS_WEIGHT[CONTROL_CLASS] = 8;
+	CLASS_WEIGHT[CLIENT_CLASS] = 4;
+	CLASS_WEIGHT[BULK_CLASS] = 1;
+}
 
 /**
  * FUNCTION NAME: setparams
@@ -19,6 +23,8 @@ Params::Params(): PORTNUM(8001) {}
 void Params::setparams(char *config_file) {
 	//trace.funcEntry("Params::setparams");
 	char CRUD[10];
+	char key[64];
+	char line[256];
 	FILE *fp = fopen(config_file,"r");
 
 	fscanf(fp,"MAX_NNB: %d", &MAX_NNB);
@@ -42,6 +48,105 @@ void Params::setparams(char *config_file) {
 
 	//printf("Parameters of the test case: %d %d %d %lf\n", MAX_NNB, SINGLE_FAILURE, DROP_MSG, MSG_DROP_PROB);
 
+	// Emulated links are ideal unless the remaining lines say otherwise
+	LINK_DELAY.type = CONST_DELAY;
+	LINK_DELAY.a = 0;
+	LINK_DELAY.b = 0;
+	EGRESS_BW = 0;
+	COMPRESS = NO_COMPRESS;
+	CLASS_WEIGHT[CONTROL_CLASS] = 8;
+	CLASS_WEIGHT[CLIENT_CLASS] = 4;
+	CLASS_WEIGHT[BULK_CLASS] = 1;
+	STORAGE_DIR.clear();
+	ENGINE_DIR.clear();
+	WAL_SYNC = GROUP_SYNC;
+	SNAPSHOT_EVERY = 100;
+	STORAGE_ENGINE = HASH_ENGINE;
+	MEMORY_BUDGET = 0;
+	BLOOM_FILTER = 8;
+	linkDelays.clear();
+	nodeEgressBW.clear();
+
+	while ( fscanf(fp, " %63[^:]: ", key) == 1 && NULL != fgets(line, sizeof(line), fp) ) {
+		int from, to, bw, n;
+		LinkDelay delay;
+		if ( 0 == strcmp(key, "LINK_DELAY") ) {
+			parseDelay(line, &LINK_DELAY);
+		}
+		else if ( 0 == strcmp(key, "LINK") && sscanf(line, "%d %d %n", &from, &to, &n) == 2 && parseDelay(line + n, &delay) ) {
+			linkDelays[make_pair(from, to)] = delay;
+		}
+		else if ( 0 == strcmp(key, "EGRESS_BW") ) {
+			sscanf(line, "%d", &EGRESS_BW);
+		}
+		else if ( 0 == strcmp(key, "NODE_EGRESS_BW") && sscanf(line, "%d %d", &from, &bw) == 2 ) {
+			nodeEgressBW[from] = bw;
+		}
+		else if ( 0 == strcmp(key, "COMPRESS") ) {
+			if ( 0 == strncmp(line, "lzdict", 6) ) {
+				COMPRESS = LZ_DICT_COMPRESS;
+			}
+			else if ( 0 == strncmp(line, "lz", 2) ) {
+				COMPRESS = LZ_COMPRESS;
+			}
+			else {
+				COMPRESS = NO_COMPRESS;
+			}
+		}
+		else if ( 0 == strcmp(key, "CLASS_WEIGHT") ) {
+			int weight[NUM_CLASSES];
+			if ( sscanf(line, "%d %d %d", &weight[CONTROL_CLASS], &weight[CLIENT_CLASS], &weight[BULK_CLASS]) == NUM_CLASSES ) {
+				for ( n = 0; n < NUM_CLASSES; n++ ) {
+					// A class without weight would never be sent
+					CLASS_WEIGHT[n] = max(1, weight[n]);
+				}
+			}
+		}
+		else if ( 0 == strcmp(key, "STORAGE") ) {
+			char dir[256];
+			if ( sscanf(line, "%255s", dir) == 1 ) {
+				STORAGE_DIR = dir;
+			}
+		}
+		else if ( 0 == strcmp(key, "WAL_SYNC") ) {
+			if ( 0 == strncmp(line, "none", 4) ) {
+				WAL_SYNC = NO_SYNC;
+			}
+			else if ( 0 == strncmp(line, "always", 6) ) {
+				WAL_SYNC = ALWAYS_SYNC;
+			}
+			else {
+				WAL_SYNC = GROUP_SYNC;
+			}
+		}
+		else if ( 0 == strcmp(key, "SNAPSHOT_EVERY") ) {
+			sscanf(line, "%d", &SNAPSHOT_EVERY);
+			// Every tick at most
+			SNAPSHOT_EVERY = max(1, SNAPSHOT_EVERY);
+		}
+		else if ( 0 == strcmp(key, "STORAGE_ENGINE") ) {
+			STORAGE_ENGINE = 0 == strncmp(line, "lsm", 3) ? LSM_ENGINE : HASH_ENGINE;
+		}
+		else if ( 0 == strcmp(key, "MEMORY_BUDGET") ) {
+			const char *units = "KMG";
+			const char *unit;
+			char c = 0;
+			MEMORY_BUDGET = 0;
+			sscanf(line, "%lu%c", &MEMORY_BUDGET, &c);
+			if ( 0 != c && NULL != (unit = strchr(units, toupper(c))) ) {
+				MEMORY_BUDGET <<= 10 * (unit - units + 1);
+			}
+		}
+		else if ( 0 == strcmp(key, "BLOOM_FILTER") ) {
+			sscanf(line, "%d", &BLOOM_FILTER);
+			BLOOM_FILTER = max(0, BLOOM_FILTER);
+		}
+	}
+
+	// LSM trees and spill files need a directory, the write-ahead log only
+	// runs when STORAGE asked for it
+	ENGINE_DIR = STORAGE_DIR.empty() ? "storage" : STORAGE_DIR;
+
 	EN_GPSZ = MAX_NNB;
 	STEP_RATE=.25;
 	MAX_MSG_SIZE = 4000;
@@ -65,3 +170,65 @@ void Params::setparams(char *config_file) {
 int Params::getcurrtime(){
     return globaltime;
 }
+
+/**
+ * FUNCTION NAME: parseDelay
+ *
+ * DESCRIPTION: Parse "<const|uniform|normal|exp> <a> [<b>]" into delay
+ */
+bool Params::parseDelay(char *spec, LinkDelay *delay) {
+	char type[16];
+	double a = 0, b = 0;
+
+	if ( sscanf(spec, "%15s %lf %lf", type, &a, &b) < 2 ) {
+		return false;
+	}
+	if ( 0 == strcmp(type, "const") ) {
+		delay->type = CONST_DELAY;
+	}
+	else if ( 0 == strcmp(type, "uniform") ) {
+		delay->type = UNIFORM_DELAY;
+	}
+	else if ( 0 == strcmp(type, "normal") ) {
+		delay->type = NORMAL_DELAY;
+	}
+	else if ( 0 == strcmp(type, "exp") ) {
+		delay->type = EXP_DELAY;
+	}
+	else {
+		return false;
+	}
+	delay->a = a;
+	delay->b = b;
+	return true;
+}
+
+/**
+ * FUNCTION NAME: getLinkDelay
+ *
+ * DESCRIPTION: Return the delay distribution of the link between two node ids
+ */
+LinkDelay Params::getLinkDelay(int from, int to) {
+	if ( !linkDelays.empty() ) {
+		map< pair<int, int>, LinkDelay >::iterator it = linkDelays.find(make_pair(from, to));
+		if ( it != linkDelays.end() ) {
+			return it->second;
+		}
+	}
+	return LINK_DELAY;
+}
+
+/**
+ * FUNCTION NAME: getEgressBW
+ *
+ * DESCRIPTION: Return the egress cap of a node in bytes per tick, 0 if unlimited
+ */
+int Params::getEgressBW(int node) {
+	if ( !nodeEgressBW.empty() ) {
+		map<int, int>::iterator it = nodeEgressBW.find(node);
+		if ( it != nodeEgressBW.end() ) {
+			return it->second;
+		}
+	}
+	return EGRESS_BW;
+}
@@ -12,11 +12,69 @@
 #include "Member.h"
 
 enum testTYPE { CREATE_TEST, READ_TEST, UPDATE_TEST, DELETE_TEST };
+// link delay distributions
+enum delayTYPE { CONST_DELAY, UNIFORM_DELAY, NORMAL_DELAY, EXP_DELAY };
+// frame codecs, the values go on the wire
+enum compressTYPE { NO_COMPRESS, LZ_COMPRESS, LZ_DICT_COMPRESS };
+// traffic classes sharing a network, most urgent first, the values go on the wire
+enum trafficCLASS { CONTROL_CLASS, CLIENT_CLASS, BULK_CLASS, NUM_CLASSES };
+// when the write-ahead log is synced to disk
+enum syncPOLICY { NO_SYNC, GROUP_SYNC, ALWAYS_SYNC };
+// what a node keeps its keys in
+enum engineTYPE { HASH_ENGINE, LSM_ENGINE };
+
+/**
+ * STRUCT NAME: LinkDelay
+ *
+ * DESCRIPTION: Delay distribution of a link, in ticks
+ * 				CONST_DELAY:   a
+ * 				UNIFORM_DELAY: a to b
+ * 				NORMAL_DELAY:  mean a, standard deviation b
+ * 				EXP_DELAY:     mean a
+ */
+typedef struct LinkDelay {
+	int type;
+	double a;
+	double b;
+} LinkDelay;
 
 /**
  * CLASS NAME: Params
  *
  * DESCRIPTION: Params class describing the test cases
+ *
+ * 				Optional lines after CRUD_TEST describe the emulated links:
+ * 				LINK_DELAY: <const|uniform|normal|exp> <a> [<b>]	delay of every link
+ * 				LINK: <from id> <to id> <const|uniform|normal|exp> <a> [<b>]	delay of one link
+ * 				EGRESS_BW: <bytes per tick>		egress cap of every node, 0 is unlimited
+ * 				NODE_EGRESS_BW: <id> <bytes per tick>	egress cap of one node
+ * 				COMPRESS: <none|lz|lzdict>		codec of the frames sent, lzdict
+ * 				uses the dictionary built into LZCodec
+ * 				CLASS_WEIGHT: <control> <client> <bulk>	shares of a busy egress
+ * 				link the traffic classes get, 8 4 1 by default
+ *
+ * 				and where nodes keep their tables:
+ * 				STORAGE: <directory>	write-ahead log and snapshots of every
+ * 				node go there, and nodes recover their keys from them on start.
+ * 				Without this line there is no log, no fsync and no recovery.
+ * 				WAL_SYNC: <none|group|always>	fdatasync never, once per tick
+ * 				(default) or once per change
+ * 				SNAPSHOT_EVERY: <ticks>		ticks between snapshots, 100 by default
+ * 				STORAGE_ENGINE: <hash|lsm>	tables in memory (default) or in
+ * 				an LSM tree under ENGINE_DIR. With lsm the snapshots are flushes
+ * 				of the tree. Without STORAGE the tree starts empty every run.
+ * 				MEMORY_BUDGET: <bytes>[K|M|G]	bytes a hash table may take, values
+ * 				that do not fit go to a spill file under ENGINE_DIR. 0, the
+ * 				default, is unbounded. Neither turns on the write-ahead log.
+ * 				BLOOM_FILTER: <counters per key>	size of the counting bloom
+ * 				filter that answers reads, updates and deletes of absent keys
+ * 				without asking the table. More counters cost 4 bits each and
+ * 				let fewer absent keys through: with the default 8 about 2% once
+ * 				the filter holds as many keys as it is sized for, fewer until
+ * 				then (tests/CountingBloomFilterTest measures it). 0 turns it off.
+ *
+ * 				ENGINE_DIR, where LSM trees and spill files go, is STORAGE when
+ * 				given and "storage" otherwise.
  */
 class Params{
 public:
@@ -32,9 +90,26 @@ public:
 	int allNodesJoined;
 	short PORTNUM;
 	int CRUDTEST;
+	LinkDelay LINK_DELAY;
+	map< pair<int, int>, LinkDelay > linkDelays;
+	int EGRESS_BW;
+	map<int, int> nodeEgressBW;
+	int COMPRESS;
+	int CLASS_WEIGHT[NUM_CLASSES];
+	string STORAGE_DIR;
+	string ENGINE_DIR;
+	int WAL_SYNC;
+	int SNAPSHOT_EVERY;
+	int STORAGE_ENGINE;
+	unsigned long MEMORY_BUDGET;
+	int BLOOM_FILTER;
 	Params();
 	void setparams(char *);
 	int getcurrtime();
+	LinkDelay getLinkDelay(int from, int to);
+	int getEgressBW(int node);
+private:
+	bool parseDelay(char *spec, LinkDelay *delay);
 };
 
 #endif /* _PARAMS_H_ */
@@ -0,0 +1,108 @@
+/**********************************
+ * FILE NAME: RingIndex.cpp
+ *
+ * DESCRIPTION: RingIndex class definition
+ **********************************/
+
+#include "RingIndex.h"
+
+RingIndex::RingIndex() {
+	keys = 0;
+}
+
+/**
+ * FUNCTION NAME: insert
+ *
+ * DESCRIPTION: Adds key at position pos, unless it is there already
+ */
+void RingIndex::insert(size_t pos, string_view key) {
+	set<string, less<> > &atPos = positions[pos];
+
+	if ( atPos.find(key) == atPos.end() ) {
+		atPos.emplace(key);
+		keys++;
+	}
+}
+
+/**
+ * FUNCTION NAME: erase
+ *
+ * DESCRIPTION: Removes key from position pos
+ *
+ * RETURNS:
+ * true if it was there
+ */
+bool RingIndex::erase(size_t pos, string_view key) {
+	map<size_t, set<string, less<> > >::iterator it = positions.find(pos);
+	set<string, less<> >::iterator entry;
+
+	if ( it == positions.end() || (entry = it->second.find(key)) == it->second.end() ) {
+		return false;
+	}
+	it->second.erase(entry);
+	if ( it->second.empty() ) {
+		positions.erase(it);
+	}
+	keys--;
+	return true;
+}
+
+/**
+ * FUNCTION NAME: contains
+ *
+ * DESCRIPTION: Whether key is at position pos
+ */
+bool RingIndex::contains(size_t pos, string_view key) {
+	map<size_t, set<string, less<> > >::iterator it = positions.find(pos);
+
+	return it != positions.end() && it->second.find(key) != it->second.end();
+}
+
+/**
+ * FUNCTION NAME: forArc
+ *
+ * DESCRIPTION: Calls visit on every key at a position after from and up to to,
+ * 				going round the end of the ring if to is not after from. The
+ * 				arc is the whole ring if from == to. visit must not change the
+ * 				index.
+ */
+void RingIndex::forArc(size_t from, size_t to, const function<void(const string &)> &visit) {
+	map<size_t, set<string, less<> > >::iterator it, end;
+	set<string, less<> >::iterator key;
+
+	if ( from < to ) {
+		end = positions.upper_bound(to);
+		for ( it = positions.upper_bound(from); it != end; it++ ) {
+			for ( key = it->second.begin(); key != it->second.end(); key++ ) {
+				visit(*key);
+			}
+		}
+		return;
+	}
+	// Wraps: (from, end of the ring) then [start of the ring, to]
+	for ( it = positions.upper_bound(from); it != positions.end(); it++ ) {
+		for ( key = it->second.begin(); key != it->second.end(); key++ ) {
+			visit(*key);
+		}
+	}
+	end = positions.upper_bound(to);
+	for ( it = positions.begin(); it != end; it++ ) {
+		for ( key = it->second.begin(); key != it->second.end(); key++ ) {
+			visit(*key);
+		}
+	}
+}
+
+/**
+ * FUNCTION NAME: size
+ *
+ * DESCRIPTION: Returns the number of keys
+ */
+unsigned long RingIndex::size() {
+	return keys;
+}
+
+void RingIndex::clear() {
+	positions.clear();
+	keys = 0;
+}
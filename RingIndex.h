@@ -0,0 +1,40 @@
+/**********************************
+ * FILE NAME: RingIndex.h
+ *
+ * DESCRIPTION: Header file RingIndex class
+ **********************************/
+
+#ifndef RINGINDEX_H_
+#define RINGINDEX_H_
+
+/**
+ * Header files
+ */
+#include "stdincludes.h"
+#include <functional>
+
+/**
+ * CLASS NAME: RingIndex
+ *
+ * DESCRIPTION: The keys of a node ordered by their position on the ring, which is
+ * 				computed once when a key is added. Lets stabilization go over the
+ * 				keys of one arc of the ring without touching the others. Only
+ * 				keys are kept, values stay in the node's table. Used by the
+ * 				node's own thread only.
+ */
+class RingIndex {
+private:
+	// Keys by position
+	map<size_t, set<string, less<> > > positions;
+	unsigned long keys;
+public:
+	RingIndex();
+	void insert(size_t pos, string_view key);
+	bool erase(size_t pos, string_view key);
+	bool contains(size_t pos, string_view key);
+	void forArc(size_t from, size_t to, const function<void(const string &)> &visit);
+	unsigned long size();
+	void clear();
+};
+
+#endif /* RINGINDEX_H_ */
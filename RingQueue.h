@@ -0,0 +1,78 @@
+/**********************************
+ * FILE NAME: RingQueue.h
+ *
+ * DESCRIPTION: FIFO queue kept in one circular buffer that is reused
+ **********************************/
+
+#ifndef RINGQUEUE_H_
+#define RINGQUEUE_H_
+
+#include "stdincludes.h"
+
+/*
+ * Macros
+ */
+#define RING_QUEUE_MIN 16
+
+/**
+ * CLASS NAME: RingQueue
+ *
+ * DESCRIPTION: Queue of items in a power of two sized circular buffer that only
+ * 				grows, by doubling, when it is full. Unlike std::deque, which
+ * 				frees and allocates a block every few hundred bytes the queue
+ * 				moves through, a queue that stays within its largest size so far
+ * 				never allocates again. Items can also be put back at the front.
+ */
+template <class T>
+class RingQueue {
+private:
+	vector<T> slots;
+	// Index of the front item
+	size_t head;
+	// Number of items queued
+	size_t count;
+
+	void grow() {
+		vector<T> larger(max((size_t)RING_QUEUE_MIN, 2 * slots.size()));
+		for ( size_t i = 0; i < count; i++ ) {
+			larger[i] = std::move(slots[(head + i) & (slots.size() - 1)]);
+		}
+		slots.swap(larger);
+		head = 0;
+	}
+
+public:
+	RingQueue(): head(0), count(0) {}
+	bool empty() const {
+		return 0 == count;
+	}
+	size_t size() const {
+		return count;
+	}
+	T &front() {
+		return slots[head];
+	}
+	void push_back(const T &item) {
+		if ( count == slots.size() ) {
+			grow();
+		}
+		slots[(head + count) & (slots.size() - 1)] = item;
+		count++;
+	}
+	void push_front(const T &item) {
+		if ( count == slots.size() ) {
+			grow();
+		}
+		head = (head + slots.size() - 1) & (slots.size() - 1);
+		slots[head] = item;
+		count++;
+	}
+	// Drops the front item, leaving its slot default constructed so it holds on to nothing
+	void pop_front() {
+		slots[head] = T();
+		head = (head + 1) & (slots.size() - 1);
+		count--;
+	}
+};
+
+#endif /* RINGQUEUE_H_ */
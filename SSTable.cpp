@@ -0,0 +1,397 @@
+/**********************************
+ * FILE NAME: SSTable.cpp
+ *
+ * DESCRIPTION: Definition of the sorted string tables of LsmTable
+ **********************************/
+
+#include "SSTable.h"
+
+/*
+ * Bits of the bloom filter probed for a key with hash h
+ */
+static uint64_t bloomProbe(uint64_t h, int i, uint64_t bits) {
+	uint64_t step = (h >> 33 | h << 31) | 1;
+	return (h + i * step) % bits;
+}
+
+/**
+ * Constructor
+ */
+SSTable::SSTable(const string &path, uint64_t seq) {
+	this->path = path;
+	this->seq = seq;
+	this->base = NULL;
+	this->size = 0;
+	this->obsolete = false;
+	memset(&footer, 0, sizeof(footer));
+}
+
+/**
+ * Destructor
+ * Unmaps the file, and removes it if obsolete
+ */
+SSTable::~SSTable() {
+	if ( NULL != base ) {
+		munmap(base, size);
+	}
+	if ( obsolete ) {
+		unlink(path.c_str());
+	}
+}
+
+/**
+ * FUNCTION NAME: open
+ *
+ * DESCRIPTION: Maps the table at path
+ *
+ * RETURNS:
+ * The table, NULL if it is missing or damaged
+ */
+shared_ptr<SSTable> SSTable::open(const string &path, uint64_t seq) {
+	shared_ptr<SSTable> table(new SSTable(path, seq));
+
+	if ( !table->load() ) {
+		return shared_ptr<SSTable>();
+	}
+	return table;
+}
+
+/**
+ * FUNCTION NAME: hash
+ *
+ * DESCRIPTION: FNV-1a hash of key. It goes into the bloom filters on disk, so it
+ * 				must not change with the compiler or library.
+ */
+uint64_t SSTable::hash(string_view key) {
+	uint64_t h = 14695981039346656037ULL;
+
+	for ( size_t i = 0; i < key.size(); i++ ) {
+		h = (h ^ (unsigned char)key[i]) * 1099511628211ULL;
+	}
+	return h;
+}
+
+/**
+ * FUNCTION NAME: load
+ *
+ * DESCRIPTION: Maps the file, checks the footer and reads the block index
+ *
+ * RETURNS:
+ * false if the file cannot be used
+ */
+bool SSTable::load() {
+	struct stat st;
+	int fd = ::open(path.c_str(), O_RDONLY);
+	const char *p, *end;
+
+	if ( fd < 0 ) {
+		return false;
+	}
+	if ( fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(footer) ) {
+		close(fd);
+		return false;
+	}
+	size = st.st_size;
+	base = (char *) mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if ( MAP_FAILED == base ) {
+		base = NULL;
+		return false;
+	}
+
+	memcpy(&footer, base + size - sizeof(footer), sizeof(footer));
+	if ( SST_MAGIC != footer.magic || footer.indexOffset > footer.bloomOffset
+			|| footer.bloomOffset + footer.bloomBits / 8 > size - sizeof(footer) ) {
+		return false;
+	}
+
+	p = base + footer.indexOffset;
+	end = base + footer.bloomOffset;
+	while ( p + 8 <= end ) {
+		uint32_t keySize, offset;
+		SSTableBlock block;
+		memcpy(&keySize, p, 4);
+		memcpy(&offset, p + 4, 4);
+		if ( keySize > (size_t)(end - p - 8) || offset >= footer.indexOffset ) {
+			return false;
+		}
+		block.firstKey = string_view(p + 8, keySize);
+		block.offset = offset;
+		block.size = 0;
+		if ( !index.empty() ) {
+			index.back().size = offset - index.back().offset;
+		}
+		index.push_back(block);
+		p += 8 + keySize;
+	}
+	if ( !index.empty() ) {
+		index.back().size = footer.indexOffset - index.back().offset;
+		smallestKey = string(index.front().firstKey);
+		// The largest key is the last one of the last block
+		p = base + index.back().offset;
+		end = base + footer.indexOffset;
+		while ( p + 8 <= end ) {
+			uint32_t keySize, valueSize;
+			memcpy(&keySize, p, 4);
+			memcpy(&valueSize, p + 4, 4);
+			largestKey.assign(p + 8, keySize);
+			p += 8 + keySize + valueSize;
+		}
+	}
+	return true;
+}
+
+/**
+ * FUNCTION NAME: mayContain
+ *
+ * DESCRIPTION: Asks the bloom filter, false means key is surely not in the table
+ */
+bool SSTable::mayContain(string_view key) {
+	const unsigned char *bloom = (const unsigned char *)base + footer.bloomOffset;
+	uint64_t h = hash(key);
+
+	if ( 0 == footer.bloomBits ) {
+		return true;
+	}
+	for ( int i = 0; i < SST_BLOOM_PROBES; i++ ) {
+		uint64_t bit = bloomProbe(h, i, footer.bloomBits);
+		if ( 0 == (bloom[bit / 8] & (1 << (bit % 8))) ) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * FUNCTION NAME: get
+ *
+ * DESCRIPTION: Looks key up, copying its value into value. An empty value means
+ * 				the key was deleted, and older tables must not be asked.
+ *
+ * RETURNS:
+ * 1 if the table has an entry for key, 0 otherwise
+ */
+int SSTable::get(string_view key, string &value) {
+	vector<SSTableBlock>::iterator block;
+	const char *p, *end;
+
+	if ( index.empty() || key < smallestKey || key > largestKey || !mayContain(key) ) {
+		return 0;
+	}
+	// Last block whose first key is not past key
+	block = upper_bound(index.begin(), index.end(), key, [](string_view k, const SSTableBlock &b) {
+		return k < b.firstKey;
+	});
+	if ( block == index.begin() ) {
+		return 0;
+	}
+	block--;
+
+	p = base + block->offset;
+	end = p + block->size;
+	while ( p + 8 <= end ) {
+		uint32_t keySize, valueSize;
+		memcpy(&keySize, p, 4);
+		memcpy(&valueSize, p + 4, 4);
+		int cmp = string_view(p + 8, keySize).compare(key);
+		if ( 0 == cmp ) {
+			value.assign(p + 8 + keySize, valueSize);
+			return 1;
+		}
+		if ( cmp > 0 ) {
+			break;
+		}
+		p += 8 + keySize + valueSize;
+	}
+	return 0;
+}
+
+const string &SSTable::smallest() {
+	return smallestKey;
+}
+
+const string &SSTable::largest() {
+	return largestKey;
+}
+
+uint64_t SSTable::count() {
+	return footer.count;
+}
+
+size_t SSTable::bytes() {
+	return size;
+}
+
+/**
+ * FUNCTION NAME: markObsolete
+ *
+ * DESCRIPTION: The file goes away with the last reference to the table
+ */
+void SSTable::markObsolete() {
+	obsolete = true;
+}
+
+/**
+ * Constructor
+ * Starts at the first entry of table
+ */
+SSTable::Cursor::Cursor(SSTable *table) {
+	pos = table->base;
+	end = table->base + table->footer.indexOffset;
+	next();
+}
+
+bool SSTable::Cursor::valid() {
+	return current;
+}
+
+/**
+ * FUNCTION NAME: next
+ *
+ * DESCRIPTION: Moves to the next entry
+ */
+void SSTable::Cursor::next() {
+	uint32_t keySize, valueSize;
+
+	current = pos + 8 <= end;
+	if ( !current ) {
+		return;
+	}
+	memcpy(&keySize, pos, 4);
+	memcpy(&valueSize, pos + 4, 4);
+	key = string_view(pos + 8, keySize);
+	value = string_view(pos + 8 + keySize, valueSize);
+	pos += 8 + keySize + valueSize;
+}
+
+/**
+ * Constructor
+ * Creates the file at path, replacing any
+ */
+SSTableBuilder::SSTableBuilder(const string &path) {
+	this->path = path;
+	this->written = 0;
+	this->blockStart = 0;
+	this->count = 0;
+	fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	ok = fd >= 0;
+	if ( !ok ) {
+		perror(path.c_str());
+	}
+}
+
+/**
+ * Destructor
+ * A table that was not finished is removed
+ */
+SSTableBuilder::~SSTableBuilder() {
+	if ( fd >= 0 ) {
+		close(fd);
+		unlink(path.c_str());
+	}
+}
+
+/**
+ * FUNCTION NAME: spill
+ *
+ * DESCRIPTION: Writes the buffer out once it is large, or in any case if all
+ */
+void SSTableBuilder::spill(bool all) {
+	size_t done = 0;
+
+	if ( !ok || (!all && buffer.size() < (1 << 20)) ) {
+		return;
+	}
+	while ( done < buffer.size() ) {
+		ssize_t n = write(fd, buffer.data() + done, buffer.size() - done);
+		if ( n < 0 && errno == EINTR ) {
+			continue;
+		}
+		if ( n <= 0 ) {
+			perror(path.c_str());
+			ok = false;
+			return;
+		}
+		done += n;
+	}
+	written += buffer.size();
+	buffer.clear();
+}
+
+/**
+ * FUNCTION NAME: add
+ *
+ * DESCRIPTION: Adds the entry after the ones added so far, key must be larger than
+ * 				theirs
+ */
+void SSTableBuilder::add(string_view key, string_view value) {
+	uint64_t offset = written + buffer.size();
+	uint32_t keySize = key.size();
+	uint32_t valueSize = value.size();
+
+	if ( 0 == count || offset - blockStart >= SST_BLOCK_BYTES ) {
+		uint32_t blockOffset = offset;
+		indexData.append((const char *)&keySize, 4);
+		indexData.append((const char *)&blockOffset, 4);
+		indexData.append(key.data(), key.size());
+		blockStart = offset;
+	}
+	buffer.append((const char *)&keySize, 4);
+	buffer.append((const char *)&valueSize, 4);
+	buffer.append(key.data(), key.size());
+	buffer.append(value.data(), value.size());
+	hashes.push_back(SSTable::hash(key));
+	count++;
+	spill(false);
+}
+
+/**
+ * FUNCTION NAME: bytes
+ *
+ * DESCRIPTION: Size of the entries added so far
+ */
+uint64_t SSTableBuilder::bytes() {
+	return written + buffer.size();
+}
+
+uint64_t SSTableBuilder::entries() {
+	return count;
+}
+
+/**
+ * FUNCTION NAME: finish
+ *
+ * DESCRIPTION: Writes the index, bloom filter and footer and syncs the file
+ *
+ * RETURNS:
+ * true if the table is complete on disk
+ */
+bool SSTableBuilder::finish() {
+	SSTableFooter footer;
+	string bloom;
+
+	footer.indexOffset = bytes();
+	buffer += indexData;
+	footer.bloomOffset = footer.indexOffset + indexData.size();
+	footer.bloomBits = max((uint64_t)64, (count * SST_BLOOM_BITS + 7) / 8 * 8);
+	bloom.assign(footer.bloomBits / 8, 0);
+	for ( size_t i = 0; i < hashes.size(); i++ ) {
+		for ( int k = 0; k < SST_BLOOM_PROBES; k++ ) {
+			uint64_t bit = bloomProbe(hashes[i], k, footer.bloomBits);
+			bloom[bit / 8] |= 1 << (bit % 8);
+		}
+	}
+	buffer += bloom;
+	footer.count = count;
+	footer.magic = SST_MAGIC;
+	buffer.append((const char *)&footer, sizeof(footer));
+	spill(true);
+
+	ok = ok && fdatasync(fd) == 0;
+	close(fd);
+	fd = -1;
+	if ( !ok ) {
+		unlink(path.c_str());
+	}
+	return ok;
+}
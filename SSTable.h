@@ -0,0 +1,142 @@
+/**********************************
+ * FILE NAME: SSTable.h
+ *
+ * DESCRIPTION: Header file of the sorted string tables of LsmTable
+ **********************************/
+
+#ifndef SSTABLE_H_
+#define SSTABLE_H_
+
+#include "stdincludes.h"
+#include <memory>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/*
+ * Macros
+ */
+// Entries are indexed once per block of about this many bytes
+#define SST_BLOCK_BYTES 4096
+// Bloom filter bits per key, with SST_BLOOM_PROBES probes it lets about 1% of
+// the keys a table does not have through
+#define SST_BLOOM_BITS 10
+#define SST_BLOOM_PROBES 7
+// Last 8 bytes of every table
+#define SST_MAGIC 0x4c534d5353544231ULL
+
+/**
+ * STRUCT NAME: SSTableFooter
+ *
+ * DESCRIPTION: Where the parts of a table are, at its end
+ */
+typedef struct SSTableFooter {
+	uint64_t indexOffset;
+	uint64_t bloomOffset;
+	uint64_t bloomBits;
+	uint64_t count;
+	uint64_t magic;
+} SSTableFooter;
+
+/**
+ * STRUCT NAME: SSTableBlock
+ *
+ * DESCRIPTION: Entry of the block index, the first key of a block and its extent
+ * 				in the file
+ */
+typedef struct SSTableBlock {
+	string_view firstKey;
+	uint32_t offset;
+	uint32_t size;
+} SSTableBlock;
+
+/**
+ * CLASS NAME: SSTable
+ *
+ * DESCRIPTION: Immutable file of keys in order, read through mmap. It holds
+ * 				 - the entries, key size (4) | value size (4) | key | value,
+ * 				   where an empty value marks a deleted key
+ * 				 - the block index, key size (4) | offset (4) | key for the
+ * 				   first key of every block of SST_BLOCK_BYTES
+ * 				 - a bloom filter of the keys
+ * 				 - an SSTableFooter
+ * 				A lookup asks the bloom filter, then binary searches the index
+ * 				and scans one block, which touches one or two pages of the file.
+ * 				A table marked obsolete removes its file once the last user
+ * 				lets go of it.
+ */
+class SSTable {
+private:
+	string path;
+	char *base;
+	size_t size;
+	SSTableFooter footer;
+	vector<SSTableBlock> index;
+	string smallestKey;
+	string largestKey;
+	bool obsolete;
+
+	SSTable(const string &path, uint64_t seq);
+	bool load();
+	bool mayContain(string_view key);
+public:
+	uint64_t seq;
+
+	static shared_ptr<SSTable> open(const string &path, uint64_t seq);
+	static uint64_t hash(string_view key);
+	virtual ~SSTable();
+	int get(string_view key, string &value);
+	const string &smallest();
+	const string &largest();
+	uint64_t count();
+	size_t bytes();
+	void markObsolete();
+
+	/**
+	 * CLASS NAME: Cursor
+	 *
+	 * DESCRIPTION: Walks the entries in order
+	 */
+	class Cursor {
+	private:
+		const char *pos;
+		const char *end;
+		bool current;
+	public:
+		string_view key;
+		string_view value;
+
+		Cursor(SSTable *table);
+		bool valid();
+		void next();
+	};
+};
+
+/**
+ * CLASS NAME: SSTableBuilder
+ *
+ * DESCRIPTION: Writes a new SSTable from entries added in key order
+ */
+class SSTableBuilder {
+private:
+	string path;
+	int fd;
+	string buffer;
+	string indexData;
+	vector<uint64_t> hashes;
+	uint64_t written;
+	uint64_t blockStart;
+	uint64_t count;
+	bool ok;
+
+	void spill(bool all);
+public:
+	SSTableBuilder(const string &path);
+	virtual ~SSTableBuilder();
+	void add(string_view key, string_view value);
+	uint64_t bytes();
+	uint64_t entries();
+	bool finish();
+};
+
+#endif /* SSTABLE_H_ */
@@ -0,0 +1,335 @@
+/**********************************
+ * FILE NAME: ShmNet.cpp
+ *
+ * DESCRIPTION: Shared memory network classes definition
+ **********************************/
+
+#include "ShmNet.h"
+
+/**
+ * Constructor
+ * Maps the region created under name by createRegion
+ */
+ShmNet::ShmNet(Params *p, int self, const char *name): EmulNet(p) {
+	struct stat st;
+	int fd = shm_open(name, O_RDWR, 0);
+
+	this->self = self;
+	this->nodes = p->EN_GPSZ;
+	if ( fd < 0 || fstat(fd, &st) < 0 || (size_t)st.st_size != regionBytes(nodes) ) {
+		perror("ShmNet::ShmNet");
+		exit(1);
+	}
+	regionSize = st.st_size;
+	region = (char *) mmap(NULL, regionSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if ( MAP_FAILED == region ) {
+		perror("ShmNet::ShmNet");
+		exit(1);
+	}
+}
+
+/**
+ * Destructor
+ */
+ShmNet::~ShmNet() {
+	munmap(region, regionSize);
+}
+
+/**
+ * FUNCTION NAME: regionBytes
+ *
+ * DESCRIPTION: Size of the region for nodes nodes
+ */
+size_t ShmNet::regionBytes(int nodes) {
+	return (size_t)nodes * nodes * sizeof(ShmRing);
+}
+
+/**
+ * FUNCTION NAME: regionName
+ *
+ * DESCRIPTION: Name of the region of network net of the launcher with pid owner
+ */
+void ShmNet::regionName(char *name, int owner, int net) {
+	sprintf(name, "/kvstore.%d.%d", owner, net);
+}
+
+/**
+ * FUNCTION NAME: createRegion
+ *
+ * DESCRIPTION: Creates the zero filled region of a network of nodes nodes.
+ * 				The name can be unlinked once every node has mapped it.
+ *
+ * RETURNS:
+ * SUCCESS or FAILURE
+ */
+int ShmNet::createRegion(const char *name, int nodes) {
+	int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+
+	if ( fd < 0 || ftruncate(fd, regionBytes(nodes)) < 0 ) {
+		perror(name);
+		if ( fd >= 0 ) {
+			close(fd);
+			shm_unlink(name);
+		}
+		return FAILURE;
+	}
+	close(fd);
+	return SUCCESS;
+}
+
+/**
+ * FUNCTION NAME: ring
+ *
+ * DESCRIPTION: Ring carrying frames from node from to node to
+ */
+ShmRing *ShmNet::ring(int from, int to) {
+	return (ShmRing *)region + ((size_t)(from - 1) * nodes + (to - 1));
+}
+
+/**
+ * FUNCTION NAME: reserve
+ *
+ * DESCRIPTION: Finds room for a frame of class cls and bytes bytes in the ring
+ * 				from self to dst. The frame is published by storing end into tail.
+ *
+ * RETURNS:
+ * Where to write the frame, NULL if the ring has no room for it
+ */
+en_msg *ShmNet::reserve(int dst, int cls, int bytes, unsigned long *end) {
+	ShmRing *r = ring(self, dst);
+	unsigned long need = (bytes + SHM_ALIGN - 1) & ~(unsigned long)(SHM_ALIGN - 1);
+	unsigned long tail = r->tail.load(std::memory_order_relaxed);
+	unsigned long head = r->head.load(std::memory_order_acquire);
+	unsigned long pos = tail & (SHM_RING_SIZE - 1);
+	unsigned long skip = 0;
+
+	if ( pos + need > SHM_RING_SIZE ) {
+		// Frames are never split, the rest of the ring is skipped
+		skip = SHM_RING_SIZE - pos;
+	}
+	if ( tail + skip + need - head > SHM_RING_SIZE - (unsigned long)cls * SHM_CLASS_RESERVE ) {
+		return NULL;
+	}
+	if ( skip ) {
+		((en_msg *)(r->data + pos))->size = SHM_WRAP;
+		pos = 0;
+	}
+	*end = tail + skip + need;
+	return (en_msg *)(r->data + pos);
+}
+
+/**
+ * FUNCTION NAME: drain
+ *
+ * DESCRIPTION: Moves the frames of class cls pending towards dst into the ring
+ * 				while it has room
+ *
+ * RETURNS:
+ * true if none is left pending
+ */
+bool ShmNet::drain(int dst, int cls) {
+	deque<MsgBuffer *> *queue;
+	unsigned long end;
+
+	if ( dst * NUM_CLASSES + cls >= (int)pending.size() ) {
+		return true;
+	}
+	queue = &pending[dst * NUM_CLASSES + cls];
+	while ( !queue->empty() ) {
+		MsgBuffer *frame = queue->front();
+		en_msg *em = reserve(dst, cls, frame->size, &end);
+		if ( NULL == em ) {
+			break;
+		}
+		// en_msg holds Addresses, the frame is copied as bytes
+		memcpy((void *)em, frame->data(), frame->size);
+		ring(self, dst)->tail.store(end, std::memory_order_release);
+		frame->release();
+		queue->pop_front();
+	}
+	return queue->empty();
+}
+
+/**
+ * FUNCTION NAME: ENsend
+ *
+ * DESCRIPTION: Writes the frame straight into the ring from myaddr to toaddr and
+ * 				publishes it by moving tail. The send would block while the
+ * 				ring has no room for a frame of class cls, or while the
+ * 				fragments of an earlier message of the class are still pending.
+ * 				A large message is taken whole, its fragments go in as the
+ * 				receiver makes room.
+ *
+ * RETURNS:
+ * size, EN_DROPPED, EN_WOULDBLOCK or EN_TOOBIG
+ */
+int ShmNet::ENsend(Address *myaddr, Address *toaddr, char *data, int size, int cls) {
+	int sendmsg = rand() % 100;
+	int src = *(int *)(myaddr->addr);
+	int dst = *(int *)(toaddr->addr);
+	unsigned long end = 0;
+	en_msg *em = NULL;
+
+	if ( size < 0 || size > ENMAXMSG ) {
+		return EN_TOOBIG;
+	}
+	if ( src != self || dst <= 0 || dst > nodes || cls < 0 || cls >= NUM_CLASSES ) {
+		return EN_DROPPED;
+	}
+
+	if ( !drain(dst, cls) || (fragments(size) == 1 && NULL == (em = reserve(dst, cls, sizeof(en_msg) + recordBytes(size), &end))) ) {
+		countBlocked(src, cls);
+		return EN_WOULDBLOCK;
+	}
+	if ( par->dropmsg && sendmsg < (int) (par->MSG_DROP_PROB * 100) ) {
+		return EN_DROPPED;
+	}
+
+	if ( NULL != em ) {
+		en_rec *rec = (en_rec *)(em + 1);
+		em->size = recordBytes(size);
+		memcpy(&(em->from.addr), &(myaddr->addr), sizeof(em->from.addr));
+		memcpy(&(em->to.addr), &(toaddr->addr), sizeof(em->to.addr));
+		em->cls = cls;
+		em->pad = 0;
+		rec->size = size;
+		rec->flags = 0;
+		memcpy(rec + 1, data, size);
+		ring(src, dst)->tail.store(end, std::memory_order_release);
+	}
+	else {
+		packMessage(myaddr, toaddr, cls, data, size);
+		sealFrame(openFrames[dst * NUM_CLASSES + cls]);
+		openFrames[dst * NUM_CLASSES + cls] = NULL;
+		drain(dst, cls);
+	}
+
+	countMsg(src, true, cls);
+
+	return size;
+}
+
+/**
+ * FUNCTION NAME: ENmulticast
+ *
+ * DESCRIPTION: A payload cannot be shared with other processes, every destination
+ * 				gets a copy of its own
+ *
+ * RETURNS:
+ * Number of destinations sent to, the result of each is in results
+ */
+int ShmNet::ENmulticast(Address *myaddr, Address *to, int count, char *data, int size, char *tags, int tagSize, int *results, int cls) {
+	return multicastCopies(myaddr, to, count, data, size, tags, tagSize, results, cls);
+}
+
+/**
+ * FUNCTION NAME: ENrecv
+ *
+ * DESCRIPTION: Moves pending fragments on, then hands the messages of the classes
+ * 				in the classes mask to enq, each in a buffer of its own, which
+ * 				enq owns from then on. Frames kept from earlier calls go first,
+ * 				most urgent class first, then the rings into myaddr are
+ * 				visited. The ring space is given back as soon as the frame is
+ * 				copied out.
+ *
+ * RETURN:
+ * 0
+ */
+int ShmNet::ENrecv(Address *myaddr, int (* enq)(void *, char *, int, MsgBuffer *, char *, int), struct timeval *t, int times, void *queue, int classes) {
+	int dst = *(int *)(myaddr->addr);
+
+	if ( dst != self ) {
+		return 0;
+	}
+
+	for ( unsigned int i = 0; i < pending.size(); i++ ) {
+		drain(i / NUM_CLASSES, i % NUM_CLASSES);
+	}
+	expireFragments();
+	for ( int cls = 0; cls < NUM_CLASSES; cls++ ) {
+		RingQueue<MsgBuffer *> *kept = emulnet.getInbox(self, cls);
+		while ( (classes & EN_CLASS_MASK(cls)) && !kept->empty() ) {
+			unpack(kept->front(), enq, queue);
+			kept->pop_front();
+		}
+	}
+	for ( int src = 1; src <= nodes; src++ ) {
+		ShmRing *r = ring(src, dst);
+		unsigned long head = r->head.load(std::memory_order_relaxed);
+		unsigned long tail = r->tail.load(std::memory_order_acquire);
+
+		while ( head != tail ) {
+			unsigned long pos = head & (SHM_RING_SIZE - 1);
+			en_msg *emsg = (en_msg *)(r->data + pos);
+
+			if ( SHM_WRAP == emsg->size ) {
+				head += SHM_RING_SIZE - pos;
+				continue;
+			}
+			int bytes = sizeof(en_msg) + emsg->size;
+			MsgBuffer *frame = pool.alloc(dst, bytes);
+			memcpy(frame->data(), emsg, bytes);
+			head += (bytes + SHM_ALIGN - 1) & ~(SHM_ALIGN - 1);
+			r->head.store(head, std::memory_order_release);
+
+			int cls = ((en_msg *)frame->data())->cls;
+			if ( cls < 0 || cls >= NUM_CLASSES ) {
+				frame->release();
+			}
+			else if ( classes & EN_CLASS_MASK(cls) ) {
+				unpack(frame, enq, queue);
+			}
+			else {
+				emulnet.getInbox(self, cls)->push_back(frame);
+			}
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * FUNCTION NAME: ENcleanup
+ *
+ * DESCRIPTION: Drops the fragments that never made it into a ring and writes the
+ * 				counters like EmulNet
+ */
+int ShmNet::ENcleanup() {
+	for ( unsigned int i = 0; i < pending.size(); i++ ) {
+		while ( !pending[i].empty() ) {
+			pending[i].front()->release();
+			pending[i].pop_front();
+		}
+	}
+	pending.clear();
+	openFrames.clear();
+	return EmulNet::ENcleanup();
+}
+
+/**
+ * FUNCTION NAME: openFrame
+ *
+ * DESCRIPTION: Fragments are cut per destination and class, self is the only
+ * 				source
+ */
+MsgBuffer *&ShmNet::openFrame(int src, int dst, int cls) {
+	if ( (dst + 1) * NUM_CLASSES > (int)openFrames.size() ) {
+		openFrames.resize((dst + 1) * NUM_CLASSES, NULL);
+		pending.resize((dst + 1) * NUM_CLASSES);
+	}
+	return openFrames[dst * NUM_CLASSES + cls];
+}
+
+/**
+ * FUNCTION NAME: sealFrame
+ *
+ * DESCRIPTION: Queues a frame behind the others of its class pending towards its
+ * 				destination
+ */
+void ShmNet::sealFrame(MsgBuffer *frame) {
+	en_msg *em = (en_msg *)frame->data();
+
+	pending[*(int *)(em->to.addr) * NUM_CLASSES + em->cls].push_back(frame);
+	countFrame(self, em->cls, frame->size, frame->size);
+}
@@ -0,0 +1,96 @@
+/**********************************
+ * FILE NAME: ShmNet.h
+ *
+ * DESCRIPTION: Shared memory network for nodes running as separate processes
+ **********************************/
+
+#ifndef _SHMNET_H_
+#define _SHMNET_H_
+
+#include "stdincludes.h"
+#include "EmulNet.h"
+#include <atomic>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/*
+ * Macros
+ */
+// Bytes of frames a ring holds, a power of two
+#define SHM_RING_SIZE (1 << 16)
+// Frames in a ring start on this boundary
+#define SHM_ALIGN 8
+#define SHM_CACHELINE 64
+// Marks the end of the ring as unused, the next frame is at its start
+#define SHM_WRAP -1
+// Room for the name of a region
+#define SHM_NAME_LEN 64
+// Ring bytes each traffic class leaves free for the more urgent ones, so that
+// bulk traffic filling a ring cannot block control messages
+#define SHM_CLASS_RESERVE (SHM_RING_SIZE / 8)
+
+/**
+ * STRUCT NAME: ShmRing
+ *
+ * DESCRIPTION: Single producer single consumer ring of en_msg frames. Only the
+ * 				sender moves tail and only the receiver moves head, both count
+ * 				bytes since the start and are never wrapped. head and tail are
+ * 				kept on separate cache lines.
+ */
+struct ShmRing {
+	std::atomic<unsigned long> head;
+	char headPad[SHM_CACHELINE - sizeof(std::atomic<unsigned long>)];
+	std::atomic<unsigned long> tail;
+	char tailPad[SHM_CACHELINE - sizeof(std::atomic<unsigned long>)];
+	char data[SHM_RING_SIZE];
+};
+
+/**
+ * CLASS NAME: ShmNet
+ *
+ * DESCRIPTION: Carries en_msg frames through a shared memory region holding one
+ * 				ShmRing per ordered pair of nodes. The region is made by
+ * 				createRegion before the node processes start and every process
+ * 				maps it. Only pages of rings in use are ever touched, so the
+ * 				memory used grows with the pairs that talk, not with the
+ * 				square of the nodes. A full ring is the credit window of its
+ * 				pair, sends to it would block until the receiver drains it.
+ * 				The traffic classes share the ring, but each class only fills
+ * 				it up to SHM_CLASS_RESERVE bytes per class short of the top.
+ * 				Every frame holds one record. The fragments of a large message
+ * 				wait in pending and go into the ring as it drains. Frames of a
+ * 				class the node is not receiving are kept in its inbox until it
+ * 				does.
+ */
+class ShmNet : public EmulNet {
+private:
+	int self;
+	int nodes;
+	char *region;
+	size_t regionSize;
+	// Frame being cut from a large message, by (destination, class)
+	vector<MsgBuffer *> openFrames;
+	// Frames waiting for room in the ring, by (destination, class)
+	vector< deque<MsgBuffer *> > pending;
+
+	ShmRing *ring(int from, int to);
+	en_msg *reserve(int dst, int cls, int bytes, unsigned long *end);
+	bool drain(int dst, int cls);
+protected:
+	MsgBuffer *&openFrame(int src, int dst, int cls);
+	void sealFrame(MsgBuffer *frame);
+public:
+	ShmNet(Params *p, int self, const char *name);
+	virtual ~ShmNet();
+	static size_t regionBytes(int nodes);
+	static void regionName(char *name, int owner, int net);
+	static int createRegion(const char *name, int nodes);
+	using EmulNet::ENsend;
+	using EmulNet::ENrecv;
+	int ENsend(Address *myaddr, Address *toaddr, char *data, int size, int cls);
+	int ENmulticast(Address *myaddr, Address *to, int count, char *data, int size, char *tags, int tagSize, int *results, int cls);
+	int ENrecv(Address *myaddr, int (* enq)(void *, char *, int, MsgBuffer *, char *, int), struct timeval *t, int times, void *queue, int classes);
+	int ENcleanup();
+};
+
+#endif /* _SHMNET_H_ */
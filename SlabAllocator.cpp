@@ -0,0 +1,129 @@
+/**********************************
+ * FILE NAME: SlabAllocator.cpp
+ *
+ * DESCRIPTION: Definition of the size class slab allocator for message frames
+ **********************************/
+
+#include "SlabAllocator.h"
+
+/**
+ * Constructor
+ */
+SlabAllocator::SlabAllocator() {
+	memset(&stats, 0, sizeof(stats));
+}
+
+/**
+ * Destructor
+ */
+SlabAllocator::~SlabAllocator() {
+	for ( unsigned int i = 0; i < slabs.size(); i++ ) {
+		free(slabs[i]);
+	}
+}
+
+/**
+ * FUNCTION NAME: sizeClass
+ *
+ * DESCRIPTION: Returns the index of the smallest size class holding size bytes,
+ * 				or -1 if size is above the largest class
+ */
+int SlabAllocator::sizeClass(int size) {
+	int cls = 0;
+	int cap = MSGBUF_MIN_CLASS;
+	while ( cap < size ) {
+		cap <<= 1;
+		cls++;
+	}
+	return (cls < MSGBUF_NUM_CLASSES) ? cls : -1;
+}
+
+/**
+ * FUNCTION NAME: freeList
+ *
+ * DESCRIPTION: Returns the free list of node for size class cls
+ */
+vector<MsgBuffer *> &SlabAllocator::freeList(int node, int cls) {
+	if ( node >= (int)freeLists.size() ) {
+		freeLists.resize(node + 1);
+	}
+	vector< vector<MsgBuffer *> > &lists = freeLists[node];
+	if ( lists.empty() ) {
+		lists.resize(MSGBUF_NUM_CLASSES);
+	}
+	return lists[cls];
+}
+
+/**
+ * FUNCTION NAME: refill
+ *
+ * DESCRIPTION: Carves a new slab into buffers of class cls for node
+ */
+void SlabAllocator::refill(int node, int cls) {
+	int capacity = MSGBUF_MIN_CLASS << cls;
+	int stride = sizeof(MsgBuffer) + capacity;
+	int count = max(1, SLAB_SIZE / stride);
+	char *slab = (char *) malloc((size_t)count * stride);
+	vector<MsgBuffer *> &list = freeList(node, cls);
+
+	slabs.push_back(slab);
+	stats.refills++;
+	for ( int i = count - 1; i >= 0; i-- ) {
+		MsgBuffer *buf = (MsgBuffer *)(slab + (size_t)i * stride);
+		buf->capacity = capacity;
+		buf->owner = node;
+		buf->pool = this;
+		list.push_back(buf);
+	}
+}
+
+/**
+ * FUNCTION NAME: alloc
+ *
+ * DESCRIPTION: Returns a buffer of at least size bytes with a single reference,
+ * 				taken from the free lists of node
+ */
+MsgBuffer *SlabAllocator::alloc(int node, int size) {
+	MsgBuffer *buf;
+	int cls = sizeClass(size);
+
+	stats.allocs++;
+	if ( cls < 0 || node < 0 ) {
+		stats.large++;
+		buf = MsgBuffer::alloc(size);
+		return buf;
+	}
+
+	vector<MsgBuffer *> &list = freeList(node, cls);
+	if ( list.empty() ) {
+		refill(node, cls);
+	}
+	else {
+		stats.hits++;
+	}
+	buf = list.back();
+	list.pop_back();
+
+	buf->refcnt = 1;
+	buf->size = size;
+	return buf;
+}
+
+/**
+ * FUNCTION NAME: release
+ *
+ * DESCRIPTION: Called by MsgBuffer::release once the last reference is gone
+ */
+void SlabAllocator::release(MsgBuffer *buf) {
+	stats.frees++;
+	freeList(buf->owner, sizeClass(buf->capacity)).push_back(buf);
+}
+
+/**
+ * FUNCTION NAME: getStats
+ *
+ * DESCRIPTION: Returns the allocation counters
+ */
+SlabStats SlabAllocator::getStats() {
+	return stats;
+}
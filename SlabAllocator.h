@@ -0,0 +1,63 @@
+/**********************************
+ * FILE NAME: SlabAllocator.h
+ *
+ * DESCRIPTION: Header file of the size class slab allocator for message frames
+ **********************************/
+
+#ifndef SLABALLOCATOR_H_
+#define SLABALLOCATOR_H_
+
+#include "stdincludes.h"
+#include "MsgBuffer.h"
+
+/*
+ * Macros
+ */
+// size of one slab carved into buffers of a single size class
+#define SLAB_SIZE 65536
+
+/**
+ * STRUCT NAME: SlabStats
+ *
+ * DESCRIPTION: Allocation counters of a SlabAllocator
+ */
+typedef struct SlabStats {
+	// buffers handed out
+	long allocs;
+	// allocations served from a free list
+	long hits;
+	// slabs carved because a free list ran dry
+	long refills;
+	// buffers returned to a free list
+	long frees;
+	// allocations above the largest size class, served by malloc
+	long large;
+} SlabStats;
+
+/**
+ * CLASS NAME: SlabAllocator
+ *
+ * DESCRIPTION: Hands out MsgBuffers from slabs of SLAB_SIZE bytes.
+ * 				Every node has its own free list per size class. A buffer goes
+ * 				back to the free list of the node that allocated it.
+ */
+class SlabAllocator {
+private:
+	// freeLists[node][cls]
+	vector< vector< vector<MsgBuffer *> > > freeLists;
+	// Slabs to give back on destruction
+	vector<char *> slabs;
+	SlabStats stats;
+
+	void refill(int node, int cls);
+	vector<MsgBuffer *> &freeList(int node, int cls);
+public:
+	SlabAllocator();
+	virtual ~SlabAllocator();
+	MsgBuffer *alloc(int node, int size);
+	void release(MsgBuffer *buf);
+	SlabStats getStats();
+	static int sizeClass(int size);
+};
+
+#endif /* SLABALLOCATOR_H_ */
@@ -0,0 +1,338 @@
+/**********************************
+ * FILE NAME: SockNet.cpp
+ *
+ * DESCRIPTION: Loopback UDP network classes definition
+ **********************************/
+
+#include "SockNet.h"
+
+/**
+ * Constructor
+ */
+SockNet::SockNet(Params *p, int self, int basePort): EmulNet(p) {
+	this->self = self;
+	this->basePort = basePort;
+	sock = -1;
+	epfd = epoll_create1(0);
+	for ( int i = 0; i < SOCK_BATCH; i++ ) {
+		inFrames[i] = NULL;
+	}
+}
+
+/**
+ * Destructor
+ */
+SockNet::~SockNet() {
+	if ( sock >= 0 ) {
+		close(sock);
+	}
+	close(epfd);
+}
+
+/**
+ * FUNCTION NAME: ENinit
+ *
+ * DESCRIPTION: Gives out node ids in the same order as EmulNet, so every process
+ * 				agrees on them. The socket is only opened for self.
+ */
+void *SockNet::ENinit(Address *myaddr, short port) {
+	int id = emulnet.nextid++;
+	int rcvbuf = 1 << 22;
+	struct sockaddr_in addr;
+	struct epoll_event ev;
+
+	*(int *)(myaddr->addr) = id;
+	*(short *)(&myaddr->addr[4]) = 0;
+	if ( id != self ) {
+		return myaddr;
+	}
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	addr.sin_port = htons(basePort + id);
+
+	sock = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+	if ( sock < 0 || bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0 ) {
+		perror("SockNet::ENinit");
+		exit(1);
+	}
+	// Best effort, the kernel caps it at net.core.rmem_max
+	setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN;
+	ev.data.fd = sock;
+	epoll_ctl(epfd, EPOLL_CTL_ADD, sock, &ev);
+
+	return myaddr;
+}
+
+/**
+ * FUNCTION NAME: ENsend
+ *
+ * DESCRIPTION: Adds the message to the frame of class cls open towards toaddr.
+ * 				A full frame is queued for the next batch, which leaves when
+ * 				SOCK_BATCH frames of the class are waiting or on the next ENrecv
+ * 				of the sender. Large messages are cut into fragments like in
+ * 				EmulNet. Sends of a class block while SOCK_BACKLOG of its frames
+ * 				are stuck behind a full socket.
+ * 				A datagram lost on the way loses its whole message, whose
+ * 				other fragments expire at the receiver.
+ *
+ * RETURNS:
+ * size, EN_DROPPED, EN_WOULDBLOCK or EN_TOOBIG
+ */
+int SockNet::ENsend(Address *myaddr, Address *toaddr, char *data, int size, int cls) {
+	int sendmsg = rand() % 100;
+	int src = *(int *)(myaddr->addr);
+	int dst = *(int *)(toaddr->addr);
+
+	if ( size < 0 || size > ENMAXMSG ) {
+		return EN_TOOBIG;
+	}
+	if ( src != self || dst <= 0 || dst >= emulnet.nextid || cls < 0 || cls >= NUM_CLASSES ) {
+		return EN_DROPPED;
+	}
+	if ( egressWaiting(self, cls) >= SOCK_BACKLOG ) {
+		flush();
+		if ( egressWaiting(self, cls) >= SOCK_BACKLOG ) {
+			countBlocked(src, cls);
+			return EN_WOULDBLOCK;
+		}
+	}
+	if ( par->dropmsg && sendmsg < (int) (par->MSG_DROP_PROB * 100) ) {
+		return EN_DROPPED;
+	}
+
+	packMessage(myaddr, toaddr, cls, data, size);
+
+	countMsg(src, true, cls);
+
+	if ( egressWaiting(self, cls) >= SOCK_BATCH ) {
+		flush();
+	}
+
+	return size;
+}
+
+/**
+ * FUNCTION NAME: ENmulticast
+ *
+ * DESCRIPTION: A payload cannot be shared with other processes, every destination
+ * 				gets a copy of its own
+ *
+ * RETURNS:
+ * Number of destinations sent to, the result of each is in results
+ */
+int SockNet::ENmulticast(Address *myaddr, Address *to, int count, char *data, int size, char *tags, int tagSize, int *results, int cls) {
+	return multicastCopies(myaddr, to, count, data, size, tags, tagSize, results, cls);
+}
+
+/**
+ * FUNCTION NAME: ENrecv
+ *
+ * DESCRIPTION: Sends what is queued, then hands the messages of the classes in
+ * 				the classes mask to enq, which owns the frame from then on.
+ * 				Frames kept from earlier calls go first, most urgent class
+ * 				first, then every datagram waiting on the socket of myaddr.
+ *
+ * RETURN:
+ * 0
+ */
+int SockNet::ENrecv(Address *myaddr, int (* enq)(void *, char *, int, MsgBuffer *, char *, int), struct timeval *t, int times, void *queue, int classes) {
+	struct epoll_event ev;
+
+	if ( *(int *)(myaddr->addr) != self || sock < 0 ) {
+		return 0;
+	}
+
+	flush();
+	expireFragments();
+	for ( int cls = 0; cls < NUM_CLASSES; cls++ ) {
+		RingQueue<MsgBuffer *> *kept = emulnet.getInbox(self, cls);
+		while ( (classes & EN_CLASS_MASK(cls)) && !kept->empty() ) {
+			unpack(kept->front(), enq, queue);
+			kept->pop_front();
+		}
+	}
+	if ( epoll_wait(epfd, &ev, 1, 0) > 0 ) {
+		while ( recvBatch(enq, queue, classes) == SOCK_BATCH ) {
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * FUNCTION NAME: ENcleanup
+ *
+ * DESCRIPTION: Sends what is queued, drops the receive frames and writes the
+ * 				counters like EmulNet
+ */
+int SockNet::ENcleanup() {
+	flush();
+	outBatches.clear();
+	for ( int i = 0; i < SOCK_BATCH; i++ ) {
+		if ( NULL != inFrames[i] ) {
+			inFrames[i]->release();
+			inFrames[i] = NULL;
+		}
+	}
+	return EmulNet::ENcleanup();
+}
+
+/**
+ * FUNCTION NAME: flush
+ *
+ * DESCRIPTION: Queues the open frames and sends the egress queues with as few
+ * 				sendmmsg calls as possible, taking the frames in the order the
+ * 				scheduler of EmulNet picks them. Frames the socket has no room
+ * 				for go back to their queues, frames the kernel refuses are
+ * 				dropped like a lost message.
+ *
+ * RETURNS:
+ * Number of frames sent
+ */
+int SockNet::flush() {
+	struct mmsghdr msgs[SOCK_BATCH];
+	struct iovec iov[SOCK_BATCH];
+	struct sockaddr_in addrs[SOCK_BATCH];
+	en_egress batch[SOCK_BATCH];
+	int sent = 0;
+	int n;
+
+	for ( unsigned int i = 0; i < outBatches.size(); i++ ) {
+		if ( NULL != outBatches[i] ) {
+			sealFrame(outBatches[i]);
+			outBatches[i] = NULL;
+		}
+	}
+
+	for ( ;; ) {
+		for ( n = 0; n < SOCK_BATCH && nextEgress(self, &batch[n]); n++ ) {
+		}
+		if ( 0 == n ) {
+			break;
+		}
+
+		memset(msgs, 0, n * sizeof(struct mmsghdr));
+		for ( int i = 0; i < n; i++ ) {
+			MsgBuffer *frame = batch[i].frame;
+			en_msg *em = (en_msg *)frame->data();
+
+			memset(&addrs[i], 0, sizeof(addrs[i]));
+			addrs[i].sin_family = AF_INET;
+			addrs[i].sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+			addrs[i].sin_port = htons(basePort + *(int *)(em->to.addr));
+			iov[i].iov_base = frame->data();
+			iov[i].iov_len = frame->size;
+			msgs[i].msg_hdr.msg_name = &addrs[i];
+			msgs[i].msg_hdr.msg_namelen = sizeof(addrs[i]);
+			msgs[i].msg_hdr.msg_iov = &iov[i];
+			msgs[i].msg_hdr.msg_iovlen = 1;
+		}
+
+		int r = sendmmsg(sock, msgs, n, 0);
+		bool full = false;
+		if ( r < 0 ) {
+			full = errno == EAGAIN || errno == EWOULDBLOCK;
+			// Otherwise the first frame of the batch was refused, skip it
+			r = full ? 0 : 1;
+		}
+		else {
+			sent += r;
+		}
+		for ( int i = 0; i < r; i++ ) {
+			batch[i].frame->release();
+		}
+		for ( int i = n - 1; i >= r; i-- ) {
+			requeueEgress(self, batch[i]);
+		}
+		if ( full ) {
+			break;
+		}
+	}
+
+	return sent;
+}
+
+/**
+ * FUNCTION NAME: recvBatch
+ *
+ * DESCRIPTION: Reads up to SOCK_BATCH datagrams with one recvmmsg call straight
+ * 				into frames and passes the messages of the well formed ones to
+ * 				enq. Frames of a class not in the classes mask are kept in the
+ * 				inbox of the class.
+ *
+ * RETURNS:
+ * Number of datagrams read
+ */
+int SockNet::recvBatch(int (* enq)(void *, char *, int, MsgBuffer *, char *, int), void *queue, int classes) {
+	struct mmsghdr msgs[SOCK_BATCH];
+	struct iovec iov[SOCK_BATCH];
+	int frameSize = maxFrameBytes();
+	int i, n;
+
+	memset(msgs, 0, sizeof(msgs));
+	for ( i = 0; i < SOCK_BATCH; i++ ) {
+		if ( NULL == inFrames[i] ) {
+			inFrames[i] = pool.alloc(self, frameSize);
+		}
+		iov[i].iov_base = inFrames[i]->data();
+		iov[i].iov_len = frameSize;
+		msgs[i].msg_hdr.msg_iov = &iov[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+	}
+
+	n = recvmmsg(sock, msgs, SOCK_BATCH, MSG_DONTWAIT, NULL);
+	for ( i = 0; i < n; i++ ) {
+		MsgBuffer *frame = inFrames[i];
+		en_msg *emsg = (en_msg *)frame->data();
+		int len = msgs[i].msg_len;
+
+		if ( len < (int)sizeof(en_msg) || emsg->size != len - (int)sizeof(en_msg) || emsg->cls < 0 || emsg->cls >= NUM_CLASSES ) {
+			// Runt, truncated or unknown datagram, the frame is reused
+			continue;
+		}
+		inFrames[i] = NULL;
+		frame->size = len;
+
+		if ( classes & EN_CLASS_MASK(emsg->cls) ) {
+			unpack(frame, enq, queue);
+		}
+		else {
+			emulnet.getInbox(self, emsg->cls)->push_back(frame);
+		}
+	}
+
+	return n;
+}
+
+/**
+ * FUNCTION NAME: openFrame
+ *
+ * DESCRIPTION: Frames are filled per destination and class, self is the only
+ * 				source
+ */
+MsgBuffer *&SockNet::openFrame(int src, int dst, int cls) {
+	if ( (dst + 1) * NUM_CLASSES > (int)outBatches.size() ) {
+		outBatches.resize((dst + 1) * NUM_CLASSES, NULL);
+	}
+	return outBatches[dst * NUM_CLASSES + cls];
+}
+
+/**
+ * FUNCTION NAME: sealFrame
+ *
+ * DESCRIPTION: Queues a full frame for the next batch, compressed if Params say so
+ */
+void SockNet::sealFrame(MsgBuffer *frame) {
+	int raw = frame->size;
+	int cls;
+
+	frame = compressFrame(frame);
+	cls = ((en_msg *)frame->data())->cls;
+	queueEgress(self, cls, frame, frame->size, par->getcurrtime());
+	countFrame(self, cls, frame->size, raw);
+}
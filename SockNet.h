@@ -0,0 +1,72 @@
+/**********************************
+ * FILE NAME: SockNet.h
+ *
+ * DESCRIPTION: Loopback UDP network for nodes running as separate processes
+ **********************************/
+
+#ifndef _SOCKNET_H_
+#define _SOCKNET_H_
+
+#include "stdincludes.h"
+#include "EmulNet.h"
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+/*
+ * Macros
+ */
+// Datagrams moved per sendmmsg/recvmmsg call
+#define SOCK_BATCH 64
+// Node id is added to this to get the UDP port of a node
+#define SOCK_BASE_PORT 20000
+// Frames of a class the socket has refused with EAGAIN before sends of the
+// class block
+#define SOCK_BACKLOG (4 * SOCK_BATCH)
+
+/**
+ * CLASS NAME: SockNet
+ *
+ * DESCRIPTION: Carries en_msg frames as UDP datagrams on 127.0.0.1. Every node has
+ * 				the same id as in the emulated network and listens on
+ * 				basePort + id, but only the node hosted by this process
+ * 				(self) gets a socket, shared by every traffic class. Messages
+ * 				to a node are packed in one frame per class until the node
+ * 				receives, frames go out in batches when SOCK_BATCH of a class
+ * 				are waiting or the node receives. Frames wait for the socket
+ * 				in the egress queues of EmulNet, which share it between the
+ * 				classes by weight. Frames of a class the node is not receiving
+ * 				are kept in its inbox until it does.
+ * 				Link delay and bandwidth are left to the kernel.
+ */
+class SockNet : public EmulNet {
+private:
+	int self;
+	int basePort;
+	int sock;
+	int epfd;
+	// Frames being filled, by (destination, class)
+	vector<MsgBuffer *> outBatches;
+	// Frames handed to recvmmsg, replaced as they are passed up
+	MsgBuffer *inFrames[SOCK_BATCH];
+
+	int flush();
+	int recvBatch(int (* enq)(void *, char *, int, MsgBuffer *, char *, int), void *queue, int classes);
+protected:
+	MsgBuffer *&openFrame(int src, int dst, int cls);
+	void sealFrame(MsgBuffer *frame);
+public:
+	SockNet(Params *p, int self, int basePort);
+	virtual ~SockNet();
+	void *ENinit(Address *myaddr, short port);
+	using EmulNet::ENsend;
+	using EmulNet::ENrecv;
+	int ENsend(Address *myaddr, Address *toaddr, char *data, int size, int cls);
+	int ENmulticast(Address *myaddr, Address *to, int count, char *data, int size, char *tags, int tagSize, int *results, int cls);
+	int ENrecv(Address *myaddr, int (* enq)(void *, char *, int, MsgBuffer *, char *, int), struct timeval *t, int times, void *queue, int classes);
+	int ENcleanup();
+};
+
+#endif /* _SOCKNET_H_ */
@@ -0,0 +1,96 @@
+/**********************************
+ * FILE NAME: StorageEngine.cpp
+ *
+ * DESCRIPTION: Definition of the parts StorageEngine tables share
+ **********************************/
+
+#include "StorageEngine.h"
+
+/**
+ * FUNCTION NAME: openSnapshot
+ *
+ * DESCRIPTION: Returns a view following the table, for tables without views of
+ * 				their own
+ */
+shared_ptr<TableSnapshot> StorageEngine::openSnapshot() {
+	return make_shared<LiveSnapshot>(this);
+}
+
+/**
+ * FUNCTION NAME: snapshot
+ *
+ * DESCRIPTION: Replaces entries with a copy of every key and value, which can be
+ * 				worked on while other threads change the table
+ */
+void StorageEngine::snapshot(vector< pair<string, string> > &entries) {
+	entries.clear();
+	entries.reserve(currentSize());
+	forEach([&entries](const string &key, const string &value) {
+		entries.emplace_back(key, value);
+	});
+}
+
+/**
+ * FUNCTION NAME: packValue
+ *
+ * DESCRIPTION: Replaces stored with value behind a header holding expiry
+ */
+void StorageEngine::packValue(string &stored, string_view value, int expiry) {
+	uint32_t header = expiry;
+
+	stored.assign((const char *)&header, EXPIRY_BYTES);
+	stored.append(value.data(), value.size());
+}
+
+/**
+ * FUNCTION NAME: expiryOf
+ *
+ * DESCRIPTION: Tick the key of a stored value expires at, 0 for never
+ */
+int StorageEngine::expiryOf(string_view stored) {
+	uint32_t header = 0;
+
+	if ( stored.size() >= EXPIRY_BYTES ) {
+		memcpy(&header, stored.data(), EXPIRY_BYTES);
+	}
+	return header;
+}
+
+/**
+ * FUNCTION NAME: payloadOf
+ *
+ * DESCRIPTION: The value of a stored value, without its header
+ */
+string_view StorageEngine::payloadOf(string_view stored) {
+	return stored.size() >= EXPIRY_BYTES ? stored.substr(EXPIRY_BYTES) : string_view();
+}
+
+/**
+ * FUNCTION NAME: expiredAt
+ *
+ * DESCRIPTION: Whether the key of a stored value is past its expiry at tick now
+ */
+bool StorageEngine::expiredAt(string_view stored, int now) {
+	int expiry = expiryOf(stored);
+
+	return expiry != 0 && expiry <= now;
+}
+
+/**
+ * Constructor
+ */
+LiveSnapshot::LiveSnapshot(StorageEngine *table) {
+	this->table = table;
+}
+
+bool LiveSnapshot::read(string_view key, string &value) {
+	return table->read(key, value);
+}
+
+void LiveSnapshot::forEach(const function<void(const string &, const string &)> &visit) {
+	table->forEach(visit);
+}
+
+bool LiveSnapshot::pointInTime() {
+	return false;
+}
@@ -0,0 +1,104 @@
+/**********************************
+ * FILE NAME: StorageEngine.h
+ *
+ * DESCRIPTION: Header file of the interface of the tables a node keeps its keys in
+ **********************************/
+
+#ifndef STORAGEENGINE_H_
+#define STORAGEENGINE_H_
+
+/**
+ * Header files
+ */
+#include "stdincludes.h"
+#include <functional>
+#include <memory>
+
+/*
+ * Macros
+ */
+// Bytes of the header in front of every value a node stores
+#define EXPIRY_BYTES 4
+
+/**
+ * CLASS NAME: TableSnapshot
+ *
+ * DESCRIPTION: Read-only view of a table, safe to use from any thread while
+ * 				others change the table. Taken by StorageEngine::openSnapshot,
+ * 				it keeps what it needs alive until it is released.
+ */
+class TableSnapshot {
+public:
+	virtual ~TableSnapshot() {}
+	virtual bool read(string_view key, string &value) = 0;
+	virtual void forEach(const function<void(const string &, const string &)> &visit) = 0;
+	// Whether the view is of one point in time, or follows the table
+	virtual bool pointInTime() = 0;
+};
+
+/**
+ * CLASS NAME: StorageEngine
+ *
+ * DESCRIPTION: Operations of the table of a node, safe to call from any number of
+ * 				threads. A key with an empty value counts as not found. Values
+ * 				are copied out, created values are moved in.
+ * 				Nodes store every value behind a header of EXPIRY_BYTES holding
+ * 				the tick the key expires at, 0 for never, so the expiry is kept
+ * 				wherever the value is, logs and files included. The tables
+ * 				look at it only in createAt and updateAt.
+ */
+class StorageEngine {
+public:
+	virtual ~StorageEngine() {}
+	virtual bool create(string_view key, string &&value) = 0;
+	virtual bool read(string_view key, string &value) = 0;
+	virtual bool update(string_view key, string_view newValue) = 0;
+	virtual bool deleteKey(string_view key) = 0;
+	virtual bool isEmpty() = 0;
+	virtual unsigned long currentSize() = 0;
+	virtual void clear() = 0;
+	virtual unsigned long count(string_view key) = 0;
+	virtual void forEach(const function<void(const string &, const string &)> &visit) = 0;
+	// create and update at tick now, to which a value past its expiry is no
+	// value: createAt writes over it, updateAt deletes it and fails. expired
+	// tells whether there was one. The key is looked up once for both the
+	// check and the write.
+	virtual bool createAt(string_view key, string &&value, int now, bool &expired) = 0;
+	virtual bool updateAt(string_view key, string_view newValue, int now, bool &expired) = 0;
+	// Whether the table keeps its keys in files of its own
+	virtual bool durable() {
+		return false;
+	}
+	// Puts every change made so far in those files
+	virtual int flush() {
+		return SUCCESS;
+	}
+	// View of the table to read or scan while it changes, the table
+	// itself unless overridden
+	virtual shared_ptr<TableSnapshot> openSnapshot();
+	void snapshot(vector< pair<string, string> > &entries);
+
+	static void packValue(string &stored, string_view value, int expiry);
+	static int expiryOf(string_view stored);
+	static string_view payloadOf(string_view stored);
+	static bool expiredAt(string_view stored, int now);
+};
+
+/**
+ * CLASS NAME: LiveSnapshot
+ *
+ * DESCRIPTION: TableSnapshot of a table that cannot take one of a point in time:
+ * 				reads and scans go to the table as it is, with whatever
+ * 				consistency its own forEach gives. The table must outlive it.
+ */
+class LiveSnapshot : public TableSnapshot {
+private:
+	StorageEngine *table;
+public:
+	LiveSnapshot(StorageEngine *table);
+	bool read(string_view key, string &value);
+	void forEach(const function<void(const string &, const string &)> &visit);
+	bool pointInTime();
+};
+
+#endif /* STORAGEENGINE_H_ */
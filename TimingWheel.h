@@ -0,0 +1,124 @@
+/**********************************
+ * FILE NAME: TimingWheel.h
+ *
+ * DESCRIPTION: Hierarchical timing wheel keyed by time in ticks
+ **********************************/
+
+#ifndef TIMINGWHEEL_H_
+#define TIMINGWHEEL_H_
+
+#include "stdincludes.h"
+
+/*
+ * Macros
+ */
+#define WHEEL_BITS 6
+#define WHEEL_SLOTS (1 << WHEEL_BITS)
+#define WHEEL_LEVELS 4
+
+/**
+ * CLASS NAME: TimingWheel
+ *
+ * DESCRIPTION: Holds items until the tick they are due. Level 0 has one slot per
+ * 				tick, every higher level has one slot per WHEEL_SLOTS slots of the
+ * 				level below and is cascaded down when time reaches it. Scheduling
+ * 				is O(1) and every item is moved at most WHEEL_LEVELS times.
+ * 				Items due beyond the last level wait in the last level and are
+ * 				rescheduled each time it wraps.
+ */
+template <class T>
+class TimingWheel {
+private:
+	vector< pair<int, T> > slots[WHEEL_LEVELS][WHEEL_SLOTS];
+	// Next tick to expire, every item due before it has been handed out
+	int current;
+	// Number of items waiting
+	int count;
+
+	void place(int when, const T &item) {
+		int level = 0;
+		while ( level < WHEEL_LEVELS - 1 && ((when ^ current) >> (WHEEL_BITS * (level + 1))) != 0 ) {
+			level++;
+		}
+		int slot = (when >> (WHEEL_BITS * level)) & (WHEEL_SLOTS - 1);
+		slots[level][slot].push_back(make_pair(when, item));
+	}
+
+	// Moves the items of the higher level slots that start at current one level down
+	void cascade() {
+		for ( int level = WHEEL_LEVELS - 1; level > 0; level-- ) {
+			if ( (current & ((1 << (WHEEL_BITS * level)) - 1)) != 0 ) {
+				continue;
+			}
+			vector< pair<int, T> > moved;
+			moved.swap(slots[level][(current >> (WHEEL_BITS * level)) & (WHEEL_SLOTS - 1)]);
+			for ( unsigned int i = 0; i < moved.size(); i++ ) {
+				place(moved[i].first, moved[i].second);
+			}
+		}
+	}
+
+public:
+	TimingWheel(): current(0), count(0) {}
+
+	/**
+	 * FUNCTION NAME: schedule
+	 *
+	 * DESCRIPTION: Hands item out once time reaches when. Items due in the past
+	 * 				are handed out by the next call to advance.
+	 */
+	void schedule(int when, const T &item) {
+		place(max(when, current), item);
+		count++;
+	}
+
+	/**
+	 * FUNCTION NAME: advance
+	 *
+	 * DESCRIPTION: Appends every item due at or before now to due, in the order
+	 * 				of their due time
+	 */
+	void advance(int now, vector<T> &due) {
+		if ( count == 0 ) {
+			current = max(current, now + 1);
+			return;
+		}
+		while ( current <= now ) {
+			cascade();
+			vector< pair<int, T> > &slot = slots[0][current & (WHEEL_SLOTS - 1)];
+			for ( unsigned int i = 0; i < slot.size(); i++ ) {
+				due.push_back(slot[i].second);
+			}
+			count -= slot.size();
+			slot.clear();
+			current++;
+			if ( count == 0 ) {
+				current = max(current, now + 1);
+				break;
+			}
+		}
+	}
+
+	/**
+	 * FUNCTION NAME: drain
+	 *
+	 * DESCRIPTION: Removes every waiting item, due or not
+	 */
+	void drain(vector<T> &all) {
+		for ( int level = 0; level < WHEEL_LEVELS; level++ ) {
+			for ( int slot = 0; slot < WHEEL_SLOTS; slot++ ) {
+				for ( unsigned int i = 0; i < slots[level][slot].size(); i++ ) {
+					all.push_back(slots[level][slot][i].second);
+				}
+				slots[level][slot].clear();
+			}
+		}
+		count = 0;
+	}
+
+	int size() {
+		return count;
+	}
+};
+
+#endif /* TIMINGWHEEL_H_ */
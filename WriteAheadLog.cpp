@@ -0,0 +1,437 @@
+/**********************************
+ * FILE NAME: WriteAheadLog.cpp
+ *
+ * DESCRIPTION: Definition of the write-ahead log and snapshots of a node's table
+ **********************************/
+
+#include "WriteAheadLog.h"
+
+/**
+ * Constructor
+ * Opens, creating it if needed, the log of node in dir
+ */
+WriteAheadLog::WriteAheadLog(const string &dir, int node, int syncPolicy) {
+	this->dirPath = dir;
+	this->walPath = dir + "/node" + to_string(node) + ".wal";
+	this->snapPath = dir + "/node" + to_string(node) + ".snap";
+	this->syncPolicy = syncPolicy;
+	memset(&stats, 0, sizeof(stats));
+
+	mkdir(dir.c_str(), 0755);
+	fd = open(walPath.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+	if ( fd < 0 ) {
+		perror(walPath.c_str());
+		exit(1);
+	}
+	committed = lseek(fd, 0, SEEK_END);
+}
+
+/**
+ * Destructor
+ * Writes what is still buffered
+ */
+WriteAheadLog::~WriteAheadLog() {
+	commit();
+	close(fd);
+}
+
+/**
+ * FUNCTION NAME: crc32
+ *
+ * DESCRIPTION: CRC-32 (IEEE) of size bytes at data
+ */
+uint32_t WriteAheadLog::crc32(const char *data, size_t size) {
+	static uint32_t table[256];
+	static bool ready = false;
+	uint32_t crc = 0xffffffff;
+
+	if ( !ready ) {
+		for ( uint32_t i = 0; i < 256; i++ ) {
+			uint32_t c = i;
+			for ( int k = 0; k < 8; k++ ) {
+				c = (c & 1) ? 0xedb88320 ^ (c >> 1) : c >> 1;
+			}
+			table[i] = c;
+		}
+		ready = true;
+	}
+	for ( size_t i = 0; i < size; i++ ) {
+		crc = table[(crc ^ (unsigned char)data[i]) & 0xff] ^ (crc >> 8);
+	}
+	return crc ^ 0xffffffff;
+}
+
+/**
+ * FUNCTION NAME: appendRecord
+ *
+ * DESCRIPTION: Appends a record to out
+ */
+void WriteAheadLog::appendRecord(string &out, int op, string_view key, string_view value) {
+	size_t start = out.size();
+	uint32_t body = WAL_BODY_HEADER + key.size() + value.size();
+	uint32_t keySize = key.size();
+	uint32_t crc;
+	char code = op;
+
+	out.resize(start + WAL_HEADER);
+	memcpy(&out[start + 4], &body, 4);
+	out.append(&code, 1);
+	out.append((const char *)&keySize, 4);
+	out.append(key.data(), key.size());
+	out.append(value.data(), value.size());
+	crc = crc32(&out[start + 4], 4 + body);
+	memcpy(&out[start], &crc, 4);
+}
+
+/**
+ * FUNCTION NAME: writeAll
+ *
+ * DESCRIPTION: Writes size bytes at data to fd, going on after short writes
+ *
+ * RETURNS:
+ * true if everything was written
+ */
+bool WriteAheadLog::writeAll(int fd, const char *data, size_t size) {
+	while ( size > 0 ) {
+		ssize_t n = write(fd, data, size);
+		if ( n < 0 && errno == EINTR ) {
+			continue;
+		}
+		if ( n <= 0 ) {
+			return false;
+		}
+		data += n;
+		size -= n;
+	}
+	return true;
+}
+
+/**
+ * FUNCTION NAME: readFile
+ *
+ * DESCRIPTION: Reads the file at path into data
+ *
+ * RETURNS:
+ * false if it could not be opened
+ */
+bool WriteAheadLog::readFile(const string &path, string &data) {
+	struct stat st;
+	int in = open(path.c_str(), O_RDONLY);
+	size_t got = 0;
+
+	data.clear();
+	if ( in < 0 ) {
+		return false;
+	}
+	if ( fstat(in, &st) == 0 ) {
+		data.resize(st.st_size);
+	}
+	while ( got < data.size() ) {
+		ssize_t n = read(in, &data[got], data.size() - got);
+		if ( n < 0 && errno == EINTR ) {
+			continue;
+		}
+		if ( n <= 0 ) {
+			break;
+		}
+		got += n;
+	}
+	data.resize(got);
+	close(in);
+	return true;
+}
+
+/**
+ * FUNCTION NAME: replay
+ *
+ * DESCRIPTION: Applies the records in data to ht, up to the first one that is cut
+ * 				short or fails its CRC. A snapshot must end with a WAL_END record
+ * 				whose count matches, or none of it is applied.
+ *
+ * RETURNS:
+ * Bytes of valid records, -1 for a snapshot that is not whole
+ */
+long WriteAheadLog::replay(const string &data, StorageEngine *ht, bool snapshot, long *records) {
+	size_t pos = 0;
+	long count = 0;
+
+	if ( snapshot ) {
+		// Checked whole before anything is applied
+		for ( pos = 0; pos + WAL_HEADER <= data.size(); ) {
+			uint32_t crc, body;
+			memcpy(&crc, &data[pos], 4);
+			memcpy(&body, &data[pos + 4], 4);
+			if ( body < WAL_BODY_HEADER || body > data.size() - pos - WAL_HEADER || crc != crc32(&data[pos + 4], 4 + body) ) {
+				return -1;
+			}
+			if ( WAL_END == data[pos + WAL_HEADER] ) {
+				long total;
+				if ( body != WAL_BODY_HEADER + sizeof(total) ) {
+					return -1;
+				}
+				memcpy(&total, &data[pos + WAL_HEADER + WAL_BODY_HEADER], sizeof(total));
+				if ( total != count ) {
+					return -1;
+				}
+				break;
+			}
+			count++;
+			pos += WAL_HEADER + body;
+		}
+		if ( pos + WAL_HEADER > data.size() ) {
+			return -1;
+		}
+		count = 0;
+	}
+
+	for ( pos = 0; pos + WAL_HEADER <= data.size(); ) {
+		uint32_t crc, body, keySize;
+		memcpy(&crc, &data[pos], 4);
+		memcpy(&body, &data[pos + 4], 4);
+		if ( body < WAL_BODY_HEADER || body > data.size() - pos - WAL_HEADER || crc != crc32(&data[pos + 4], 4 + body) ) {
+			// Torn or damaged, nothing after it can be trusted
+			break;
+		}
+		int op = data[pos + WAL_HEADER];
+		if ( WAL_END == op ) {
+			break;
+		}
+		memcpy(&keySize, &data[pos + WAL_HEADER + 1], 4);
+		if ( keySize > body - WAL_BODY_HEADER ) {
+			break;
+		}
+		string_view key(&data[pos + WAL_HEADER + WAL_BODY_HEADER], keySize);
+		string_view value(key.data() + keySize, body - WAL_BODY_HEADER - keySize);
+
+		switch ( op ) {
+			case WAL_CREATE:
+				ht->create(key, string(value));
+				break;
+			case WAL_UPDATE:
+				ht->update(key, value);
+				break;
+			case WAL_DELETE:
+				ht->deleteKey(key);
+				break;
+		}
+		count++;
+		pos += WAL_HEADER + body;
+	}
+
+	*records += count;
+	return pos;
+}
+
+/**
+ * FUNCTION NAME: recover
+ *
+ * DESCRIPTION: Loads the snapshot into ht, which should be empty unless it keeps
+ * 				its own keys on disk, and replays the log over it. A damaged
+ * 				tail of the log is cut off, so new records follow the last good
+ * 				one.
+ *
+ * RETURNS:
+ * Number of records applied
+ */
+long WriteAheadLog::recover(StorageEngine *ht) {
+	string data;
+	long records = 0;
+	long good;
+
+	if ( !ht->durable() && readFile(snapPath, data) && replay(data, ht, true, &records) < 0 ) {
+		fprintf(stderr, "%s: damaged snapshot ignored\n", snapPath.c_str());
+	}
+	readFile(walPath, data);
+	good = replay(data, ht, false, &records);
+	if ( good < (long)data.size() ) {
+		fprintf(stderr, "%s: %ld damaged bytes cut off\n", walPath.c_str(), (long)data.size() - good);
+		if ( ftruncate(fd, good) < 0 ) {
+			perror(walPath.c_str());
+		}
+	}
+	committed = good;
+	return records;
+}
+
+/**
+ * FUNCTION NAME: add
+ *
+ * DESCRIPTION: Buffers a record, written right away under WAL_SYNC always
+ */
+void WriteAheadLog::add(int op, string_view key, string_view value) {
+	appendRecord(batch, op, key, value);
+	stats.records++;
+	if ( ALWAYS_SYNC == syncPolicy ) {
+		commit();
+	}
+}
+
+/**
+ * FUNCTION NAME: create
+ *
+ * DESCRIPTION: Logs a create, before it is applied: replaying it over a table that
+ * 				has the key changes nothing, like the create itself
+ */
+void WriteAheadLog::create(string_view key, string_view value) {
+	add(WAL_CREATE, key, value);
+}
+
+/**
+ * FUNCTION NAME: update
+ *
+ * DESCRIPTION: Logs an update that succeeded
+ */
+void WriteAheadLog::update(string_view key, string_view value) {
+	add(WAL_UPDATE, key, value);
+}
+
+/**
+ * FUNCTION NAME: erase
+ *
+ * DESCRIPTION: Logs a delete that succeeded
+ */
+void WriteAheadLog::erase(string_view key) {
+	add(WAL_DELETE, key, string_view());
+}
+
+/**
+ * FUNCTION NAME: pending
+ *
+ * DESCRIPTION: Whether records are waiting for commit. Replies acknowledging
+ * 				them should wait too.
+ */
+bool WriteAheadLog::pending() {
+	return !batch.empty();
+}
+
+/**
+ * FUNCTION NAME: commit
+ *
+ * DESCRIPTION: Writes the buffered records with one write, followed by one
+ * 				fdatasync unless WAL_SYNC is none. If either fails the log is
+ * 				cut back to the end of the last commit and the records stay
+ * 				buffered for the next one: written again after a partial
+ * 				write, they would follow bytes failing their CRC and recovery
+ * 				would never get to them.
+ *
+ * RETURNS:
+ * SUCCESS or FAILURE, in which case pending() stays true
+ */
+int WriteAheadLog::commit() {
+	bool ok;
+
+	if ( batch.empty() ) {
+		return SUCCESS;
+	}
+	ok = writeAll(fd, batch.data(), batch.size());
+	if ( ok && NO_SYNC != syncPolicy ) {
+		stats.syncs++;
+		ok = fdatasync(fd) == 0;
+	}
+	if ( !ok ) {
+		perror(walPath.c_str());
+		if ( ftruncate(fd, committed) < 0 ) {
+			perror(walPath.c_str());
+		}
+		return FAILURE;
+	}
+	stats.commits++;
+	stats.bytes += batch.size();
+	committed += batch.size();
+	// clear keeps the capacity for the next batch
+	batch.clear();
+	return SUCCESS;
+}
+
+/**
+ * FUNCTION NAME: checkpoint
+ *
+ * DESCRIPTION: Writes every key of ht to a new snapshot, renames it over the old
+ * 				one and empties the log. A table that keeps its keys on disk is
+ * 				flushed instead. The keys are those of a view of ht taken as the
+ * 				log is committed; with a view of one point in time ht may change
+ * 				meanwhile, as long as the changes are logged, otherwise nothing
+ * 				may change it.
+ *
+ * RETURNS:
+ * SUCCESS or FAILURE, in which case the old snapshot and the log are kept
+ */
+int WriteAheadLog::checkpoint(StorageEngine *ht) {
+	string tmpPath = snapPath + ".tmp";
+	shared_ptr<TableSnapshot> view;
+	string out;
+	long count = 0;
+	bool ok = true;
+	int snap, dir;
+
+	if ( commit() != SUCCESS ) {
+		return FAILURE;
+	}
+	if ( ht->durable() ) {
+		if ( ht->flush() != SUCCESS ) {
+			return FAILURE;
+		}
+		return truncate();
+	}
+	snap = open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if ( snap < 0 ) {
+		perror(tmpPath.c_str());
+		return FAILURE;
+	}
+
+	// Changes from here on are in batch, which outlives the truncation
+	view = ht->openSnapshot();
+	out.reserve(WAL_WRITE_CHUNK + 4096);
+	view->forEach([&](const string &key, const string &value) {
+		appendRecord(out, WAL_CREATE, key, value);
+		count++;
+		if ( out.size() >= WAL_WRITE_CHUNK ) {
+			ok = ok && writeAll(snap, out.data(), out.size());
+			out.clear();
+		}
+	});
+	appendRecord(out, WAL_END, string_view(), string_view((const char *)&count, sizeof(count)));
+	ok = ok && writeAll(snap, out.data(), out.size());
+	ok = ok && fdatasync(snap) == 0;
+	close(snap);
+	if ( !ok || rename(tmpPath.c_str(), snapPath.c_str()) < 0 ) {
+		perror(tmpPath.c_str());
+		unlink(tmpPath.c_str());
+		return FAILURE;
+	}
+
+	// The rename itself must reach the disk before the log is emptied
+	dir = open(dirPath.c_str(), O_RDONLY);
+	if ( dir >= 0 ) {
+		fsync(dir);
+		close(dir);
+	}
+	return truncate();
+}
+
+/**
+ * FUNCTION NAME: truncate
+ *
+ * DESCRIPTION: Empties the log once what it covers is on disk elsewhere
+ */
+int WriteAheadLog::truncate() {
+	if ( ftruncate(fd, 0) < 0 ) {
+		perror(walPath.c_str());
+		return FAILURE;
+	}
+	committed = 0;
+	if ( NO_SYNC != syncPolicy ) {
+		fdatasync(fd);
+	}
+	stats.checkpoints++;
+	return SUCCESS;
+}
+
+/**
+ * FUNCTION NAME: getStats
+ *
+ * DESCRIPTION: Returns the counters
+ */
+WalStats WriteAheadLog::getStats() {
+	return stats;
+}
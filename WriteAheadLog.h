@@ -0,0 +1,104 @@
+/**********************************
+ * FILE NAME: WriteAheadLog.h
+ *
+ * DESCRIPTION: Header file of the write-ahead log and snapshots of a node's table
+ **********************************/
+
+#ifndef WRITEAHEADLOG_H_
+#define WRITEAHEADLOG_H_
+
+#include "stdincludes.h"
+#include "Params.h"
+#include "StorageEngine.h"
+#include <errno.h>
+#include <sys/stat.h>
+
+/*
+ * Macros
+ */
+// Bytes before the body of a record: crc, then body size
+#define WAL_HEADER 8
+// Bytes of the body before the key: op, then key size
+#define WAL_BODY_HEADER 5
+// Snapshot records are written out once this many bytes are buffered
+#define WAL_WRITE_CHUNK (1 << 20)
+
+// Record types, the values go on disk
+enum walOP { WAL_CREATE = 1, WAL_UPDATE, WAL_DELETE, WAL_END };
+
+/**
+ * STRUCT NAME: WalStats
+ *
+ * DESCRIPTION: Counters of a WriteAheadLog
+ */
+typedef struct WalStats {
+	// records appended
+	long records;
+	// batches written
+	long commits;
+	// fdatasync calls on the log
+	long syncs;
+	// bytes written to the log
+	long bytes;
+	// snapshots taken
+	long checkpoints;
+} WalStats;
+
+/**
+ * CLASS NAME: WriteAheadLog
+ *
+ * DESCRIPTION: Keeps the table of a node on disk, in the directory given by
+ * 				STORAGE, as node<id>.snap and node<id>.wal. The snapshot holds
+ * 				every key at some point, the log every change since then.
+ *
+ * 				A record is
+ * 					crc (4) | body size (4) | op (1) | key size (4) | key | value
+ * 				where the CRC-32 covers everything after itself, so a record
+ * 				torn by a crash or a flipped bit is found and the log is cut
+ * 				there. Changes are buffered and written by commit, which the
+ * 				node calls once per tick: one write and, with WAL_SYNC group,
+ * 				one fdatasync cover every change of the tick (group commit).
+ * 				With WAL_SYNC always every change is synced on its own, with
+ * 				none the kernel decides when the log reaches the disk.
+ *
+ * 				checkpoint writes the whole table to a new snapshot, holding
+ * 				the same records ended by a WAL_END one carrying the count,
+ * 				renames it over the old one and empties the log. A crash
+ * 				before the rename leaves the old snapshot and the full log,
+ * 				after it replaying the old log over the new snapshot changes
+ * 				nothing, so either way recover rebuilds the same table.
+ */
+class WriteAheadLog {
+private:
+	string walPath;
+	string snapPath;
+	string dirPath;
+	int fd;
+	int syncPolicy;
+	// Records not written yet
+	string batch;
+	// Bytes of the log up to the end of the last batch committed
+	off_t committed;
+	WalStats stats;
+
+	static void appendRecord(string &out, int op, string_view key, string_view value);
+	static long replay(const string &data, StorageEngine *ht, bool snapshot, long *records);
+	static bool readFile(const string &path, string &data);
+	static bool writeAll(int fd, const char *data, size_t size);
+	void add(int op, string_view key, string_view value);
+	int truncate();
+public:
+	WriteAheadLog(const string &dir, int node, int syncPolicy);
+	virtual ~WriteAheadLog();
+	long recover(StorageEngine *ht);
+	void create(string_view key, string_view value);
+	void update(string_view key, string_view value);
+	void erase(string_view key);
+	bool pending();
+	int commit();
+	int checkpoint(StorageEngine *ht);
+	WalStats getStats();
+	static uint32_t crc32(const char *data, size_t size);
+};
+
+#endif /* WRITEAHEADLOG_H_ */
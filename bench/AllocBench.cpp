@@ -0,0 +1,88 @@
+/**********************************
+ * FILE NAME: AllocBench.cpp
+ *
+ * DESCRIPTION: Counts the heap allocations of the server side operations on
+ * 				keys that are present: HashTable reads with string_view keys,
+ * 				updates and deletes, and MP2Node::readKey with its logging.
+ * 				Every operation is done once before counting, so buffers kept
+ * 				from call to call are already grown.
+ *
+ * 				bench/AllocBench [keys]
+ **********************************/
+
+#include "MP2Node.h"
+#include "bench/BenchUtil.h"
+#include <new>
+
+static long allocations;
+
+void *operator new(size_t size) {
+	allocations++;
+	void *p = malloc(size ? size : 1);
+	if ( NULL == p ) {
+		throw bad_alloc();
+	}
+	return p;
+}
+
+void operator delete(void *p) noexcept {
+	free(p);
+}
+
+void operator delete(void *p, size_t size) noexcept {
+	free(p);
+}
+
+/*
+ * Allocations op makes over count calls after a first one
+ */
+template <class Op>
+static long countAllocations(long count, Op op) {
+	op(0);
+	long before = allocations;
+	for ( long i = 0; i < count; i++ ) {
+		op(i);
+	}
+	return allocations - before;
+}
+
+int main(int argc, char *argv[]) {
+	long keys = benchArg(argc, argv, 1, 100000);
+	mt19937 rng(1);
+	vector<string> names = benchKeys(keys, rng);
+	string value(32, 'v');
+	HashTable table;
+
+	for ( const string &name : names ) {
+		table.create(name, string(value));
+	}
+	printf("allocations over the calls\n");
+	printf("  %7ld HashTable::read       %ld\n", keys * 10, countAllocations(keys * 10, [&](long i) {
+		benchSink += table.read(string_view(names[i % keys])).size();
+	}));
+	printf("  %7ld HashTable::update     %ld\n", keys, countAllocations(keys, [&](long i) {
+		table.update(names[i % keys], value);
+	}));
+	printf("  %7ld HashTable::deleteKey  %ld\n", keys - 1, countAllocations(keys - 1, [&](long i) {
+		table.deleteKey(names[i + 1]);
+	}));
+
+	Params par;
+	// The node deletes its member when done
+	Member *member = new Member;
+	Address addr, requester;
+	par.EN_GPSZ = 1;
+	par.MAX_MSG_SIZE = 4000;
+	par.globaltime = 0;
+	EmulNet net(&par);
+	Log log(&par);
+	net.ENinit(&addr, par.PORTNUM);
+	MP2Node node(member, &par, &net, &log, &addr);
+	for ( long i = 0; i < keys; i++ ) {
+		node.createKeyValue(names[i], value, PRIMARY, (int)i, requester);
+	}
+	printf("  %7ld MP2Node::readKey      %ld\n", keys, countAllocations(keys, [&](long i) {
+		benchSink += node.readKey(names[i % keys], (int)i, requester).size();
+	}));
+	return 0;
+}
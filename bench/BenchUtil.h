@@ -0,0 +1,47 @@
+/**********************************
+ * FILE NAME: BenchUtil.h
+ *
+ * DESCRIPTION: Timing and helpers shared by the benchmark programs
+ **********************************/
+
+#ifndef BENCHUTIL_H_
+#define BENCHUTIL_H_
+
+#include "stdincludes.h"
+#include <chrono>
+#include <random>
+
+/*
+ * Seconds on a monotonic clock
+ */
+static inline double benchNow() {
+	return chrono::duration<double>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/*
+ * The argument at index i as a number, dflt if not given
+ */
+static inline long benchArg(int argc, char *argv[], int i, long dflt) {
+	return argc > i ? strtol(argv[i], NULL, 10) : dflt;
+}
+
+/*
+ * Keys key0 to key<count - 1> in random order
+ */
+static inline vector<string> benchKeys(long count, mt19937 &rng) {
+	vector<string> keys;
+
+	keys.reserve(count);
+	for ( long i = 0; i < count; i++ ) {
+		keys.push_back("key" + to_string(i));
+	}
+	shuffle(keys.begin(), keys.end(), rng);
+	return keys;
+}
+
+/*
+ * Stops the compiler from dropping work whose result is not used
+ */
+static volatile long benchSink;
+
+#endif /* BENCHUTIL_H_ */
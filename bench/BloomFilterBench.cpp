@@ -0,0 +1,140 @@
+/**********************************
+ * FILE NAME: BloomFilterBench.cpp
+ *
+ * DESCRIPTION: Cost of reads of absent keys without a bloom filter and with 4
+ * 				and 8 counters per key, over the hash and the lsm engines. Some
+ * 				keys are created and a quarter of them deleted first, the
+ * 				probes are of the deleted keys and of keys never created.
+ * 				Reads go to the table behind a filter alone, then through
+ * 				MP2Node::readKey and so through mayHave, where every read also
+ * 				writes its line to dbg.log as on a real node.
+ *
+ * 				bench/BloomFilterBench [keys] [probes] [directory]
+ **********************************/
+
+#include "MP2Node.h"
+#include "bench/BenchUtil.h"
+
+/*
+ * ns per read of an absent key asking the table alone, behind a filter built
+ * as MP2Node::addKey builds its own unless counters is 0, and in passed the
+ * share of the probes the filter let through
+ */
+static double tableCost(int engine, int counters, const string &dir, vector<string> &keys, long deleted, vector<string> &probes, double *passed) {
+	StorageEngine *table;
+	CountingBloomFilter filter(max(counters, 1));
+	string value;
+	long through = 0, found = 0;
+
+	if ( LSM_ENGINE == engine ) {
+		table = new LsmTable(dir + "/table.lsm");
+		table->clear();
+	}
+	else {
+		table = new ConcurrentHashTable();
+	}
+	for ( long i = 0; i < (long)keys.size(); i++ ) {
+		table->create(keys[i], string(100, 'v'));
+		filter.insert(keys[i]);
+		if ( filter.full() ) {
+			filter.reset(2 * (i + 1));
+			for ( long j = 0; j <= i; j++ ) {
+				filter.insert(keys[j]);
+			}
+		}
+	}
+	for ( long i = 0; i < deleted; i++ ) {
+		table->deleteKey(keys[i]);
+		filter.erase(keys[i]);
+	}
+	double start = benchNow();
+	for ( const string &probe : probes ) {
+		if ( 0 == counters || filter.mayContain(probe) ) {
+			through++;
+			found += table->read(probe, value);
+		}
+	}
+	double elapsed = benchNow() - start;
+	delete table;
+	if ( found > 0 ) {
+		fprintf(stderr, "BloomFilterBench: %ld absent keys found\n", found);
+		exit(1);
+	}
+	*passed = (double)through / probes.size();
+	return elapsed * 1e9 / probes.size();
+}
+
+/*
+ * ns per read of an absent key on a node with engine and counters per key
+ */
+static double missCost(int engine, int counters, const string &dir, vector<string> &keys, long deleted, vector<string> &probes) {
+	Params par;
+	Address addr, requester;
+	string value(100, 'v');
+	long found = 0;
+
+	par.EN_GPSZ = 1;
+	par.MAX_MSG_SIZE = 4000;
+	par.globaltime = 0;
+	par.STORAGE_ENGINE = engine;
+	par.ENGINE_DIR = dir;
+	par.BLOOM_FILTER = counters;
+	EmulNet net(&par);
+	Log log(&par);
+	net.ENinit(&addr, par.PORTNUM);
+	// The node deletes its member when done
+	MP2Node node(new Member, &par, &net, &log, &addr);
+
+	for ( long i = 0; i < (long)keys.size(); i++ ) {
+		node.createKeyValue(keys[i], value, PRIMARY, (int)i, requester);
+	}
+	for ( long i = 0; i < deleted; i++ ) {
+		node.deletekey(keys[i], (int)i, requester);
+	}
+	double start = benchNow();
+	for ( long i = 0; i < (long)probes.size(); i++ ) {
+		found += !node.readKey(probes[i], (int)i, requester).empty();
+	}
+	double elapsed = benchNow() - start;
+	if ( found > 0 ) {
+		fprintf(stderr, "BloomFilterBench: %ld absent keys found\n", found);
+		exit(1);
+	}
+	return elapsed * 1e9 / probes.size();
+}
+
+int main(int argc, char *argv[]) {
+	long count = benchArg(argc, argv, 1, 200000);
+	long probeCount = benchArg(argc, argv, 2, 1000000);
+	char temp[] = "/tmp/bloombench.XXXXXX";
+	string dir = argc > 3 ? argv[3] : mkdtemp(temp);
+	static const int counters[] = {4, 8};
+	static const char *engines[] = {"hash", "lsm"};
+	mt19937 rng(1);
+	vector<string> keys = benchKeys(count, rng);
+	vector<string> probes;
+	long deleted = count / 4;
+
+	for ( long i = 0; i < probeCount; i++ ) {
+		probes.push_back(i % 2 ? keys[rng() % deleted] : "absent" + to_string(rng()));
+	}
+	double passed;
+
+	printf("%ld keys, %ld deleted, %ld reads of absent keys, ns per read\n", count, deleted, probeCount);
+	printf("                        table alone           MP2Node::readKey\n");
+	printf("  engine  counters/key  no filter  filtered  no filter  filtered  false positives\n");
+	for ( int engine = HASH_ENGINE; engine <= LSM_ENGINE; engine++ ) {
+		double table = tableCost(engine, 0, dir, keys, deleted, probes, &passed);
+		double node = missCost(engine, 0, dir, keys, deleted, probes);
+		for ( int n : counters ) {
+			double filtered = tableCost(engine, n, dir, keys, deleted, probes, &passed);
+			printf("  %-6s  %12d  %9.0f  %8.0f  %9.0f  %8.0f  %14.2f%%\n", engines[engine], n, table, filtered,
+					node, missCost(engine, n, dir, keys, deleted, probes), 100 * passed);
+		}
+	}
+
+	if ( argc < 4 ) {
+		benchSink += system(("rm -rf " + dir).c_str());
+	}
+	return 0;
+}
@@ -0,0 +1,119 @@
+/**********************************
+ * FILE NAME: BoundedTableBench.cpp
+ *
+ * DESCRIPTION: Hit rate and read latency of BoundedTable under a memory budget
+ * 				far below its data: zipf(0.99) reads of random keys, timed one
+ * 				by one and split into hot reads, served from memory, and cold
+ * 				ones, served from the spill file. Then one sequential scan of
+ * 				every key, after which the zipf reads should hit as often as
+ * 				before since ARC keeps a one-pass scan out of T2.
+ *
+ * 				bench/BoundedTableBench [keys] [reads] [directory]
+ **********************************/
+
+#include "BoundedTable.h"
+#include "bench/BenchUtil.h"
+
+/*
+ * Macros
+ */
+#define VALUE_BYTES 1000
+#define ZIPF_S 0.99
+
+/*
+ * Draws key ranks 0 to n - 1, rank r with probability proportional to
+ * 1 / (r + 1)^s
+ */
+class Zipf {
+private:
+	vector<double> cdf;
+public:
+	Zipf(long n, double s) {
+		double sum = 0;
+		cdf.resize(n);
+		for ( long r = 0; r < n; r++ ) {
+			sum += 1 / pow(r + 1, s);
+			cdf[r] = sum;
+		}
+		for ( double &c : cdf ) {
+			c /= sum;
+		}
+	}
+	long next(mt19937 &rng) {
+		double u = uniform_real_distribution<double>(0, 1)(rng);
+		return min((long)(lower_bound(cdf.begin(), cdf.end(), u) - cdf.begin()), (long)cdf.size() - 1);
+	}
+};
+
+/*
+ * Value at fraction q of the sorted samples, in us
+ */
+static double percentile(vector<double> &samples, double q) {
+	if ( samples.empty() ) {
+		return 0;
+	}
+	size_t at = min(samples.size() - 1, (size_t)(q * samples.size()));
+	nth_element(samples.begin(), samples.begin() + at, samples.end());
+	return samples[at] * 1e6;
+}
+
+/*
+ * reads zipf reads, printing the hit rate and the hot and cold percentiles
+ */
+static void zipfReads(const char *label, BoundedTable &table, vector<string> &keys, Zipf &zipf, long reads, mt19937 &rng) {
+	vector<double> hot, cold;
+	string value;
+
+	for ( long i = 0; i < reads; i++ ) {
+		const string &key = keys[zipf.next(rng)];
+		long misses = table.getStats().misses;
+		double start = benchNow();
+		table.read(key, value);
+		double took = benchNow() - start;
+		(table.getStats().misses == misses ? hot : cold).push_back(took);
+	}
+	printf("  %-12s hit %5.1f%%  hot p50/p99 %5.2f/%5.2f us  cold p50/p99 %5.2f/%5.2f us\n", label,
+			100.0 * hot.size() / reads, percentile(hot, 0.5), percentile(hot, 0.99),
+			percentile(cold, 0.5), percentile(cold, 0.99));
+}
+
+int main(int argc, char *argv[]) {
+	long count = benchArg(argc, argv, 1, 200000);
+	long reads = benchArg(argc, argv, 2, 1000000);
+	char temp[] = "/tmp/boundedbench.XXXXXX";
+	string dir = argc > 3 ? argv[3] : mkdtemp(temp);
+	static const size_t budgets[] = {32 << 20, 64 << 20};
+	mt19937 rng(1);
+	vector<string> keys = benchKeys(count, rng);
+	Zipf zipf(count, ZIPF_S);
+	string value;
+
+	printf("%ld keys of %d byte values (%ld MB), zipf(%.2f) reads\n", count, VALUE_BYTES,
+			count * VALUE_BYTES >> 20, ZIPF_S);
+	for ( size_t budget : budgets ) {
+		BoundedTable table(dir + "/bench.spill", budget);
+		size_t peak = 0;
+
+		for ( long i = 0; i < count; i++ ) {
+			table.create(keys[i], string(VALUE_BYTES, 'a' + i % 26));
+			if ( i % 1000 == 0 ) {
+				peak = max(peak, table.memoryUsed());
+			}
+		}
+		printf("budget %zu MB\n", budget >> 20);
+		// Once to warm the lists up, then measured
+		zipfReads("warm up", table, keys, zipf, reads / 2, rng);
+		zipfReads("zipf", table, keys, zipf, reads, rng);
+		for ( const string &key : keys ) {
+			table.read(key, value);
+			peak = max(peak, table.memoryUsed());
+		}
+		zipfReads("after scan", table, keys, zipf, reads, rng);
+		printf("  peak memory %zu of %zu bytes\n", peak, budget);
+	}
+
+	if ( argc < 4 ) {
+		benchSink += system(("rm -rf " + dir).c_str());
+	}
+	return 0;
+}
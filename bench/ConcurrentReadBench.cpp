@@ -0,0 +1,85 @@
+/**********************************
+ * FILE NAME: ConcurrentReadBench.cpp
+ *
+ * DESCRIPTION: Read throughput of ConcurrentHashTable: a fixed number of random
+ * 				reads split over 1 to 8 threads, alone and next to one thread
+ * 				updating random keys for as long as the readers run
+ *
+ * 				bench/ConcurrentReadBench [keys] [reads]
+ **********************************/
+
+#include "ConcurrentHashTable.h"
+#include "bench/BenchUtil.h"
+#include <atomic>
+#include <thread>
+
+/*
+ * Macros
+ */
+#define VALUE_BYTES 32
+
+/*
+ * Millions of reads per second of reads reads over threads threads
+ */
+static double readRate(ConcurrentHashTable &table, vector<string> &keys, long reads, int threads, bool writer) {
+	atomic<bool> done(false);
+	vector<thread> readers;
+	thread updater;
+
+	if ( writer ) {
+		updater = thread([&]() {
+			mt19937 rng(threads);
+			string value(VALUE_BYTES, 'u');
+			while ( !done.load(memory_order_relaxed) ) {
+				table.update(keys[rng() % keys.size()], value);
+			}
+		});
+	}
+	double start = benchNow();
+	for ( int t = 0; t < threads; t++ ) {
+		readers.emplace_back([&, t]() {
+			mt19937 rng(t + 1);
+			string value;
+			long found = 0;
+			for ( long i = 0; i < reads / threads; i++ ) {
+				found += table.read(keys[rng() % keys.size()], value);
+			}
+			benchSink += found;
+		});
+	}
+	for ( thread &reader : readers ) {
+		reader.join();
+	}
+	double elapsed = benchNow() - start;
+	done = true;
+	if ( writer ) {
+		updater.join();
+	}
+	return reads / elapsed / 1e6;
+}
+
+int main(int argc, char *argv[]) {
+	long count = benchArg(argc, argv, 1, 1000000);
+	long reads = benchArg(argc, argv, 2, 2000000);
+	static const int threads[] = {1, 2, 4, 8};
+	mt19937 rng(1);
+	vector<string> keys = benchKeys(count, rng);
+	ConcurrentHashTable table;
+
+	for ( const string &key : keys ) {
+		table.create(key, string(VALUE_BYTES, 'v'));
+	}
+	printf("%ld keys, %ld reads, %u cpus\n    threads", count, reads, thread::hardware_concurrency());
+	for ( int n : threads ) {
+		printf("%7d", n);
+	}
+	for ( int writer = 0; writer < 2; writer++ ) {
+		printf("\n   Mreads/s");
+		for ( int n : threads ) {
+			printf("%7.2f", readRate(table, keys, reads, n, writer));
+		}
+		printf("   %s", writer ? "plus 1 updating thread" : "no writers");
+	}
+	printf("\n");
+	return 0;
+}
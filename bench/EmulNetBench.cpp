@@ -0,0 +1,92 @@
+/**********************************
+ * FILE NAME: EmulNetBench.cpp
+ *
+ * DESCRIPTION: Time of one tick of EmulNet alone: every node sends MSGS_PER_TICK
+ * 				messages to random nodes, then every node drains its inbox, as
+ * 				Application does once per tick
+ *
+ * 				bench/EmulNetBench [ticks]
+ **********************************/
+
+#include "EmulNet.h"
+#include "bench/BenchUtil.h"
+
+/*
+ * Macros
+ */
+#define MSGS_PER_TICK 4
+#define MSG_BYTES 64
+
+static long received;
+
+/*
+ * Counts a received message and hands its buffer back
+ */
+static int countMessage(void *env, char *buff, int size, MsgBuffer *buf, char *tag, int tagSize) {
+	received++;
+	if ( NULL != buf ) {
+		buf->release();
+	}
+	else {
+		free(buff);
+	}
+	return 0;
+}
+
+/*
+ * Microseconds per tick of a network of nodes nodes
+ */
+static double tickTime(int nodes, int ticks, mt19937 &rng) {
+	Params par;
+	char data[MSG_BYTES];
+	vector<Address> addrs(nodes);
+	double start;
+
+	par.EN_GPSZ = nodes;
+	par.MAX_MSG_SIZE = 4000;
+	par.MSG_DROP_PROB = 0;
+	par.dropmsg = 0;
+	par.globaltime = 0;
+	par.LINK_DELAY.type = CONST_DELAY;
+	par.LINK_DELAY.a = 0;
+	par.LINK_DELAY.b = 0;
+	par.EGRESS_BW = 0;
+	memset(data, 'x', sizeof(data));
+
+	EmulNet net(&par);
+	for ( int i = 0; i < nodes; i++ ) {
+		net.ENinit(&addrs[i], par.PORTNUM);
+	}
+	received = 0;
+	start = benchNow();
+	for ( int t = 0; t < ticks; t++ ) {
+		for ( int i = 0; i < nodes; i++ ) {
+			for ( int m = 0; m < MSGS_PER_TICK; m++ ) {
+				net.ENsend(&addrs[i], &addrs[rng() % nodes], data, sizeof(data), CONTROL_CLASS);
+			}
+		}
+		for ( int i = 0; i < nodes; i++ ) {
+			net.ENrecv(&addrs[i], countMessage, NULL, 1, NULL);
+		}
+		par.globaltime++;
+	}
+	double elapsed = benchNow() - start;
+	net.ENcleanup();
+	if ( received < (long)nodes * MSGS_PER_TICK * (ticks - 1) ) {
+		fprintf(stderr, "EmulNetBench: only %ld messages received\n", received);
+		exit(1);
+	}
+	return elapsed * 1e6 / ticks;
+}
+
+int main(int argc, char *argv[]) {
+	int ticks = (int)benchArg(argc, argv, 1, 200);
+	static const int sizes[] = {10, 100, 1000};
+	mt19937 rng(1);
+
+	printf("%d msgs/node/tick, %d ticks\n  nodes   us/tick\n", MSGS_PER_TICK, ticks);
+	for ( int nodes : sizes ) {
+		printf("%7d %9.1f\n", nodes, tickTime(nodes, ticks, rng));
+	}
+	return 0;
+}
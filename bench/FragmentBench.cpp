@@ -0,0 +1,69 @@
+/**********************************
+ * FILE NAME: FragmentBench.cpp
+ *
+ * DESCRIPTION: Throughput of one node streaming values of one size to another
+ * 				on EmulNet with MAX_MSG_SIZE 4000, values larger than a frame
+ * 				being fragmented and reassembled. Every tick the sender sends
+ * 				until it would block and the receiver drains its inbox.
+ *
+ * 				bench/FragmentBench [MB per size]
+ **********************************/
+
+#include "EmulNet.h"
+#include "bench/BenchUtil.h"
+
+static long receivedBytes;
+
+/*
+ * Counts the bytes of a received message and hands its buffer back
+ */
+static int countBytes(void *env, char *buff, int size, MsgBuffer *buf, char *tag, int tagSize) {
+	receivedBytes += size;
+	if ( NULL != buf ) {
+		buf->release();
+	}
+	else {
+		free(buff);
+	}
+	return 0;
+}
+
+int main(int argc, char *argv[]) {
+	long total = benchArg(argc, argv, 1, 256) << 20;
+	static const int sizes[] = {100, 1 << 10, 4 << 10, 16 << 10, 64 << 10, 256 << 10, 1 << 20};
+
+	printf("MAX_MSG_SIZE 4000, %ld MB per size\n     size      MB/s  KB delivered per tick\n", total >> 20);
+	for ( int size : sizes ) {
+		Params par;
+		Address from, to;
+		string value(size, 'v');
+		long sent = 0;
+
+		par.EN_GPSZ = 2;
+		par.MAX_MSG_SIZE = 4000;
+		par.MSG_DROP_PROB = 0;
+		par.dropmsg = 0;
+		par.globaltime = 0;
+		par.LINK_DELAY.type = CONST_DELAY;
+		par.LINK_DELAY.a = 0;
+		par.LINK_DELAY.b = 0;
+		par.EGRESS_BW = 0;
+
+		EmulNet net(&par);
+		net.ENinit(&from, par.PORTNUM);
+		net.ENinit(&to, par.PORTNUM);
+		receivedBytes = 0;
+		double start = benchNow();
+		while ( receivedBytes < total ) {
+			while ( sent < total && net.ENsend(&from, &to, (char *)value.data(), size, CLIENT_CLASS) == size ) {
+				sent += size;
+			}
+			net.ENrecv(&to, countBytes, NULL, 1, NULL);
+			par.globaltime++;
+		}
+		double elapsed = benchNow() - start;
+		net.ENcleanup();
+		printf("%9d %9.0f %22.0f\n", size, receivedBytes / elapsed / (1 << 20), receivedBytes / 1024.0 / par.globaltime);
+	}
+	return 0;
+}
@@ -0,0 +1,73 @@
+/**********************************
+ * FILE NAME: HashTableBench.cpp
+ *
+ * DESCRIPTION: ns per create, read, update and delete of HashTable, on
+ * 				FlatHashMap, against the same operations on a std::map as
+ * 				HashTable used to hold. The keys are shuffled for every phase
+ * 				after create.
+ *
+ * 				bench/HashTableBench [keys ...]
+ **********************************/
+
+#include "HashTable.h"
+#include "bench/BenchUtil.h"
+
+/*
+ * Macros
+ */
+#define VALUE_BYTES 16
+
+/*
+ * Runs op on every key and returns the ns it took per key
+ */
+template <class Op>
+static double perKey(vector<string> &keys, mt19937 &rng, Op op) {
+	shuffle(keys.begin(), keys.end(), rng);
+	double start = benchNow();
+	for ( const string &key : keys ) {
+		op(key);
+	}
+	return (benchNow() - start) * 1e9 / keys.size();
+}
+
+static void mapPhases(vector<string> &keys, mt19937 &rng, double *ns) {
+	map<string, string> table;
+	string value(VALUE_BYTES, 'v');
+
+	ns[0] = perKey(keys, rng, [&](const string &key) { table.emplace(key, value); });
+	ns[1] = perKey(keys, rng, [&](const string &key) { benchSink += table.find(key)->second.size(); });
+	ns[2] = perKey(keys, rng, [&](const string &key) { table.find(key)->second = value; });
+	ns[3] = perKey(keys, rng, [&](const string &key) { table.erase(key); });
+}
+
+static void flatPhases(vector<string> &keys, mt19937 &rng, double *ns) {
+	HashTable table;
+	string value(VALUE_BYTES, 'v');
+
+	ns[0] = perKey(keys, rng, [&](const string &key) { table.create(key, string(value)); });
+	ns[1] = perKey(keys, rng, [&](const string &key) { benchSink += table.read(key).size(); });
+	ns[2] = perKey(keys, rng, [&](const string &key) { table.update(key, value); });
+	ns[3] = perKey(keys, rng, [&](const string &key) { table.deleteKey(key); });
+}
+
+int main(int argc, char *argv[]) {
+	vector<long> counts;
+	mt19937 rng(1);
+	double ns[2][4];
+
+	for ( int i = 1; i < argc; i++ ) {
+		counts.push_back(strtol(argv[i], NULL, 10));
+	}
+	if ( counts.empty() ) {
+		counts = {1000, 1000000};
+	}
+	printf("ns per op      map create/read/update/delete      flat create/read/update/delete\n");
+	for ( long count : counts ) {
+		vector<string> keys = benchKeys(count, rng);
+		mapPhases(keys, rng, ns[0]);
+		flatPhases(keys, rng, ns[1]);
+		printf("%9ld   %6.0f / %4.0f / %4.0f / %4.0f        %6.0f / %4.0f / %4.0f / %4.0f\n", count,
+				ns[0][0], ns[0][1], ns[0][2], ns[0][3], ns[1][0], ns[1][1], ns[1][2], ns[1][3]);
+	}
+	return 0;
+}
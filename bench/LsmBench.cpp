@@ -0,0 +1,84 @@
+/**********************************
+ * FILE NAME: LsmBench.cpp
+ *
+ * DESCRIPTION: Point writes and reads of a dataset many times the memtable, kept
+ * 				in memory by ConcurrentHashTable and on disk by LsmTable: creates,
+ * 				updates and reads of random keys, and reads of absent keys
+ *
+ * 				bench/LsmBench [keys] [directory]
+ **********************************/
+
+#include "ConcurrentHashTable.h"
+#include "LsmTable.h"
+#include "bench/BenchUtil.h"
+
+/*
+ * Macros
+ */
+#define VALUE_BYTES 100
+
+/*
+ * Runs op on every key and returns the keys done per second
+ */
+template <class Op>
+static double perSecond(vector<string> &keys, mt19937 &rng, Op op) {
+	shuffle(keys.begin(), keys.end(), rng);
+	double start = benchNow();
+	for ( const string &key : keys ) {
+		op(key);
+	}
+	return keys.size() / (benchNow() - start);
+}
+
+/*
+ * Prints the rates of every phase on table
+ */
+static void phases(const char *name, StorageEngine *table, vector<string> &keys, mt19937 &rng) {
+	vector<string> absent;
+	string value(VALUE_BYTES, 'v'), read;
+	double rates[4];
+
+	for ( const string &key : keys ) {
+		absent.push_back(key + "-absent");
+	}
+	rates[0] = perSecond(keys, rng, [&](const string &key) { table->create(key, string(value)); });
+	value.assign(VALUE_BYTES, 'u');
+	rates[1] = perSecond(keys, rng, [&](const string &key) { table->update(key, value); });
+	rates[2] = perSecond(keys, rng, [&](const string &key) { benchSink += table->read(key, read); });
+	rates[3] = perSecond(absent, rng, [&](const string &key) { benchSink += table->read(key, read); });
+	printf("  %-5s creates %7.0fk/s  updates %7.0fk/s  reads %7.0fk/s  misses %7.0fk/s\n", name,
+			rates[0] / 1e3, rates[1] / 1e3, rates[2] / 1e3, rates[3] / 1e3);
+}
+
+int main(int argc, char *argv[]) {
+	long count = benchArg(argc, argv, 1, 400000);
+	char temp[] = "/tmp/lsmbench.XXXXXX";
+	string dir = argc > 2 ? argv[2] : mkdtemp(temp);
+	mt19937 rng(1);
+	vector<string> keys = benchKeys(count, rng);
+	long userBytes = 0;
+
+	for ( const string &key : keys ) {
+		userBytes += 2 * (key.size() + VALUE_BYTES);
+	}
+	printf("%ld keys of %d byte values, %.1fx the %d MB memtable\n", count, VALUE_BYTES,
+			userBytes / 2.0 / LSM_MEMTABLE_BYTES, LSM_MEMTABLE_BYTES >> 20);
+
+	ConcurrentHashTable *hash = new ConcurrentHashTable();
+	phases("hash", hash, keys, rng);
+	delete hash;
+
+	LsmTable *lsm = new LsmTable(dir + "/bench.lsm");
+	lsm->clear();
+	phases("lsm", lsm, keys, rng);
+	lsm->flush();
+	LsmStats stats = lsm->getStats();
+	printf("  lsm: %ld flushes, %ld compactions, %ld stalls, write amplification %.1f\n",
+			stats.flushes, stats.compactions, stats.stalls, (double)stats.bytesWritten / userBytes);
+	delete lsm;
+
+	if ( argc < 3 ) {
+		benchSink += system(("rm -rf " + dir).c_str());
+	}
+	return 0;
+}
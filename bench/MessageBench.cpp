@@ -0,0 +1,65 @@
+/**********************************
+ * FILE NAME: MessageBench.cpp
+ *
+ * DESCRIPTION: ns per encode and per parse of each type of message, and its bytes
+ * 				on the wire, in the "::" text format of Message::toString and in
+ * 				the binary one of Message::encode. Both are parsed by
+ * 				MessageView::parse, which tells them apart by the first byte
+ * 				and hands the binary ones to decode.
+ *
+ * 				bench/MessageBench [iterations]
+ **********************************/
+
+#include "Message.h"
+#include "MessageView.h"
+#include "bench/BenchUtil.h"
+
+/*
+ * Macros
+ */
+#define KEY_BYTES 8
+#define VALUE_BYTES 100
+
+/*
+ * ns per call of op over iterations calls
+ */
+template <class Op>
+static double perCall(long iterations, Op op) {
+	double start = benchNow();
+	for ( long i = 0; i < iterations; i++ ) {
+		op();
+	}
+	return (benchNow() - start) * 1e9 / iterations;
+}
+
+static void row(const char *name, Message &msg, long iterations) {
+	MessageView view;
+	string text = msg.toString();
+	string binary = msg.encode();
+
+	double textEncode = perCall(iterations, [&]() { benchSink += msg.toString().size(); });
+	double binaryEncode = perCall(iterations, [&]() { benchSink += msg.encode().size(); });
+	double textParse = perCall(iterations, [&]() { benchSink += view.parse(text.data(), text.size()); });
+	double binaryParse = perCall(iterations, [&]() { benchSink += view.parse(binary.data(), binary.size()); });
+	printf("  %-9s %8.0f %8.0f %8.0f %8.0f %7zu %6zu\n", name, textEncode, binaryEncode, textParse, binaryParse,
+			text.size(), binary.size());
+}
+
+int main(int argc, char *argv[]) {
+	long iterations = benchArg(argc, argv, 1, 1000000);
+	Address from("12:8001");
+	string key(KEY_BYTES, 'k');
+	string value(VALUE_BYTES, 'v');
+	Message create(1234567, from, CREATE, key, value, SECONDARY);
+	Message read(1234567, from, READ, key);
+	Message reply(1234567, from, REPLY, true);
+	Message readReply(1234567, from, value);
+
+	printf("%d byte key, %d byte value, %ld iterations, ns per op\n", KEY_BYTES, VALUE_BYTES, iterations);
+	printf("  type      text enc  bin enc text dec  bin dec  text B  bin B\n");
+	row("CREATE", create, iterations);
+	row("READ", read, iterations);
+	row("REPLY", reply, iterations);
+	row("READREPLY", readReply, iterations);
+	return 0;
+}
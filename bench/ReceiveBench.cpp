@@ -0,0 +1,141 @@
+/**********************************
+ * FILE NAME: ReceiveBench.cpp
+ *
+ * DESCRIPTION: Cost of the receive path of a node. First the ns and heap
+ * 				allocations of parsing each type of message, into a Message
+ * 				allocated with new as the old path did and into a MessageView
+ * 				on the stack. Then the allocations per message a node makes
+ * 				receiving and handling creates, reads, updates and deletes sent
+ * 				by a client over EmulNet, replies included, counted over
+ * 				MP2Node::recvLoop and checkMessages once the first ticks have
+ * 				grown every buffer that is kept.
+ *
+ * 				bench/ReceiveBench [messages per tick] [ticks]
+ **********************************/
+
+#include "MP2Node.h"
+#include "bench/BenchUtil.h"
+#include <new>
+
+/*
+ * Macros
+ */
+#define PARSES 1000000
+#define WARMUP_TICKS 20
+
+static long allocations;
+
+void *operator new(size_t size) {
+	allocations++;
+	void *p = malloc(size ? size : 1);
+	if ( NULL == p ) {
+		throw bad_alloc();
+	}
+	return p;
+}
+
+void operator delete(void *p) noexcept {
+	free(p);
+}
+
+void operator delete(void *p, size_t size) noexcept {
+	free(p);
+}
+
+static const char *typeNames[] = {"CREATE", "READ", "UPDATE", "DELETE", "REPLY", "READREPLY"};
+
+/*
+ * Drops whatever the client receives
+ */
+static int dropMessage(void *env, char *buff, int size, MsgBuffer *buf, char *tag, int tagSize) {
+	if ( NULL != buf ) {
+		buf->release();
+	}
+	else {
+		free(buff);
+	}
+	return 0;
+}
+
+/*
+ * Prints the ns and allocations per parse of msg both ways
+ */
+static void parseCost(Message &msg) {
+	string data = msg.encode();
+	MessageView view;
+	long before = allocations;
+
+	double start = benchNow();
+	for ( long i = 0; i < PARSES; i++ ) {
+		Message *parsed = new Message(data.data(), (int)data.size());
+		benchSink += parsed->transID;
+		delete parsed;
+	}
+	double messageTime = (benchNow() - start) * 1e9 / PARSES;
+	double messageAllocs = (double)(allocations - before) / PARSES;
+
+	before = allocations;
+	start = benchNow();
+	for ( long i = 0; i < PARSES; i++ ) {
+		benchSink += view.parse(data.data(), data.size());
+	}
+	double viewTime = (benchNow() - start) * 1e9 / PARSES;
+	printf("  %-9s %5.0f ns / %.2f allocs  ->  %5.0f ns / %.2f allocs\n", typeNames[msg.type], messageTime, messageAllocs,
+			viewTime, (double)(allocations - before) / PARSES);
+}
+
+int main(int argc, char *argv[]) {
+	int perTick = (int)benchArg(argc, argv, 1, 4);
+	int ticks = (int)benchArg(argc, argv, 2, 1000);
+	static const MessageType types[] = {CREATE, READ, UPDATE, DELETE};
+	Address client, server;
+	string key(8, 'k'), value(100, 'v');
+
+	printf("Parse cost per message, Message with new -> MessageView on the stack\n");
+	Message create(1, client, CREATE, key, value, PRIMARY);
+	Message read(1, client, READ, key);
+	Message del(1, client, DELETE, key);
+	Message reply(1, client, REPLY, true);
+	Message readReply(1, client, value);
+	parseCost(create);
+	parseCost(read);
+	parseCost(del);
+	parseCost(reply);
+	parseCost(readReply);
+
+	Params par;
+	par.EN_GPSZ = 2;
+	par.MAX_MSG_SIZE = 4000;
+	par.globaltime = 0;
+	EmulNet net(&par);
+	Log log(&par);
+	net.ENinit(&client, par.PORTNUM);
+	net.ENinit(&server, par.PORTNUM);
+	// The node deletes its member when done
+	MP2Node node(new Member, &par, &net, &log, &server);
+
+	printf("Allocations per message handled, %d messages per tick, %d ticks\n", perTick, ticks);
+	for ( MessageType type : types ) {
+		long counted = 0, messages = 0;
+		for ( int t = 0; t < WARMUP_TICKS + ticks; t++ ) {
+			for ( int m = 0; m < perTick; m++ ) {
+				// Every create and delete has a key of its own, reads and updates find one
+				string name = "key" + to_string(t * perTick + m);
+				Message msg = CREATE == type || UPDATE == type ? Message(t, client, type, name, value, PRIMARY) : Message(t, client, type, name);
+				msg.success = false;
+				net.ENsend(&client, &server, msg.encode(), CLIENT_CLASS);
+			}
+			par.globaltime++;
+			long before = allocations;
+			node.recvLoop();
+			node.checkMessages();
+			if ( t >= WARMUP_TICKS ) {
+				counted += allocations - before;
+				messages += perTick;
+			}
+			net.ENrecv(&client, dropMessage, NULL, 1, NULL);
+		}
+		printf("  %-9s %.2f\n", typeNames[type], (double)counted / messages);
+	}
+	return 0;
+}
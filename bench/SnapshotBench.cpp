@@ -0,0 +1,124 @@
+/**********************************
+ * FILE NAME: SnapshotBench.cpp
+ *
+ * DESCRIPTION: Write throughput and latency of ConcurrentHashTable while a scan
+ * 				of the whole table runs now and then. WRITERS threads update
+ * 				random keys or delete and create them again. Every SCAN_EVERY_MS
+ * 				the whole table is scanned, by forEach, which holds the lock of
+ * 				each shard while visiting it, or through a snapshot, which holds
+ * 				none. The scan sleeps SCAN_PAUSE_US every SCAN_BATCH keys, as a
+ * 				node streaming the keys out would wait on I/O.
+ *
+ * 				bench/SnapshotBench [keys] [seconds per mode]
+ **********************************/
+
+#include "ConcurrentHashTable.h"
+#include "bench/BenchUtil.h"
+#include <atomic>
+#include <thread>
+
+/*
+ * Macros
+ */
+#define WRITERS 4
+#define VALUE_BYTES 100
+#define SCAN_EVERY_MS 250
+#define SCAN_BATCH 256
+#define SCAN_PAUSE_US 100
+
+enum scanMODE { NO_SCAN, FOREACH_SCAN, SNAPSHOT_SCAN };
+
+/*
+ * Value at fraction q of the samples, in us
+ */
+static double percentile(vector<double> &samples, double q) {
+	size_t at = min(samples.size() - 1, (size_t)(q * samples.size()));
+	nth_element(samples.begin(), samples.begin() + at, samples.end());
+	return samples[at] * 1e6;
+}
+
+static void run(const char *name, int mode, ConcurrentHashTable &table, vector<string> &keys, double seconds) {
+	atomic<bool> done(false);
+	vector<thread> writers;
+	vector<double> latencies[WRITERS];
+	long scanned = 0;
+	double scanTime = 0;
+
+	for ( int w = 0; w < WRITERS; w++ ) {
+		writers.emplace_back([&, w]() {
+			mt19937 rng(w + 1);
+			string value(VALUE_BYTES, 'a' + w);
+			// Grown up front, a copy while timing would show as a slow write
+			latencies[w].reserve((size_t)(seconds * 2e6 / WRITERS));
+			while ( !done.load(memory_order_relaxed) ) {
+				const string &key = keys[rng() % keys.size()];
+				double start = benchNow();
+				if ( rng() % 2 ) {
+					table.update(key, value);
+				}
+				else if ( table.deleteKey(key) ) {
+					table.create(key, string(value));
+				}
+				latencies[w].push_back(benchNow() - start);
+			}
+		});
+	}
+	double start = benchNow();
+	while ( benchNow() - start < seconds ) {
+		this_thread::sleep_for(chrono::milliseconds(SCAN_EVERY_MS));
+		if ( NO_SCAN == mode ) {
+			continue;
+		}
+		long visited = 0;
+		function<void(const string &, const string &)> visit = [&](const string &key, const string &value) {
+			if ( ++visited % SCAN_BATCH == 0 ) {
+				this_thread::sleep_for(chrono::microseconds(SCAN_PAUSE_US));
+			}
+		};
+		double scanStart = benchNow();
+		if ( FOREACH_SCAN == mode ) {
+			table.forEach(visit);
+		}
+		else {
+			table.openSnapshot()->forEach(visit);
+		}
+		scanTime += benchNow() - scanStart;
+		scanned += visited;
+	}
+	done = true;
+	for ( thread &writer : writers ) {
+		writer.join();
+	}
+	double elapsed = benchNow() - start;
+
+	vector<double> all;
+	for ( int w = 0; w < WRITERS; w++ ) {
+		all.insert(all.end(), latencies[w].begin(), latencies[w].end());
+	}
+	long writes = all.size();
+	printf("  %-9s %7.2fM %8.1fus %8.1fus", name, writes / elapsed / 1e6, percentile(all, 0.99), percentile(all, 0.999));
+	if ( NO_SCAN == mode ) {
+		printf("        -\n");
+	}
+	else {
+		printf("   %6.2fM\n", scanned / scanTime / 1e6);
+	}
+}
+
+int main(int argc, char *argv[]) {
+	long count = benchArg(argc, argv, 1, 200000);
+	double seconds = benchArg(argc, argv, 2, 3);
+	mt19937 rng(1);
+	vector<string> keys = benchKeys(count, rng);
+	ConcurrentHashTable table;
+
+	for ( const string &key : keys ) {
+		table.create(key, string(VALUE_BYTES, 'v'));
+	}
+	printf("%ld keys, %d writers, %u cpus, a scan every %d ms\n", count, WRITERS, thread::hardware_concurrency(), SCAN_EVERY_MS);
+	printf("  scan via  writes/s       p99     p99.9  keys scanned/s\n");
+	run("none", NO_SCAN, table, keys, seconds);
+	run("forEach", FOREACH_SCAN, table, keys, seconds);
+	run("snapshot", SNAPSHOT_SCAN, table, keys, seconds);
+	return 0;
+}
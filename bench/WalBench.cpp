@@ -0,0 +1,100 @@
+/**********************************
+ * FILE NAME: WalBench.cpp
+ *
+ * DESCRIPTION: Changes per second the write-ahead log takes under each WAL_SYNC
+ * 				policy, committed in batches of COMMIT_CHANGES as a node commits
+ * 				once per tick, then the time to write a snapshot of a large
+ * 				table and to recover it with a log tail, whole and with the log
+ * 				damaged in the middle
+ *
+ * 				bench/WalBench [directory] [snapshot keys]
+ **********************************/
+
+#include "WriteAheadLog.h"
+#include "ConcurrentHashTable.h"
+#include "bench/BenchUtil.h"
+
+/*
+ * Macros
+ */
+#define COMMIT_CHANGES 200
+#define VALUE_BYTES 100
+
+/*
+ * Changes per second of changes updates under policy, in a log of its own
+ */
+static double changeRate(const string &dir, int policy, long changes, WalStats *stats) {
+	WriteAheadLog wal(dir, policy + 1, policy);
+	string value(VALUE_BYTES, 'v');
+
+	double start = benchNow();
+	for ( long i = 0; i < changes; i++ ) {
+		wal.update("key" + to_string(i % 100000), value);
+		if ( (i + 1) % COMMIT_CHANGES == 0 && wal.commit() != SUCCESS ) {
+			exit(1);
+		}
+	}
+	double elapsed = benchNow() - start;
+	*stats = wal.getStats();
+	return changes / elapsed;
+}
+
+int main(int argc, char *argv[]) {
+	char temp[] = "/tmp/walbench.XXXXXX";
+	string dir = argc > 1 ? argv[1] : mkdtemp(temp);
+	long keys = benchArg(argc, argv, 2, 1000000);
+	static const char *names[] = {"none", "group", "always"};
+	string value(VALUE_BYTES, 'v');
+	WalStats stats;
+
+	printf("%s, %d changes per commit\n", dir.c_str(), COMMIT_CHANGES);
+	for ( int policy = NO_SYNC; policy <= ALWAYS_SYNC; policy++ ) {
+		long changes = ALWAYS_SYNC == policy ? 20000 : 1000000;
+		double rate = changeRate(dir, policy, changes, &stats);
+		printf("    WAL_SYNC %-7s %12.0f changes/s  %ld fdatasync for %ld changes\n", names[policy], rate, stats.syncs, changes);
+	}
+
+	ConcurrentHashTable table, recovered, damaged;
+	WriteAheadLog *wal = new WriteAheadLog(dir, 0, GROUP_SYNC);
+	for ( long i = 0; i < keys; i++ ) {
+		table.create("key" + to_string(i), string(value));
+	}
+	double start = benchNow();
+	if ( wal->checkpoint(&table) != SUCCESS ) {
+		exit(1);
+	}
+	printf("Snapshot of %ld keys written in %.2f s\n", keys, benchNow() - start);
+	for ( long i = 0; i < keys / 10; i++ ) {
+		wal->update("key" + to_string(i), value);
+		if ( (i + 1) % COMMIT_CHANGES == 0 ) {
+			wal->commit();
+		}
+	}
+	wal->commit();
+	delete wal;
+
+	wal = new WriteAheadLog(dir, 0, GROUP_SYNC);
+	start = benchNow();
+	long records = wal->recover(&recovered);
+	printf("Recovered %lu keys from %ld records, snapshot included, in %.2f s\n", recovered.currentSize(), records, benchNow() - start);
+	delete wal;
+
+	// Flip a byte halfway through the log, the records after it are cut off
+	string walPath = dir + "/node0.wal";
+	FILE *file = fopen(walPath.c_str(), "r+b");
+	fseek(file, 0, SEEK_END);
+	fseek(file, ftell(file) / 2, SEEK_SET);
+	int c = fgetc(file);
+	fseek(file, -1, SEEK_CUR);
+	fputc(c ^ 0xff, file);
+	fclose(file);
+	wal = new WriteAheadLog(dir, 0, GROUP_SYNC);
+	long kept = wal->recover(&damaged);
+	printf("With the log damaged halfway, %ld of %ld records applied\n", kept, records);
+	delete wal;
+
+	if ( argc < 2 ) {
+		system(("rm -rf " + dir).c_str());
+	}
+	return 0;
+}
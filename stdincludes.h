@@ -31,9 +31,13 @@
 #include <iostream>
 #include <vector>
 #include <map>
+#include <set>
+#include <unordered_map>
 #include <string>
+#include <string_view>
 #include <algorithm>
 #include <queue>
+#include <deque>
 #include <fstream>
 
 using namespace std;
@@ -0,0 +1,54 @@
+/**********************************
+ * FILE NAME: BoundedTableTest.cpp
+ *
+ * DESCRIPTION: Random operations on a BoundedTable several times larger than its
+ * 				budget checked against a std::map, through spills, page ins and
+ * 				rewrites of the spill file. Built with a small compaction
+ * 				threshold, see the Makefile.
+ **********************************/
+
+#include "BoundedTable.h"
+#include "tests/TestUtil.h"
+
+#define BUDGET (1 << 20)
+
+int main(int argc, char *argv[]) {
+	unsigned int seed = testSeed(argc, argv);
+	mt19937 rng(seed);
+	string dir = makeTempDir("boundedtest");
+	string path = dir + "/node.spill";
+	map<string, string> model;
+	BoundedTable *table = new BoundedTable(path, BUDGET);
+	size_t peak = 0;
+	CacheStats stats;
+	string value;
+
+	for ( int round = 0; round < 30; round++ ) {
+		runOps(table, model, rng, 4000, 3000, 2000);
+		// Reads of a few keys over and over, so the second list fills too
+		for ( int i = 0; i < 2000; i++ ) {
+			string key = "key" + to_string(rng() % 100);
+			CHECK(table->read(key, value) == (model.find(key) != model.end()));
+		}
+		peak = max(peak, table->memoryUsed());
+		CHECK(table->memoryUsed() <= BUDGET);
+		checkSame(table, model);
+	}
+	stats = table->getStats();
+	CHECK(stats.spills > 0);
+	CHECK(stats.misses > 0);
+	CHECK(stats.compactions > 0);
+
+	table->clear();
+	model.clear();
+	checkSame(table, model);
+	runOps(table, model, rng, 4000, 3000, 2000);
+	checkSame(table, model);
+
+	delete table;
+	// The spill file goes with the table
+	CHECK(access(path.c_str(), F_OK) != 0);
+	removeDir(dir);
+	printf("BoundedTableTest: ok (seed %u, peak %lu of %d bytes, %ld spills, %ld compactions)\n", seed, (unsigned long)peak, BUDGET, stats.spills, stats.compactions);
+	return 0;
+}
@@ -0,0 +1,83 @@
+/**********************************
+ * FILE NAME: CountingBloomFilterTest.cpp
+ *
+ * DESCRIPTION: Checks that a CountingBloomFilter never rules out a key it holds,
+ * 				through inserts, erases and saturated counters, and measures the
+ * 				share of absent keys it lets through against the expected one
+ **********************************/
+
+#include "CountingBloomFilter.h"
+#include "tests/TestUtil.h"
+
+// A power of two, so the counters are not rounded up and the filter is as full
+// as it ever gets before it is resized
+#define KEYS (1 << 17)
+#define PROBES 1000000
+
+/*
+ * Share of PROBES keys never added that filter lets through
+ */
+static double measuredRate(CountingBloomFilter &filter) {
+	long through = 0;
+
+	for ( int i = 0; i < PROBES; i++ ) {
+		if ( filter.mayContain("absent" + to_string(i)) ) {
+			through++;
+		}
+	}
+	return (double)through / PROBES;
+}
+
+int main(int argc, char *argv[]) {
+	unsigned int seed = testSeed(argc, argv);
+	mt19937 rng(seed);
+	int perKey[] = {4, 8, 16};
+
+	for ( unsigned int n = 0; n < sizeof(perKey) / sizeof(perKey[0]); n++ ) {
+		CountingBloomFilter filter(perKey[n], KEYS);
+		set<int> held;
+
+		// Full, then three quarters full after erasing random keys
+		for ( int i = 0; i < KEYS; i++ ) {
+			filter.insert("key" + to_string(i));
+			held.insert(i);
+		}
+		CHECK(!filter.full());
+		double full = measuredRate(filter);
+		double expected = filter.falsePositiveRate();
+		CHECK(full < 1.5 * expected + 0.001);
+		while ( held.size() > KEYS * 3 / 4 ) {
+			int i = rng() % KEYS;
+			if ( held.erase(i) ) {
+				filter.erase("key" + to_string(i));
+			}
+		}
+		for ( set<int>::iterator it = held.begin(); it != held.end(); it++ ) {
+			CHECK(filter.mayContain("key" + to_string(*it)));
+		}
+		CHECK(filter.size() == held.size());
+		printf("CountingBloomFilterTest: %2d counters per key, %.2f%% of absent keys through when full (%.2f%% expected), %.2f%% at three quarters\n",
+				perKey[n], 100 * full, 100 * expected, 100 * measuredRate(filter));
+	}
+
+	// A key added many times saturates its counters, erasing other keys
+	// sharing them must not make it look absent
+	CountingBloomFilter small(1, 1);
+	for ( int i = 0; i < 40; i++ ) {
+		small.insert("hot");
+	}
+	for ( int i = 0; i < 4000; i++ ) {
+		small.insert("key" + to_string(i));
+	}
+	for ( int i = 0; i < 4000; i++ ) {
+		small.erase("key" + to_string(i));
+	}
+	CHECK(small.mayContain("hot"));
+
+	// Sized for more keys, it starts empty
+	small.reset(4 * KEYS);
+	CHECK(0 == small.size() && !small.mayContain("hot"));
+
+	printf("CountingBloomFilterTest: ok (seed %u)\n", seed);
+	return 0;
+}
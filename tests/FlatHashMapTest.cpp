@@ -0,0 +1,154 @@
+/**********************************
+ * FILE NAME: FlatHashMapTest.cpp
+ *
+ * DESCRIPTION: Checks FlatHashMap against std::map through random inserts,
+ * 				lookups, updates and erases, across the rehashes they cause.
+ * 				Built a second time with a small FLAT_MAX_DIST, so that the
+ * 				map also grows because a probe got too long, not only because
+ * 				it got full.
+ **********************************/
+
+#include "FlatHashMap.h"
+#include "tests/TestUtil.h"
+
+/*
+ * Checks that map holds exactly the keys and values of model, each visited once
+ */
+static void checkMap(FlatHashMap<string> &map, std::map<string, string> &model) {
+	std::map<string, string> seen;
+
+	CHECK(map.size() == model.size() && map.empty() == model.empty());
+	for ( FlatHashMap<string>::iterator it = map.begin(); it != map.end(); it++ ) {
+		CHECK(seen.find(it->first) == seen.end());
+		seen[it->first] = it->second;
+	}
+	CHECK(seen == model);
+	for ( std::map<string, string>::iterator it = model.begin(); it != model.end(); it++ ) {
+		FlatHashMap<string>::iterator found = map.find(it->first);
+		CHECK(found != map.end() && found->first == it->first && found->second == it->second);
+		CHECK(1 == map.count(it->first));
+	}
+	// Grown by load or by a probe too long, never fuller than the load allows
+	CHECK(map.size() * FLAT_LOAD_DEN <= map.bucket_count() * FLAT_LOAD_NUM);
+	CHECK(0 == (map.bucket_count() & (map.bucket_count() - 1)));
+}
+
+/*
+ * Key number n, the empty key and keys with zero bytes among them
+ */
+static string keyOf(int n) {
+	if ( 0 == n ) {
+		return string();
+	}
+	if ( n % 7 == 0 ) {
+		return string("k\0", 2) + to_string(n);
+	}
+	return "key" + to_string(n);
+}
+
+static void randomOps(mt19937 &rng, int ops, int keys) {
+	FlatHashMap<string> map;
+	std::map<string, string> model;
+
+	for ( int i = 0; i < ops; i++ ) {
+		string key = keyOf(rng() % keys);
+		std::map<string, string>::iterator it = model.find(key);
+		bool present = it != model.end();
+		string value = to_string(rng());
+		FlatHashMap<string>::iterator found;
+
+		switch ( rng() % 6 ) {
+			case 0: {
+				pair<FlatHashMap<string>::iterator, bool> ret = map.try_emplace(key, string(value));
+				CHECK(ret.second == !present && ret.first->first == key);
+				CHECK(ret.first->second == (present ? it->second : value));
+				model.emplace(key, value);
+				break;
+			}
+			case 1:
+				map[key] = value;
+				model[key] = value;
+				break;
+			case 2:
+				found = map.find(key);
+				CHECK((found != map.end()) == present);
+				if ( present ) {
+					CHECK(found->second == it->second);
+					found->second = value;
+					it->second = value;
+				}
+				break;
+			case 3:
+				CHECK(map.erase(key) == (present ? 1u : 0u));
+				model.erase(key);
+				break;
+			case 4:
+				// Erased where it was found
+				found = map.find(key);
+				if ( found != map.end() ) {
+					map.erase(found);
+				}
+				model.erase(key);
+				break;
+			case 5:
+				CHECK(map.count(key) == (present ? 1u : 0u));
+				break;
+		}
+		if ( i % 1000 == 0 ) {
+			checkMap(map, model);
+		}
+		if ( rng() % (ops / 4) == 0 ) {
+			map.clear();
+			model.clear();
+		}
+	}
+	checkMap(map, model);
+}
+
+/*
+ * A map grown to count keys, one by one or after reserve, then emptied by erases
+ */
+static void growAndShrink(mt19937 &rng, int count, bool reserve) {
+	FlatHashMap<string> map;
+	std::map<string, string> model;
+	vector<int> order(count);
+	size_t slots;
+
+	if ( reserve ) {
+		map.reserve(count);
+	}
+	slots = map.bucket_count();
+	for ( int i = 0; i < count; i++ ) {
+		string key = keyOf(i);
+		map.try_emplace(key, to_string(i));
+		model.emplace(key, to_string(i));
+		order[i] = i;
+	}
+	checkMap(map, model);
+	// Only a probe too long may grow a map given room for every key
+	CHECK(!reserve || FLAT_MAX_DIST < 255 || map.bucket_count() == slots);
+
+	shuffle(order.begin(), order.end(), rng);
+	for ( int i = 0; i < count; i++ ) {
+		string key = keyOf(order[i]);
+		CHECK(1 == map.erase(key));
+		CHECK(0 == map.erase(key));
+		model.erase(key);
+		if ( i % 9973 == 0 ) {
+			checkMap(map, model);
+		}
+	}
+	checkMap(map, model);
+}
+
+int main(int argc, char *argv[]) {
+	unsigned int seed = testSeed(argc, argv);
+	mt19937 rng(seed);
+
+	randomOps(rng, 200000, 50);
+	randomOps(rng, 200000, 5000);
+	growAndShrink(rng, 100000, false);
+	growAndShrink(rng, 100000, true);
+	printf("FlatHashMapTest: ok (seed %u, FLAT_MAX_DIST %d)\n", seed, FLAT_MAX_DIST);
+	return 0;
+}
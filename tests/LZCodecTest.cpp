@@ -0,0 +1,188 @@
+/**********************************
+ * FILE NAME: LZCodecTest.cpp
+ *
+ * DESCRIPTION: Round trips of random and compressible inputs through LZCodec,
+ * 				with and without the dictionary, and checks that decompress
+ * 				rejects input that is cut short, malformed or damaged without
+ * 				writing past its output
+ **********************************/
+
+#include "LZCodec.h"
+#include "tests/TestUtil.h"
+
+/*
+ * Macros
+ */
+// Bytes after the output decompress must leave alone
+#define GUARD_BYTES 64
+#define GUARD 0x5a
+
+/*
+ * Compresses in with codec and checks that decompressing gives it back, in an
+ * output of exactly its size. Returns the compressed bytes.
+ */
+static string roundTrip(LZCodec &codec, const string &in, bool useDict) {
+	string zip(LZCodec::bound(in.size()), '\0');
+	string out(in.size() + 1, '\0');
+	int bytes = codec.compress(in.data(), in.size(), &zip[0], zip.size(), useDict);
+
+	CHECK(bytes > 0 && bytes <= LZCodec::bound(in.size()));
+	zip.resize(bytes);
+	CHECK(codec.decompress(zip.data(), zip.size(), &out[0], in.size(), useDict) == (int)in.size());
+	CHECK(0 == memcmp(out.data(), in.data(), in.size()));
+	// One byte short of room is not enough
+	if ( !in.empty() ) {
+		CHECK(-1 == codec.decompress(zip.data(), zip.size(), &out[0], in.size() - 1, useDict));
+	}
+	return zip;
+}
+
+/*
+ * Decompresses in into cap bytes followed by a guard, checking that the guard is
+ * untouched and the result is -1 or within cap
+ */
+static int decompressGuarded(LZCodec &codec, const string &in, int cap, bool useDict) {
+	string out(cap + GUARD_BYTES, (char)GUARD);
+	int bytes = codec.decompress(in.data(), in.size(), &out[0], cap, useDict);
+
+	CHECK(-1 == bytes || (bytes >= 0 && bytes <= cap));
+	for ( int i = cap; i < cap + GUARD_BYTES; i++ ) {
+		CHECK((char)GUARD == out[i]);
+	}
+	return bytes;
+}
+
+/*
+ * A run of messages like the ones the KV store sends, which repeat themselves
+ */
+static string kvTraffic(mt19937 &rng, int count) {
+	string text;
+
+	for ( int i = 0; i < count; i++ ) {
+		int node = rng() % 10 + 1;
+		int transID = rng() % 1000;
+		int key = rng() % 100;
+		int replica = rng() % 3;
+		text += to_string(node) + ".0.0.0:0::" + to_string(transID) + "::CREATE::key" + to_string(key)
+				+ "::value" + to_string(key) + "::0::" + to_string(replica) + "\n";
+	}
+	return text;
+}
+
+static void randomInput(LZCodec &codec, mt19937 &rng, int rounds) {
+	static const int sizes[] = {0, 1, 3, 4, 5, 15, 16, 300, 4096, 70000};
+
+	for ( int i = 0; i < rounds; i++ ) {
+		string in = randomBytes(rng, 0, sizes[rng() % 10]);
+		if ( rng() % 4 == 0 ) {
+			in.clear();
+		}
+		// Random bytes do not compress, but must not grow past the bound
+		roundTrip(codec, in, rng() % 2);
+	}
+}
+
+/*
+ * Returns how small compressible input gets, as a share of its size
+ */
+static double compressible(LZCodec &codec, mt19937 &rng, int rounds) {
+	long raw = 0, zipped = 0;
+
+	for ( int i = 0; i < rounds; i++ ) {
+		string in = kvTraffic(rng, 1 + rng() % 200);
+		// Runs, and matches overlapping what they copy
+		if ( rng() % 3 == 0 ) {
+			in += string(rng() % 1000, 'x');
+			in += in.substr(0, rng() % in.size());
+		}
+		bool useDict = rng() % 2;
+		string zip = roundTrip(codec, in, useDict);
+		raw += in.size();
+		zipped += zip.size();
+	}
+	CHECK(zipped * 2 < raw);
+	return (double)zipped / raw;
+}
+
+/*
+ * A short message is found whole in a dictionary that holds it, and needs that
+ * dictionary to come back
+ */
+static void dictionary(mt19937 &rng) {
+	LZCodec codec;
+	vector<string> samples;
+	string message = "3.0.0.0:0::17::CREATE::key42::value42::0::1\n";
+	string trained, with, without;
+
+	// Substrings are only worth a place when more than one sample has them
+	for ( int i = 0; i < 50; i++ ) {
+		samples.push_back(kvTraffic(rng, 1));
+	}
+	trained = LZCodec::train(samples, LZ_DICT_SIZE);
+	CHECK(!trained.empty() && trained.size() <= LZ_DICT_SIZE);
+	codec.setDictionary(trained);
+	for ( int i = 0; i < 100; i++ ) {
+		roundTrip(codec, kvTraffic(rng, 1 + rng() % 3), true);
+	}
+
+	codec.setDictionary("0123456789" + message + "abcdefghij");
+	with = roundTrip(codec, message, true);
+	without = roundTrip(codec, message, false);
+	CHECK(with.size() * 4 < without.size());
+	CHECK(decompressGuarded(codec, with, message.size(), false) != (int)message.size());
+
+	// A codec with another dictionary cannot read it
+	LZCodec other;
+	other.setDictionary(string(message.size() + 20, '#'));
+	string out(message.size(), '\0');
+	int bytes = other.decompress(with.data(), with.size(), &out[0], out.size(), true);
+	CHECK(bytes != (int)message.size() || out != message);
+}
+
+static void corrupt(LZCodec &codec, mt19937 &rng, int rounds) {
+	// Offset 0, reaching before the output, literals past the end, an offset
+	// or a length extension cut short
+	static const string bad[] = {
+		string("\x00\x00\x00", 3), string("\x10" "a" "\x05\x00", 4), string("\x50" "ab", 3),
+		string("\x10" "a" "\x01", 3), string("\x1f" "a" "\x01\x00", 4), string("\xf0", 1),
+		string("\xf0\xff\xff", 3), string("\x1f" "a" "\x01\x00\xff", 5)
+	};
+
+	for ( const string &in : bad ) {
+		CHECK(-1 == decompressGuarded(codec, in, 1024, false));
+	}
+	// Reaches 4 bytes back, into the dictionary only if one is used
+	CHECK(5 == decompressGuarded(codec, bad[1], 1024, true));
+
+	for ( int i = 0; i < rounds; i++ ) {
+		string in = rng() % 2 ? kvTraffic(rng, 1 + rng() % 50) : randomBytes(rng, 1, 2000);
+		bool useDict = rng() % 2;
+		string zip = roundTrip(codec, in, useDict);
+
+		// Cut short, past the token that may end it with no literals, it comes
+		// back shorter or not at all
+		for ( int cut = 0; cut + 1 < (int)zip.size(); cut += 1 + rng() % 8 ) {
+			CHECK(decompressGuarded(codec, zip.substr(0, cut), in.size(), useDict) != (int)in.size());
+		}
+		// Damaged bytes may decode to anything, but within the output
+		for ( int j = 0; j < 8; j++ ) {
+			string damaged = zip;
+			damaged[rng() % damaged.size()] ^= 1 << (rng() % 8);
+			decompressGuarded(codec, damaged, in.size(), useDict);
+		}
+		decompressGuarded(codec, randomBytes(rng, 1, 300), 4096, useDict);
+	}
+}
+
+int main(int argc, char *argv[]) {
+	unsigned int seed = testSeed(argc, argv);
+	mt19937 rng(seed);
+	LZCodec codec;
+
+	randomInput(codec, rng, 2000);
+	double ratio = compressible(codec, rng, 2000);
+	dictionary(rng);
+	corrupt(codec, rng, 2000);
+	printf("LZCodecTest: ok (seed %u, compressible input to %.1f%%)\n", seed, 100 * ratio);
+	return 0;
+}
@@ -0,0 +1,121 @@
+/**********************************
+ * FILE NAME: LsmTableTest.cpp
+ *
+ * DESCRIPTION: Random operations on an LsmTable checked against a std::map, across
+ * 				flushes, compactions into deeper levels, reopening and clear.
+ * 				Built with shrunken sizes, see the Makefile.
+ **********************************/
+
+#include "LsmTable.h"
+#include "tests/TestUtil.h"
+#include <thread>
+#include <atomic>
+
+/*
+ * Waits for the background thread to have done at least compactions merges
+ */
+static LsmStats waitCompactions(LsmTable *table, long compactions) {
+	LsmStats stats = table->getStats();
+	for ( int i = 0; i < 500 && stats.compactions < compactions; i++ ) {
+		usleep(10000);
+		stats = table->getStats();
+	}
+	return stats;
+}
+
+/*
+ * Readers going on while one writer rewrites every key with values that name it,
+ * through flushes and compactions. Run it under -fsanitize=thread as well.
+ */
+static void concurrentReads(LsmTable *table) {
+	atomic<bool> done(false);
+	vector<thread> readers;
+
+	for ( int k = 0; k < 2000; k++ ) {
+		string key = "ckey" + to_string(k);
+		CHECK(table->create(key, key + ":0:" + string(100, 'x')));
+	}
+	for ( int r = 0; r < 3; r++ ) {
+		readers.push_back(thread([&done, table, r]() {
+			mt19937 rng(r);
+			string value;
+			while ( !done ) {
+				string key = "ckey" + to_string(rng() % 2000);
+				CHECK(table->read(key, value));
+				CHECK(value.compare(0, key.size() + 1, key + ":") == 0);
+			}
+		}));
+	}
+	for ( int round = 1; round <= 10; round++ ) {
+		for ( int k = 0; k < 2000; k++ ) {
+			string key = "ckey" + to_string(k);
+			CHECK(table->update(key, key + ":" + to_string(round) + ":" + string(100, 'x')));
+		}
+	}
+	done = true;
+	for ( unsigned int r = 0; r < readers.size(); r++ ) {
+		readers[r].join();
+	}
+	for ( int k = 0; k < 2000; k++ ) {
+		CHECK(table->deleteKey("ckey" + to_string(k)));
+	}
+}
+
+int main(int argc, char *argv[]) {
+	unsigned int seed = testSeed(argc, argv);
+	mt19937 rng(seed);
+	string dir = makeTempDir("lsmtest");
+	string path = dir + "/node.lsm";
+	map<string, string> model;
+	LsmTable *table = new LsmTable(path);
+	LsmStats stats;
+
+	// Writes fill memtables, flushes and merges go on behind them
+	for ( int round = 0; round < 40; round++ ) {
+		runOps(table, model, rng, 4000, 3000, 300);
+		if ( round % 3 == 0 ) {
+			CHECK(table->flush() == SUCCESS);
+		}
+		if ( round % 10 == 4 ) {
+			// Whatever was flushed or only in the memtable comes back
+			delete table;
+			table = new LsmTable(path);
+		}
+		checkSame(table, model);
+	}
+	stats = waitCompactions(table, 2);
+	CHECK(stats.flushes > LSM_L0_TABLES);
+	CHECK(stats.compactions >= 2);
+	checkSame(table, model);
+
+	concurrentReads(table);
+	checkSame(table, model);
+
+	// Deletes of every key leave nothing once merged down
+	for ( map<string, string>::iterator it = model.begin(); it != model.end(); it++ ) {
+		CHECK(table->deleteKey(it->first));
+	}
+	model.clear();
+	CHECK(table->flush() == SUCCESS);
+	checkSame(table, model);
+	delete table;
+	table = new LsmTable(path);
+	checkSame(table, model);
+
+	// clear drops the tables, and stays cleared across a reopen
+	runOps(table, model, rng, 5000, 1000, 100);
+	CHECK(table->flush() == SUCCESS);
+	table->clear();
+	model.clear();
+	checkSame(table, model);
+	delete table;
+	table = new LsmTable(path);
+	checkSame(table, model);
+	runOps(table, model, rng, 5000, 1000, 100);
+	checkSame(table, model);
+
+	delete table;
+	removeDir(dir);
+	printf("LsmTableTest: ok (seed %u, %ld flushes, %ld compactions)\n", seed, stats.flushes, stats.compactions);
+	return 0;
+}
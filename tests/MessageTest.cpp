@@ -0,0 +1,180 @@
+/**********************************
+ * FILE NAME: MessageTest.cpp
+ *
+ * DESCRIPTION: Round trips of random messages through the binary format of
+ * 				Message::encode and the text one of Message::toString,
+ * 				checking that every field comes back and that messages cut
+ * 				short are rejected
+ **********************************/
+
+#include "Message.h"
+#include "MessageView.h"
+#include "tests/TestUtil.h"
+
+/*
+ * A message of type with random fields, keys and values of any bytes
+ */
+static Message randomMessage(mt19937 &rng, MessageType type) {
+	// Sizes around the one and two byte varint limits too
+	static const int sizes[] = {0, 1, 2, 127, 128, 300, 16383, 16384};
+	Address from(to_string(rng() % 1000) + ":" + to_string(rng() % 30000));
+	int transID = (int)rng();
+	string key = randomBytes(rng, 0, sizes[rng() % 8]);
+	string value = randomBytes(rng, 0, sizes[rng() % 8]);
+
+	if ( rng() % 3 == 0 ) {
+		key.insert(0, "::");
+		value.append("::");
+	}
+	// Built where returned, copying a Message reads fields its constructor left unset
+	switch ( type ) {
+		case READ:
+		case DELETE:
+			return Message(transID, from, type, key);
+		case REPLY:
+			return Message(transID, from, REPLY, rng() % 2 == 0);
+		case READREPLY:
+			return Message(transID, from, value);
+		default:
+			break;
+	}
+	Message msg(transID, from, type, key, value, ReplicaType(rng() % 3));
+	msg.expiry = rng() % 2 ? 0 : (int)(rng() & 0x7fffffff);
+	msg.success = false;
+	return msg;
+}
+
+/*
+ * Checks that the fields of view are those of msg that go on the wire
+ */
+static void checkFields(MessageView &view, Message &msg) {
+	CHECK(view.type == msg.type);
+	CHECK(view.transID == msg.transID);
+	CHECK(view.fromAddr == msg.fromAddr);
+	switch ( msg.type ) {
+		case CREATE:
+		case UPDATE:
+			CHECK(view.key == msg.key);
+			CHECK(view.value == msg.value);
+			CHECK(view.expiry == msg.expiry);
+			CHECK(view.replica == msg.replica);
+			break;
+		case READ:
+		case DELETE:
+			CHECK(view.key == msg.key);
+			break;
+		case REPLY:
+			CHECK(view.success == msg.success);
+			break;
+		case READREPLY:
+			CHECK(view.value == msg.value);
+			break;
+	}
+}
+
+/*
+ * Binary round trips, with the replica type in the message, appended to it or
+ * given as the tag of a multicast, and every shorter prefix rejected
+ */
+static void binary(mt19937 &rng, int count) {
+	MessageView view;
+	string reply;
+
+	for ( int i = 0; i < count; i++ ) {
+		Message msg = randomMessage(rng, MessageType(rng() % 6));
+		string data = msg.encode();
+		bool tagged = msg.type == CREATE || msg.type == UPDATE;
+
+		CHECK(view.parse(data.data(), data.size()));
+		checkFields(view, msg);
+		Message copy(data.data(), (int)data.size());
+		CHECK(copy.encode() == data);
+
+		if ( tagged ) {
+			string bare = msg.encode(false);
+			char tag = (char)msg.replica;
+			CHECK(bare + tag == data);
+			CHECK(view.parse(bare.data(), bare.size(), string_view(&tag, 1)));
+			checkFields(view, msg);
+			// Without it, as in stabilization copies, the replica is the default
+			CHECK(view.parse(bare.data(), bare.size()) && PRIMARY == view.replica);
+			// Replica types past TERTIARY are rejected like unknown types
+			tag = (char)(TERTIARY + 1 + rng() % (255 - TERTIARY));
+			CHECK(!view.parse((bare + tag).data(), bare.size() + 1));
+			CHECK(!view.parse(bare.data(), bare.size(), string_view(&tag, 1)));
+			data = bare;
+		}
+		else if ( REPLY == msg.type ) {
+			Message::encodeReply(reply, msg.transID, msg.fromAddr, msg.success);
+			CHECK(reply == data);
+		}
+		else if ( READREPLY == msg.type ) {
+			Message::encodeReadReply(reply, msg.transID, msg.fromAddr, msg.value);
+			CHECK(reply == data);
+		}
+		for ( unsigned int cut = 0; cut < data.size(); cut += 1 + data.size() / 50 ) {
+			CHECK(!view.parse(data.data(), cut));
+		}
+		CHECK(!view.parse(data.data(), data.size() - 1));
+		data[1] = (char)(6 + rng() % 250);
+		CHECK(!view.parse(data.data(), data.size()));
+	}
+}
+
+/*
+ * Text round trips, through one view so that fields left over from the message
+ * before would show. Keys and values must not hold the delimiter there.
+ */
+static void text(mt19937 &rng, int count) {
+	static const char letters[] = "abcdefghijklmnopqrstuvwxyz0123456789_-";
+	MessageView view;
+
+	for ( int i = 0; i < count; i++ ) {
+		Message msg = randomMessage(rng, MessageType(rng() % 6));
+		msg.key = randomBytes(rng, 0, 20);
+		msg.value = randomBytes(rng, 0, 20);
+		for ( char &c : msg.key ) {
+			c = letters[(unsigned char)c % (sizeof(letters) - 1)];
+		}
+		for ( char &c : msg.value ) {
+			c = letters[(unsigned char)c % (sizeof(letters) - 1)];
+		}
+		string data = msg.toString();
+
+		CHECK(view.parse(data.data(), data.size()));
+		checkFields(view, msg);
+		if ( CREATE == msg.type || UPDATE == msg.type ) {
+			// The replica type appended by a multicast, or left empty
+			string bare = msg.toString(false);
+			CHECK(bare + to_string(msg.replica) == data);
+			CHECK(view.parse(bare.data(), bare.size()));
+			CHECK(view.expiry == msg.expiry && PRIMARY == view.replica);
+		}
+		else {
+			CHECK(view.expiry == 0 && PRIMARY == view.replica);
+		}
+	}
+
+	// An expiry followed by an empty replica type keeps the default
+	const char *given = "7::1:0::0::key::value::12::1";
+	const char *empty = "7::1:0::0::key::value::12::";
+	CHECK(view.parse(given, strlen(given)) && SECONDARY == view.replica);
+	CHECK(view.parse(empty, strlen(empty)));
+	CHECK(view.key == "key" && view.value == "value" && view.expiry == 12 && PRIMARY == view.replica);
+
+	const char *bad[] = {"", "7", "7::1:0::0", "x::1:0::1::key", "7::10::1::key", "7::1:0::9::key",
+			"7::1:0::0::key::value::3", "7::1:0::2::key::value::12::-1"};
+	for ( const char *data : bad ) {
+		CHECK(!view.parse(data, strlen(data)));
+	}
+}
+
+int main(int argc, char *argv[]) {
+	unsigned int seed = testSeed(argc, argv);
+	mt19937 rng(seed);
+
+	binary(rng, 20000);
+	text(rng, 20000);
+	printf("MessageTest: ok (seed %u)\n", seed);
+	return 0;
+}
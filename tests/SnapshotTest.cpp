@@ -0,0 +1,148 @@
+/**********************************
+ * FILE NAME: SnapshotTest.cpp
+ *
+ * DESCRIPTION: Checks that snapshots of a ConcurrentHashTable keep seeing the
+ * 				table as it was when they were taken while it changes, that the
+ * 				table is not changed by them, and that they are of one point in
+ * 				time across shards while other threads write
+ **********************************/
+
+#include "ConcurrentHashTable.h"
+#include "tests/TestUtil.h"
+#include <thread>
+#include <atomic>
+
+/*
+ * Checks that view holds exactly the keys and values of model
+ */
+static void checkView(shared_ptr<TableSnapshot> view, map<string, string> &model) {
+	map<string, string> seen;
+	string value;
+
+	view->forEach([&](const string &key, const string &value) {
+		CHECK(seen.find(key) == seen.end());
+		seen[key] = value;
+	});
+	CHECK(seen == model);
+	for ( map<string, string>::iterator it = model.begin(); it != model.end(); it++ ) {
+		CHECK(view->read(it->first, value) && value == it->second);
+	}
+}
+
+/*
+ * Snapshots taken one after the other, each checked against a copy of the model
+ * while the table goes on changing, and dropped in turn so the shards fold
+ */
+static void isolation(mt19937 &rng) {
+	ConcurrentHashTable table;
+	map<string, string> model;
+	deque< pair< shared_ptr<TableSnapshot>, map<string, string> > > views;
+	string value;
+
+	for ( int round = 0; round < 60; round++ ) {
+		runOps(&table, model, rng, 2000, 4000, 64);
+		views.push_back(make_pair(table.openSnapshot(), model));
+		CHECK(views.back().first->pointInTime());
+		// Keys missing from the view are not found even if the table has them
+		CHECK(!views.back().first->read("never there", value));
+		for ( unsigned int i = 0; i < views.size(); i++ ) {
+			checkView(views[i].first, views[i].second);
+		}
+		checkSame(&table, model);
+		// Between one and three views held at once, released oldest first
+		// or all together
+		if ( views.size() > 2 || rng() % 4 == 0 ) {
+			views.pop_front();
+		}
+		if ( rng() % 10 == 0 ) {
+			views.clear();
+		}
+	}
+	views.clear();
+	runOps(&table, model, rng, 2000, 4000, 64);
+	checkSame(&table, model);
+	table.clear();
+	model.clear();
+	checkSame(&table, model);
+}
+
+/*
+ * One writer sets every key, in order, to the number of its round, while others
+ * change keys of their own. In a view of one point in time the rounds read in
+ * key order never go up and span at most two consecutive values.
+ */
+static void pointInTime() {
+	ConcurrentHashTable table;
+	atomic<bool> done(false);
+	vector<thread> others;
+	long views = 0;
+	const int keys = 5000;
+
+	for ( int k = 0; k < keys; k++ ) {
+		CHECK(table.create("key" + to_string(k), "0"));
+	}
+	thread writer([&]() {
+		for ( int round = 1; round <= 50; round++ ) {
+			string value = to_string(round);
+			for ( int k = 0; k < keys; k++ ) {
+				CHECK(table.update("key" + to_string(k), value));
+			}
+		}
+		done = true;
+	});
+	for ( int t = 0; t < 3; t++ ) {
+		others.push_back(thread([&done, &table, t]() {
+			map<string, string> model;
+			mt19937 rng(t);
+			while ( !done ) {
+				// Keys of this thread only, so its model stays exact
+				for ( int i = 0; i < 500; i++ ) {
+					string key = "t" + to_string(t) + ":" + to_string(rng() % 500);
+					string value;
+					bool present = model.find(key) != model.end();
+					CHECK(table.read(key, value) == present);
+					if ( present ) {
+						CHECK(table.deleteKey(key));
+						model.erase(key);
+					}
+					else {
+						CHECK(table.create(key, string(key)));
+						model[key] = key;
+					}
+				}
+			}
+		}));
+	}
+	while ( !done ) {
+		shared_ptr<TableSnapshot> view = table.openSnapshot();
+		string value;
+		long first = -1, last = -1;
+		for ( int k = 0; k < keys; k++ ) {
+			CHECK(view->read("key" + to_string(k), value));
+			long round = atol(value.c_str());
+			if ( first < 0 ) {
+				first = round;
+			}
+			CHECK(round <= last || last < 0);
+			last = round;
+		}
+		CHECK(first - last <= 1);
+		views++;
+	}
+	writer.join();
+	for ( unsigned int t = 0; t < others.size(); t++ ) {
+		others[t].join();
+	}
+	CHECK(views > 0);
+	printf("SnapshotTest: %ld views checked while writing\n", views);
+}
+
+int main(int argc, char *argv[]) {
+	unsigned int seed = testSeed(argc, argv);
+	mt19937 rng(seed);
+
+	isolation(rng);
+	pointInTime();
+	printf("SnapshotTest: ok (seed %u)\n", seed);
+	return 0;
+}
@@ -0,0 +1,141 @@
+/**********************************
+ * FILE NAME: TestUtil.h
+ *
+ * DESCRIPTION: Checks and helpers shared by the test programs
+ **********************************/
+
+#ifndef TESTUTIL_H_
+#define TESTUTIL_H_
+
+#include "stdincludes.h"
+#include "StorageEngine.h"
+#include <random>
+
+/*
+ * Macros
+ */
+// Stops the test with where and what failed
+#define CHECK(cond) do { \
+	if ( !(cond) ) { \
+		fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+		exit(1); \
+	} \
+} while ( 0 )
+
+/*
+ * Seed of the random operations, the first argument if given
+ */
+static inline unsigned int testSeed(int argc, char *argv[]) {
+	return argc > 1 ? (unsigned int)strtoul(argv[1], NULL, 10) : 1;
+}
+
+/*
+ * New empty directory under /tmp
+ */
+static inline string makeTempDir(const char *name) {
+	char path[64];
+	snprintf(path, sizeof(path), "/tmp/%s.XXXXXX", name);
+	CHECK(NULL != mkdtemp(path));
+	return path;
+}
+
+static inline void removeDir(const string &dir) {
+	CHECK(0 == system(("rm -rf " + dir).c_str()));
+}
+
+/*
+ * Between least and most random bytes, zeros included, never empty since an empty
+ * value counts as not found
+ */
+static inline string randomBytes(mt19937 &rng, int least, int most) {
+	string bytes(max(1, least + (int)(rng() % (most - least + 1))), '\0');
+	for ( unsigned int i = 0; i < bytes.size(); i++ ) {
+		bytes[i] = (char)rng();
+	}
+	return bytes;
+}
+
+/*
+ * Applies ops random creates, reads, updates and deletes of keys out of keys
+ * to table and to model, checking that table answers as model does. Creates
+ * and updates at a random tick take the first bytes of a value for its expiry.
+ */
+static inline void runOps(StorageEngine *table, map<string, string> &model, mt19937 &rng, int ops, int keys, int maxValue) {
+	string value;
+	bool expired;
+
+	for ( int i = 0; i < ops; i++ ) {
+		string key = "key" + to_string(rng() % keys);
+		map<string, string>::iterator it = model.find(key);
+		bool present = it != model.end();
+		int now = (int)rng();
+		bool due = present && StorageEngine::expiredAt(it->second, now);
+		switch ( rng() % 6 ) {
+			case 0:
+				value = randomBytes(rng, 1, maxValue);
+				if ( !present ) {
+					model[key] = value;
+				}
+				CHECK(table->create(key, string(value)) == !present);
+				break;
+			case 1:
+				CHECK(table->read(key, value) == present);
+				CHECK(!present || value == it->second);
+				break;
+			case 2:
+				value = randomBytes(rng, 1, maxValue);
+				CHECK(table->update(key, value) == present);
+				if ( present ) {
+					it->second = value;
+				}
+				break;
+			case 3:
+				CHECK(table->deleteKey(key) == present);
+				if ( present ) {
+					model.erase(it);
+				}
+				break;
+			case 4:
+				value = randomBytes(rng, 1, maxValue);
+				CHECK(table->createAt(key, string(value), now, expired) == (!present || due));
+				CHECK(expired == due);
+				if ( !present || due ) {
+					model[key] = value;
+				}
+				break;
+			case 5:
+				value = randomBytes(rng, 1, maxValue);
+				CHECK(table->updateAt(key, value, now, expired) == (present && !due));
+				CHECK(expired == due);
+				if ( due ) {
+					model.erase(it);
+				}
+				else if ( present ) {
+					it->second = value;
+				}
+				break;
+		}
+	}
+}
+
+/*
+ * Checks that table holds exactly the keys and values of model
+ */
+static inline void checkSame(StorageEngine *table, map<string, string> &model) {
+	map<string, string> seen;
+	string value;
+
+	CHECK(table->currentSize() == model.size());
+	CHECK(table->isEmpty() == model.empty());
+	table->forEach([&](const string &key, const string &value) {
+		CHECK(seen.find(key) == seen.end());
+		seen[key] = value;
+	});
+	CHECK(seen == model);
+	for ( map<string, string>::iterator it = model.begin(); it != model.end(); it++ ) {
+		CHECK(table->read(it->first, value) && value == it->second);
+		CHECK(table->count(it->first) == 1);
+	}
+}
+
+#endif /* TESTUTIL_H_ */